@@ -0,0 +1,93 @@
+// Compiler-lifetime allocations: `Arena` against the global heap
+// Usage: ./bench/arena [node count]
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../src/arena.hpp"
+#include "../src/symbol.hpp"
+#include "corpus.hpp"
+#include "harness.hpp"
+
+// Shaped like a future AST node: a kind, a token index and two children
+struct Node {
+	uint32_t kind;
+	uint32_t tokenIndex;
+	Node *left;
+	Node *right;
+};
+
+static void report(const char *name, size_t count, double heapSeconds, double arenaSeconds) {
+	std::printf("%-26s heap %7.2f ns  arena %7.2f ns  (%.1fx)\n", name, heapSeconds * 1e9 / count, arenaSeconds * 1e9 / count, heapSeconds / arenaSeconds);
+}
+
+int main(int argc, char **argv) {
+	size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+	size_t checksum = 0;
+
+	// Nodes, built then all released
+	{
+		std::vector<Node*> nodes(nodeCount);
+		auto heapSeconds = harness::measure(5, [&](){
+			for (size_t i = 0; i < nodeCount; i++)
+				nodes[i] = new Node{static_cast<uint32_t>(i), 0, i > 0 ? nodes[i - 1] : nullptr, nullptr};
+			checksum += nodes[nodeCount - 1]->kind;
+			for (auto node : nodes)
+				delete node;
+		});
+		auto arena = Arena();
+		auto arenaSeconds = harness::measure(5, [&](){
+			Node *previous = nullptr;
+			for (size_t i = 0; i < nodeCount; i++)
+				previous = arena.create<Node>(static_cast<uint32_t>(i), 0u, previous, nullptr);
+			checksum += previous->kind;
+			arena.reset();
+		});
+		report("node, build and release", nodeCount, heapSeconds, arenaSeconds);
+	}
+
+	// Small child lists, as `std::vector` against `std::pmr::vector` over the arena
+	{
+		size_t listCount = nodeCount / 8;
+		auto heapSeconds = harness::measure(5, [&](){
+			std::vector<std::vector<uint32_t>> lists(listCount);
+			for (size_t i = 0; i < listCount; i++)
+				for (uint32_t j = 0; j < 8; j++)
+					lists[i].push_back(j);
+			checksum += lists.back().back();
+		});
+		auto arena = Arena();
+		auto arenaSeconds = harness::measure(5, [&](){
+			{
+				std::pmr::vector<std::pmr::vector<uint32_t>> lists(listCount, arena.getResource());
+				for (size_t i = 0; i < listCount; i++)
+					for (uint32_t j = 0; j < 8; j++)
+						lists[i].push_back(j);
+				checksum += lists.back().back();
+			}
+			arena.reset();
+		});
+		report("8-element list", listCount, heapSeconds, arenaSeconds);
+	}
+
+	// Space overhead of a realistic workload: lexing a source, which interns its identifiers and stores its numeric literals
+	{
+		auto path = std::filesystem::temp_directory_path() / "spp_arena_bench.spp";
+		corpus::writeFile(path, corpus::Generator().generate(corpus::Mix::Mixed, 8 << 20));
+		{
+			auto file = File(path);
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			auto cursor = TokenCursor(file, symbols, numbers);
+			for (auto token : cursor)
+				checksum += token.getPayload();
+			std::printf("lexing 8 MB: %zu symbols, %zu numbers, %zu allocations, %zu bytes requested, %zu bytes reserved in %zu blocks (%.1f%% overhead)\n",
+				symbols.size(), numbers.size(), arena.getAllocationCount(), arena.getAllocatedByteCount(), arena.getReservedByteCount(), arena.getBlockCount(),
+				(static_cast<double>(arena.getReservedByteCount()) / arena.getAllocatedByteCount() - 1.0) * 100.0);
+		}
+		std::filesystem::remove(path);
+	}
+
+	std::printf("(checksum %zu)\n", checksum);
+	return 0;
+}
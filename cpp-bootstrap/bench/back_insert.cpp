@@ -0,0 +1,102 @@
+// Back-insertion into arrays: ns per `<<-`, heap allocations and bytes allocated from the heap, over back-insert-heavy programs
+// Usage: ./bench/back_insert [insertions]
+// Built twice by `make bench-build`: `./bench/back_insert` with arrays preallocated to the size counted by the compiler,
+// `./bench/back_insert_grown` with arrays growing like `std::vector` instead
+// Only heap memory is counted: preallocated arrays lie on the array `Stack` of the `Runner`, mapped with `mmap`,
+// so their bytes do not show up, and the two builds compare by time and heap allocations rather than by bytes
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include "corpus.hpp"
+#include "harness.hpp"
+#include "../src/compiler.hpp"
+#include "../src/runner.hpp"
+
+// Every heap allocation of the process goes through here
+static std::atomic<size_t> allocationCount = 0;
+static std::atomic<size_t> allocatedByteCount = 0;
+
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+	if (auto res = std::malloc(size != 0 ? size : 1))
+		return res;
+	throw std::bad_alloc();
+}
+
+// GCC cannot tell that the replaced `operator new` above is backed by `malloc`
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+#pragma GCC diagnostic pop
+
+struct Case {
+	const char *name;
+	// `N` is replaced by the insertion count, the programs print nothing
+	const char *source;
+};
+
+static const Case cases[] = {
+	// A single array, sized by a constant count
+	{"flat", "values <- []integer()\nfor (i in count(N)) {\n\tvalues <<- i\n}\n"},
+	// Sized at runtime by the product of the `count` limits, which are parameters
+	{"grid", "fill <- function(height, width) {\n\tcells <- []integer()\n\tfor (y in count(height)) {\n\t\tfor (x in count(width)) {\n"
+		"\t\t\tcells <<- x + y\n\t\t}\n\t}\n}\nfill(N / 1000, 1000)\n"},
+	// Small arrays, one per iteration of the outer loop, each popped as the iteration ends
+	{"rows", "fill <- function(rowCount, width) {\n\tfor (y in count(rowCount)) {\n\t\trow <- []real()\n\t\tfor (x in count(width)) {\n"
+		"\t\t\trow <<- 0.5\n\t\t}\n\t}\n}\nfill(N / 16, 16)\n"},
+	// Two insertions on one path out of two, the size counts both
+	{"branches", "values <- []integer()\nfor (i in count(N / 2)) {\n\tif (i % 2 = 0)\n\t\tvalues <<- i <<- i\n\telse\n\t\tvalues <<- 0\n}\n"}
+};
+
+static constexpr size_t repetitionCount = 3;
+
+int main(int argc, char **argv) {
+	try {
+		uint64_t insertionCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+#ifdef SPP_GROWN_ARRAYS
+		auto arrayKind = "grown";
+#else
+		auto arrayKind = "preallocated";
+#endif
+		std::printf("%llu insertions, best of %zu, %s arrays\n", static_cast<unsigned long long>(insertionCount), repetitionCount, arrayKind);
+		std::printf("%-10s %12s %10s %10s %12s %12s\n", "program", "insertions", "ms", "ns/insert", "allocations", "heap MB");
+		for (auto &benchCase : cases) {
+			auto source = std::string(benchCase.source);
+			source.replace(source.find('N'), 1, std::to_string(insertionCount));
+			auto path = std::filesystem::temp_directory_path() / "spp_back_insert.spp";
+			corpus::writeFile(path, source);
+			auto compiler = Compiler();
+			auto program = compiler.build(path);
+			std::filesystem::remove(path);
+
+			Profile profile;
+			Runner().profile(program, profile);
+			auto insertions = profile.opcodeCounts[static_cast<size_t>(Opcode::BackInsert)];
+			size_t allocations = 0;
+			size_t allocatedBytes = 0;
+			auto bestSeconds = harness::measure(repetitionCount, [&](){
+				auto allocationsBefore = allocationCount.load();
+				auto bytesBefore = allocatedByteCount.load();
+				Runner().run(program, {});
+				allocations = allocationCount.load() - allocationsBefore;
+				allocatedBytes = allocatedByteCount.load() - bytesBefore;
+			});
+			std::printf("%-10s %12llu %10.1f %10.3f %12zu %12.1f\n", benchCase.name, static_cast<unsigned long long>(insertions),
+				bestSeconds * 1000.0, bestSeconds * 1e9 / static_cast<double>(insertions), allocations, allocatedBytes / 1e6);
+		}
+		return 0;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "FATAL ERROR: %s\n", error.what());
+		return 1;
+	}
+}
@@ -0,0 +1,461 @@
+#pragma once
+
+// Synthetic S++ sources for lexer benchmarks
+// Every mix lexes without error, and a given seed always generates the same bytes
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "../src/token.hpp"
+
+namespace corpus {
+	enum class Mix {
+		Identifiers,
+		Operators,
+		Comments,
+		Strings,
+		Nesting,
+		Mixed
+	};
+
+	static constexpr std::array allMixes = {
+		Mix::Identifiers, Mix::Operators, Mix::Comments, Mix::Strings, Mix::Nesting, Mix::Mixed
+	};
+
+	inline const char* getMixName(Mix mix) {
+		switch (mix) {
+		case Mix::Identifiers:
+			return "identifiers";
+		case Mix::Operators:
+			return "operators";
+		case Mix::Comments:
+			return "comments";
+		case Mix::Strings:
+			return "strings";
+		case Mix::Nesting:
+			return "nesting";
+		case Mix::Mixed:
+			return "mixed";
+		}
+		return "?";
+	}
+
+	inline Mix getMixByName(std::string_view name) {
+		for (auto mix : allMixes)
+			if (name == getMixName(mix))
+				return mix;
+		std::string message = "Unknown corpus mix '";
+		message += name;
+		message += "', expected identifiers, operators, comments, strings, nesting or mixed";
+		throw std::runtime_error(message);
+	}
+
+	class Generator {
+		static constexpr size_t vocabularySize = 4096;
+
+		std::mt19937_64 m_random;
+		std::string m_res;
+		// Sources reuse a limited set of names, a few of them very often
+		std::vector<std::string> m_vocabulary;
+
+		size_t pick(size_t count) {
+			return m_random() % count;
+		}
+
+		std::string generateName(void) {
+			static constexpr std::string_view firstCharacters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+			static constexpr std::string_view characters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+			// Mostly short names, with a long tail
+			size_t size = pick(4) == 0 ? 8 + pick(24) : 1 + pick(8);
+			std::string res(1, firstCharacters[pick(firstCharacters.size())]);
+			for (size_t i = 1; i < size; i++)
+				res += characters[pick(characters.size())];
+			return res;
+		}
+
+		void appendIdentifier(void) {
+			if (pick(8) == 0) {
+				m_res += Symbols::keywords[pick(Symbols::keywords.size())];
+				return;
+			}
+			// Squaring skews picks towards the first names
+			auto index = pick(vocabularySize);
+			m_res += m_vocabulary[index * index / vocabularySize];
+		}
+
+		void appendNumber(void) {
+			m_res += std::to_string(m_random() >> pick(64));
+		}
+
+		// Never a keyword, for sources which must parse
+		void appendName(void) {
+			while (true) {
+				auto index = pick(vocabularySize);
+				auto &name = m_vocabulary[index * index / vocabularySize];
+				if (std::find(Symbols::keywords.begin(), Symbols::keywords.end(), name) != Symbols::keywords.end())
+					continue;
+				m_res += name;
+				return;
+			}
+		}
+
+		// Every level of precedence, with operators spaced so that no two of them merge
+		void appendExpression(size_t depth) {
+			static constexpr std::array<std::string_view, 16> binaryOperators = {
+				"*", "/", "%", "+", "-", "<<", ">>", "|", "^", "&", "and", "or", "xor", "+", "-", "*"
+			};
+			static constexpr std::array<std::string_view, 6> comparisonOperators = {
+				"=", "=/=", ">", "<", ">_", "_<"
+			};
+			static constexpr std::array<std::string_view, 4> prefixOperators = {
+				"- ", "! ", "~ ", "not "
+			};
+			switch (pick(depth >= 3 ? 2 : 12)) {
+			case 0:
+				appendName();
+				break;
+			case 1:
+				appendNumber();
+				break;
+			case 2:
+				m_res += '"';
+				appendWords(1 + pick(4));
+				m_res += '"';
+				break;
+			case 3:
+			case 4:
+				appendExpression(depth + 1);
+				m_res += ' ';
+				m_res += binaryOperators[pick(binaryOperators.size())];
+				m_res += ' ';
+				appendExpression(depth + 1);
+				break;
+			case 5:
+				// Chained comparison
+				appendExpression(depth + 1);
+				for (size_t count = 1 + pick(2); count > 0; count--) {
+					m_res += ' ';
+					m_res += comparisonOperators[pick(comparisonOperators.size())];
+					m_res += ' ';
+					appendExpression(depth + 1);
+				}
+				break;
+			case 6:
+				appendName();
+				m_res += '(';
+				for (size_t i = 0, count = pick(4); i < count; i++) {
+					if (i > 0)
+						m_res += ", ";
+					appendExpression(depth + 1);
+				}
+				m_res += ')';
+				break;
+			case 7:
+				m_res += prefixOperators[pick(prefixOperators.size())];
+				appendExpression(depth + 1);
+				break;
+			case 8:
+				appendName();
+				m_res += '.';
+				appendName();
+				m_res += '[';
+				appendExpression(depth + 1);
+				m_res += ']';
+				break;
+			case 9:
+				m_res += "(if ";
+				appendExpression(depth + 1);
+				m_res += " then ";
+				appendExpression(depth + 1);
+				m_res += " else ";
+				appendExpression(depth + 1);
+				m_res += ')';
+				break;
+			case 10:
+				appendName();
+				m_res += pick(2) == 0 ? "++" : "--";
+				break;
+			default:
+				m_res += '(';
+				appendExpression(depth + 1);
+				m_res += ')';
+				break;
+			}
+		}
+
+		// Separated by spaces, so that no two operators merge nor form a comment
+		void appendOperator(void) {
+			m_res += Tokens::allOperators[pick(Tokens::allOperators.size())].getString();
+		}
+
+		void appendWords(size_t count) {
+			static constexpr std::array<std::string_view, 12> words = {
+				"the", "accumulator", "is", "reset", "before", "each", "pass", "over", "input", "values", "and", "sequence"
+			};
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0)
+					m_res += ' ';
+				m_res += words[pick(words.size())];
+			}
+		}
+
+		void appendIndentation(size_t depth) {
+			m_res.append(depth, '\t');
+		}
+
+		void appendIdentifiersLine(void) {
+			appendIdentifier();
+			m_res += " <- ";
+			size_t count = 1 + pick(6);
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0)
+					m_res += pick(2) == 0 ? " " : ", ";
+				appendIdentifier();
+			}
+			m_res += '\n';
+		}
+
+		void appendOperatorsLine(void) {
+			size_t count = 8 + pick(16);
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0)
+					m_res += ' ';
+				appendOperator();
+			}
+			m_res += '\n';
+		}
+
+		void appendCommentsLine(void) {
+			switch (pick(4)) {
+			case 0:
+				m_res += "/*\n";
+				for (size_t lineCount = 1 + pick(6); lineCount > 0; lineCount--) {
+					m_res += '\t';
+					appendWords(4 + pick(12));
+					m_res += '\n';
+				}
+				m_res += "*/\n";
+				break;
+			case 1:
+				appendIdentifier();
+				m_res += " <- ";
+				appendNumber();
+				m_res += "\t// ";
+				appendWords(3 + pick(8));
+				m_res += '\n';
+				break;
+			default:
+				m_res += "// ";
+				appendWords(4 + pick(16));
+				m_res += '\n';
+				break;
+			}
+		}
+
+		void appendStringsLine(void) {
+			appendIdentifier();
+			m_res += " <- \"";
+			for (size_t size = 16 + pick(pick(4) == 0 ? 4096 : 256); size > 0; size--) {
+				// Printable ASCII without the delimiter, with occasional linefeeds
+				auto byte = static_cast<char>(' ' + pick(95));
+				m_res += byte == '"' ? '\n' : byte;
+			}
+			m_res += "\"\n";
+		}
+
+		void appendNestingBlock(size_t depth) {
+			appendIndentation(depth);
+			if (depth < 24 && pick(3) != 0) {
+				m_res += "for (";
+				appendIdentifier();
+				m_res += " in ";
+				size_t callDepth = 1 + pick(12);
+				for (size_t i = 0; i < callDepth; i++) {
+					appendIdentifier();
+					m_res += pick(4) == 0 ? "[" : "(";
+				}
+				appendNumber();
+				for (size_t i = 0; i < callDepth; i++)
+					m_res += ')';
+				m_res += ") {\n";
+				for (size_t blockCount = 1 + pick(3); blockCount > 0; blockCount--)
+					appendNestingBlock(depth + 1);
+				appendIndentation(depth);
+				m_res += "}\n";
+			} else {
+				appendIdentifier();
+				m_res += " <- (";
+				appendIdentifier();
+				m_res += " + (";
+				appendNumber();
+				m_res += " * ";
+				appendIdentifier();
+				m_res += "))\n";
+			}
+		}
+
+		void appendBody(size_t depth) {
+			m_res += " {\n";
+			for (size_t count = 1 + pick(4); count > 0; count--)
+				appendStatement(depth + 1);
+			appendIndentation(depth);
+			m_res += "}\n";
+		}
+
+		// Statements that parse, nested up to `depth`
+		void appendStatement(size_t depth) {
+			static constexpr std::array<std::string_view, 6> compoundOperators = {
+				" + <- ", " - <- ", " * <- ", " << <- ", " | <- ", " <- "
+			};
+			appendIndentation(depth);
+			switch (pick(depth >= 4 ? 4 : 9)) {
+			case 0:
+				appendName();
+				m_res += " <- ";
+				appendExpression(0);
+				m_res += '\n';
+				break;
+			case 1:
+				appendName();
+				m_res += compoundOperators[pick(compoundOperators.size())];
+				appendExpression(0);
+				m_res += '\n';
+				break;
+			case 2:
+				m_res += "std_out <<- \"";
+				appendWords(1 + pick(4));
+				m_res += " = \" <<- ";
+				appendExpression(1);
+				m_res += " <<- end_line\n";
+				break;
+			case 3:
+				m_res += "// ";
+				appendWords(2 + pick(8));
+				m_res += '\n';
+				break;
+			case 4:
+			case 5:
+				m_res += "for (";
+				appendName();
+				m_res += " in count(";
+				appendExpression(2);
+				m_res += "))";
+				appendBody(depth);
+				break;
+			case 6:
+				m_res += pick(2) == 0 ? "while (" : "if (";
+				appendExpression(1);
+				m_res += ')';
+				appendBody(depth);
+				break;
+			case 7:
+				m_res += "if (";
+				appendExpression(1);
+				m_res += ") {\n";
+				appendStatement(depth + 1);
+				appendIndentation(depth);
+				m_res += "} else";
+				appendBody(depth);
+				break;
+			default:
+				appendName();
+				m_res += " <- function(";
+				appendName();
+				m_res += ", ";
+				appendName();
+				m_res += ": ";
+				appendName();
+				m_res += ')';
+				appendBody(depth);
+				break;
+			}
+		}
+
+		// Looks like `test/counter.spp`
+		void appendMixedBlock(void) {
+			switch (pick(6)) {
+			case 0:
+				appendCommentsLine();
+				break;
+			case 1:
+				m_res += "std_out <<- \"";
+				appendWords(1 + pick(6));
+				m_res += " = \" <<- ";
+				appendIdentifier();
+				m_res += " <<- end_line\n";
+				break;
+			case 2:
+				appendNestingBlock(0);
+				break;
+			default:
+				appendIdentifier();
+				m_res += pick(3) == 0 ? " + <- " : " <- ";
+				appendIdentifier();
+				m_res += ' ';
+				appendOperator();
+				m_res += ' ';
+				appendNumber();
+				m_res += '\n';
+				break;
+			}
+		}
+
+	public:
+		Generator(uint64_t seed = 0x5EED) :
+			m_random(seed) {
+			for (size_t i = 0; i < vocabularySize; i++)
+				m_vocabulary.emplace_back(generateName());
+		}
+
+		// At least `byteCount` bytes of statements which parse, for parser benchmarks
+		std::string generateProgram(size_t byteCount) {
+			m_res.clear();
+			m_res.reserve(byteCount + 8192);
+			while (m_res.size() < byteCount)
+				appendStatement(0);
+			return std::move(m_res);
+		}
+
+		// At least `byteCount` bytes of `mix`, ending on a complete line
+		std::string generate(Mix mix, size_t byteCount) {
+			m_res.clear();
+			m_res.reserve(byteCount + 8192);
+			while (m_res.size() < byteCount) {
+				switch (mix) {
+				case Mix::Identifiers:
+					appendIdentifiersLine();
+					break;
+				case Mix::Operators:
+					appendOperatorsLine();
+					break;
+				case Mix::Comments:
+					appendCommentsLine();
+					break;
+				case Mix::Strings:
+					appendStringsLine();
+					break;
+				case Mix::Nesting:
+					appendNestingBlock(0);
+					break;
+				case Mix::Mixed:
+					appendMixedBlock();
+					break;
+				}
+			}
+			return std::move(m_res);
+		}
+	};
+
+	inline void writeFile(const std::filesystem::path &path, std::string_view contents) {
+		auto file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			throw std::runtime_error("Cannot create corpus file " + path.string());
+		std::fwrite(contents.data(), 1, contents.size(), file);
+		std::fclose(file);
+	}
+}
@@ -0,0 +1,83 @@
+// Compares source loading through `File` against the former ifstream/stringstream path
+// Usage: ./bench/file_load [path/to/source.spp]
+// Without a path, a 100 MB source is generated in the temporary directory
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "../src/token.hpp"
+
+static std::string legacyReadFileBytes(const std::filesystem::path &filePath) {
+	std::ifstream inputFile(filePath, std::ios::in | std::ios::binary);
+	std::stringstream res;
+	res << inputFile.rdbuf();
+	return res.str();
+}
+
+// Touch every byte so that lazily mapped pages are accounted for
+static size_t countLinefeeds(std::string_view bytes) {
+	size_t res = 0;
+	for (auto c : bytes)
+		res += c == '\n';
+	return res;
+}
+
+static void generateSource(const std::filesystem::path &path, size_t byteCount) {
+	static const char line[] = "\tinc <- i * acc\t// accumulate\n\tstd_out <<- \"i = \" <<- i <<- end_line\n";
+	auto file = std::fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		throw std::runtime_error("Cannot create benchmark source");
+	for (size_t written = 0; written < byteCount; written += sizeof(line) - 1)
+		std::fwrite(line, 1, sizeof(line) - 1, file);
+	std::fclose(file);
+}
+
+// Runs `load` in a child process so that its peak RSS is measured in isolation
+static void measure(const char *name, const std::function<size_t(void)> &load) {
+	std::fflush(stdout);
+	auto pid = fork();
+	if (pid < 0)
+		throw std::runtime_error("fork failed");
+	if (pid == 0) {
+		auto begin = std::chrono::steady_clock::now();
+		auto linefeeds = load();
+		auto end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - begin).count();
+		std::printf("%-10s %10.2f ms  (%zu lines)", name, seconds * 1000.0, linefeeds);
+		std::fflush(stdout);
+		std::_Exit(0);
+	}
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	std::printf("  peak RSS %8.1f MB\n", usage.ru_maxrss / 1024.0);
+}
+
+int main(int argc, char **argv) {
+	std::filesystem::path path;
+	bool isGenerated = argc < 2;
+	if (isGenerated) {
+		path = std::filesystem::temp_directory_path() / "spp_file_load_bench.spp";
+		generateSource(path, 100 << 20);
+	} else
+		path = argv[1];
+	std::printf("%s: %.1f MB\n", path.c_str(), std::filesystem::file_size(path) / (1024.0 * 1024.0));
+
+	measure("stream", [&](){
+		auto bytes = legacyReadFileBytes(path);
+		return countLinefeeds(bytes);
+	});
+	measure("File", [&](){
+		auto file = File(path);
+		return countLinefeeds(file.getBytes());
+	});
+
+	if (isGenerated)
+		std::filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,22 @@
+// Writes a synthetic S++ source, see `corpus.hpp`
+// Usage: ./bench/gen_corpus <identifiers|operators|comments|strings|nesting|mixed> <megabytes> <output.spp> [seed]
+#include <cstdio>
+#include <cstdlib>
+#include "corpus.hpp"
+
+int main(int argc, char **argv) {
+	if (argc < 4 || argc > 5) {
+		std::fprintf(stderr, "Usage: %s <identifiers|operators|comments|strings|nesting|mixed> <megabytes> <output.spp> [seed]\n", argv[0]);
+		return 1;
+	}
+	try {
+		auto mix = corpus::getMixByName(argv[1]);
+		size_t byteCount = std::strtoull(argv[2], nullptr, 10) << 20;
+		auto generator = corpus::Generator(argc > 4 ? std::strtoull(argv[4], nullptr, 0) : 0x5EED);
+		corpus::writeFile(argv[3], generator.generate(mix, byteCount));
+		return 0;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "FATAL ERROR: %s\n", error.what());
+		return 1;
+	}
+}
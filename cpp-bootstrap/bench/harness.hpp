@@ -0,0 +1,54 @@
+#pragma once
+
+// Helpers shared by the benchmarks: best-of-N timing and capture of the standard output
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <unistd.h>
+
+namespace harness {
+	// Best time of `repetitionCount` runs of `function`, in seconds
+	template <typename Function>
+	double measure(size_t repetitionCount, Function &&function) {
+		double res = 0.0;
+		for (size_t i = 0; i < repetitionCount; i++) {
+			auto begin = std::chrono::steady_clock::now();
+			function();
+			auto end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - begin).count();
+			if (i == 0 || seconds < res)
+				res = seconds;
+		}
+		return res;
+	}
+
+	// Runs `function` with the standard output captured, returns what was printed
+	template <typename Function>
+	std::string capture(Function &&function) {
+		std::fflush(stdout);
+		auto captureFile = std::tmpfile();
+		auto savedStdout = dup(STDOUT_FILENO);
+		dup2(fileno(captureFile), STDOUT_FILENO);
+		try {
+			function();
+		} catch (...) {
+			std::fflush(stdout);
+			dup2(savedStdout, STDOUT_FILENO);
+			close(savedStdout);
+			std::fclose(captureFile);
+			throw;
+		}
+		std::fflush(stdout);
+		dup2(savedStdout, STDOUT_FILENO);
+		close(savedStdout);
+
+		std::string res;
+		std::rewind(captureFile);
+		char buffer[4096];
+		size_t readSize;
+		while ((readSize = std::fread(buffer, 1, sizeof(buffer), captureFile)) > 0)
+			res.append(buffer, readSize);
+		std::fclose(captureFile);
+		return res;
+	}
+}
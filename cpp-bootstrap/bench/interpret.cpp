@@ -0,0 +1,131 @@
+// Interpreter loop: ns per executed bytecode instruction over small loop programs
+// Usage: ./bench/interpret [iterations]
+// Built three times by `make bench-build`: `./bench/interpret` with the default dispatch, `./bench/interpret_switch` with the `switch` one,
+// `./bench/interpret_bounds_checked` with every array element access checked, even those proven within bounds
+// Exits with a non-zero status if any program prints something unexpected
+// Ends with the most executed pairs of opcodes over all programs, candidates for superinstructions
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include "corpus.hpp"
+#include "harness.hpp"
+#include "../src/compiler.hpp"
+#include "../src/runner.hpp"
+
+struct Case {
+	const char *name;
+	// `N` is replaced by the iteration count
+	const char *source;
+	std::function<std::string(uint64_t)> expected;
+};
+
+static std::string toString(double value) {
+	char buffer[32];
+	auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+	return std::string(buffer, end - buffer);
+}
+
+static const Case cases[] = {
+	{"accumulate", "acc <- 0\nx <- 3\nfor (i in count(N)) {\n\tacc + <- i * x\n}\nstd_out <<- acc <<- end_line\n",
+		[](uint64_t n){ return std::to_string(3 * (n * (n - 1) / 2)) + "\n"; }},
+	{"while", "i <- 0\nwhile (i < N) {\n\ti + <- 1\n}\nstd_out <<- i <<- end_line\n",
+		[](uint64_t n){ return std::to_string(n) + "\n"; }},
+	{"branches", "acc <- 0\nfor (i in count(N)) {\n\tif (i % 3 = 0)\n\t\tacc + <- 2\n\telse\n\t\tacc - <- 1\n}\nstd_out <<- acc <<- end_line\n",
+		[](uint64_t n){
+			auto multipleCount = static_cast<int64_t>((n + 2) / 3);
+			return std::to_string(2 * multipleCount - (static_cast<int64_t>(n) - multipleCount)) + "\n";
+		}},
+	{"reals", "x <- 0.5\nfor (i in count(N)) {\n\tx <- x * 0.5 + 1.5\n}\nstd_out <<- x <<- end_line\n",
+		[](uint64_t n){
+			double x = 0.5;
+			for (uint64_t i = 0; i < n; i++)
+				x = x * 0.5 + 1.5;
+			return toString(x) + "\n";
+		}},
+	{"calls", "next <- function(a) {\n\treturn a + 1\n}\nacc <- 0\nfor (i in count(N)) {\n\tacc <- next(acc)\n}\nstd_out <<- acc <<- end_line\n",
+		[](uint64_t n){ return std::to_string(n) + "\n"; }},
+	// Every pass reads and increments each element, the outer loop runs `N / 10000` times
+	{"arrays", "values <- []integer()\nfor (i in count(10000)) {\n\tvalues <<- i\n}\nacc <- 0\nfor (pass in count(N / 10000)) {\n"
+		"\tfor (i in count(10000)) {\n\t\tacc + <- values[i]\n\t\tvalues[i] + <- 1\n\t}\n}\nstd_out <<- acc <<- end_line\n",
+		[](uint64_t n){
+			auto passCount = n / 10000;
+			return std::to_string(passCount * 49995000 + 10000 * (passCount * (passCount - 1) / 2)) + "\n";
+		}}
+};
+
+static constexpr size_t repetitionCount = 3;
+static constexpr size_t printedPairCount = 10;
+
+int main(int argc, char **argv) {
+	try {
+		uint64_t iterationCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+		bool isPassing = true;
+		// Over all programs
+		Profile totalProfile;
+		std::printf("%llu iterations, best of %zu, %s dispatch\n", static_cast<unsigned long long>(iterationCount), repetitionCount, Runner::getDispatchName());
+		std::printf("%-12s %12s %14s %10s %10s %12s\n", "program", "instructions", "per iteration", "ms", "ns/op", "Minstr/s");
+		for (auto &benchCase : cases) {
+			auto source = std::string(benchCase.source);
+			source.replace(source.find('N'), 1, std::to_string(iterationCount));
+			auto path = std::filesystem::temp_directory_path() / "spp_interpret.spp";
+			corpus::writeFile(path, source);
+			auto compiler = Compiler();
+			auto program = compiler.build(path);
+			std::filesystem::remove(path);
+
+			auto expected = benchCase.expected(iterationCount);
+			Profile profile;
+			auto printed = harness::capture([&](){
+				Runner().profile(program, profile);
+			});
+			double bestSeconds = 0.0;
+			auto timedPrinted = harness::capture([&](){
+				bestSeconds = harness::measure(repetitionCount, [&](){
+					Runner().run(program, {});
+				});
+			});
+			// Every timed run prints the same as the profiled one
+			std::string repeated;
+			for (size_t i = 0; i < repetitionCount; i++)
+				repeated += printed;
+			if (timedPrinted != repeated)
+				printed = "not deterministic: " + timedPrinted;
+			if (printed != expected) {
+				std::printf("MISMATCH %s\n  expected %s  got      %s", benchCase.name, expected.c_str(), printed.c_str());
+				isPassing = false;
+			}
+
+			for (size_t i = 0; i < opcodeInfos.size(); i++)
+				for (size_t j = 0; j < opcodeInfos.size(); j++)
+					totalProfile.pairCounts[i][j] += profile.pairCounts[i][j];
+
+			auto instructionCount = profile.getInstructionCount();
+			std::printf("%-12s %12llu %14.2f %10.1f %10.3f %12.1f\n", benchCase.name, static_cast<unsigned long long>(instructionCount),
+				static_cast<double>(instructionCount) / iterationCount, bestSeconds * 1000.0,
+				bestSeconds * 1e9 / instructionCount, instructionCount / bestSeconds / 1e6);
+		}
+
+		struct Pair {
+			uint64_t count;
+			Opcode first;
+			Opcode second;
+		};
+		std::vector<Pair> pairs;
+		for (size_t i = 0; i < opcodeInfos.size(); i++)
+			for (size_t j = 0; j < opcodeInfos.size(); j++)
+				if (totalProfile.pairCounts[i][j] > 0)
+					pairs.emplace_back(Pair{totalProfile.pairCounts[i][j], static_cast<Opcode>(i), static_cast<Opcode>(j)});
+		std::sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b){
+			return a.count > b.count;
+		});
+		std::printf("\nmost executed pairs\n");
+		for (size_t i = 0; i < std::min(pairs.size(), printedPairCount); i++)
+			std::printf("%14llu  %s, %s\n", static_cast<unsigned long long>(pairs[i].count),
+				getOpcodeInfo(pairs[i].first).name.data(), getOpcodeInfo(pairs[i].second).name.data());
+		return isPassing ? 0 : 1;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "FATAL ERROR: %s\n", error.what());
+		return 1;
+	}
+}
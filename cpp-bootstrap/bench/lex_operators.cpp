@@ -0,0 +1,61 @@
+// Operator recognition: former linear scan over `Tokens::allOperators` against `OperatorTrie`
+// Usage: ./bench/lex_operators [operator count]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "../src/token.hpp"
+
+// Former `getTokenAt` operator lookup, testing every operator and keeping the longest
+static const TokenStub* linearMatch(std::string_view bytes) {
+	const TokenStub *res = nullptr;
+	for (auto &op : Tokens::allOperators) {
+		auto string = op.getString();
+		if (bytes.size() < string.size())
+			continue;
+		bool isMatching = true;
+		for (size_t i = 0; i < string.size(); i++)
+			if (bytes[i] != string[i]) {
+				isMatching = false;
+				break;
+			}
+		if (isMatching && (res == nullptr || string.size() > res->getString().size()))
+			res = &op;
+	}
+	return res;
+}
+
+template <typename Matcher>
+static double run(const char *name, std::string_view source, size_t operatorCount, Matcher &&matcher) {
+	size_t checksum = 0;
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t offset = 0; offset < source.size();) {
+		auto op = matcher(source.substr(offset));
+		auto size = op->getString().size();
+		checksum += size;
+		// Skip separator
+		offset += size + 1;
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - begin).count();
+	std::printf("%-8s %8.2f ns/operator  %8.1f MB/s  (checksum %zu)\n", name, seconds * 1e9 / operatorCount, source.size() / seconds / 1e6, checksum);
+	return seconds;
+}
+
+int main(int argc, char **argv) {
+	size_t operatorCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+	std::mt19937 random(42);
+	std::string source;
+	for (size_t i = 0; i < operatorCount; i++) {
+		source += Tokens::allOperators[random() % Tokens::allOperators.size()].getString();
+		source += ' ';
+	}
+
+	auto linearSeconds = run("linear", source, operatorCount, linearMatch);
+	auto trieSeconds = run("trie", source, operatorCount, [](std::string_view bytes){
+		return Tokens::operatorTrie.match(bytes);
+	});
+	std::printf("speedup  %8.2fx\n", linearSeconds / trieSeconds);
+	return 0;
+}
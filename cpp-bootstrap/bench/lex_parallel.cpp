@@ -0,0 +1,178 @@
+// Parallel lexing: differential check against sequential lexing, then throughput
+// Usage: ./bench/lex_parallel [megabytes]
+// Exits with a non-zero status if any source of the corpus lexes differently
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <functional>
+#include "../src/token.hpp"
+#include "harness.hpp"
+
+struct Outcome {
+	std::vector<TokenClass> classes;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> sizesInFile;
+	std::vector<uint32_t> payloads;
+	std::vector<NumberLiteral> numbers;
+	// Diagnostic printed on failure
+	std::string diagnostic;
+
+	bool operator==(const Outcome&) const = default;
+};
+
+using Lexer = std::function<TokenStream(SymbolTable &symbols, NumberTable &numbers)>;
+
+// Lexing errors are printed to stdout, redirect it to compare them
+static Outcome lex(const Lexer &lexer) {
+	Outcome res;
+	auto printed = harness::capture([&](){
+		try {
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			auto tokens = lexer(symbols, numbers);
+			for (size_t i = 0; i < tokens.size(); i++) {
+				res.classes.push_back(tokens.getClass(i));
+				res.offsets.push_back(tokens.getOffset(i));
+				res.sizesInFile.push_back(tokens.getSizeInFile(i));
+				res.payloads.push_back(tokens.getPayload(i));
+				if (tokens.getClass(i) == TokenClass::NumberLiteral)
+					res.numbers.push_back(numbers[tokens.getPayload(i)]);
+			}
+		} catch (const std::runtime_error &error) {
+			res.diagnostic = error.what();
+		}
+	});
+	res.diagnostic += printed;
+	return res;
+}
+
+static std::filesystem::path writeSource(const std::string &name, const std::string &contents) {
+	auto path = std::filesystem::temp_directory_path() / ("spp_lex_parallel_" + name + ".spp");
+	auto file = std::fopen(path.c_str(), "wb");
+	std::fwrite(contents.data(), 1, contents.size(), file);
+	std::fclose(file);
+	return path;
+}
+
+// Multi-line string literals and comments are what chunk guesses get wrong
+// Pieces are glued together, so that a random source may open comments or literals anywhere
+static std::string generateRandomSource(std::mt19937 &random, size_t pieceCount, bool isTerminated) {
+	static const char *pieces[] = {
+		"acc", "<-", "0 ", " ", "\t", "\n", "\r\n", "<<-", "=/=", "_<", ">_", "...", "(", ")", "{", "}",
+		"i * acc", "\"str\"", "'c'", "// line comment \" /* \n", "/* block\n\ncomment // \" */",
+		"\"multi\nline\n\nstring /* \"", "'single // quoted\n'", "/*/", "/**/", "*/", "\n\n\n", "x_1", "*01 ",
+		"1.5 ", "*5.1 ", "0hff_1x-2 ", "12345678901234567890 "
+	};
+	std::string res;
+	for (size_t i = 0; i < pieceCount; i++)
+		res += pieces[random() % std::size(pieces)];
+	if (!isTerminated)
+		res += random() % 2 == 0 ? "\"\nunterminated\n" : "\n@\n";
+	return res;
+}
+
+// Same kind of source, but pieces are self-delimited and separated so that it always lexes
+static std::string generateValidSource(std::mt19937 &random, size_t pieceCount) {
+	static const char *pieces[] = {
+		"acc", "<-", "0", "\n", "<<-", "=/=", "(", ")", "{", "}", "i * acc", "\"str\"",
+		"// line comment \" /* \n", "/* block\n\ncomment // \" */", "\"multi\nline\n\nstring /* \"", "x_1",
+		"*01", "1.5", "*5.1", "0hff_1"
+	};
+	std::string res;
+	for (size_t i = 0; i < pieceCount; i++) {
+		res += pieces[random() % std::size(pieces)];
+		res += ' ';
+	}
+	return res;
+}
+
+static bool checkCorpus(void) {
+	std::vector<std::pair<std::string, std::string>> corpus = {
+		{"empty", ""},
+		{"no_trailing_linefeed", "a <- b"},
+		{"only_linefeeds", "\n\n\n\n"},
+		{"counter", "acc <- 0\n\n// Sample\nfor (i in count(10)) {\n\tinc <- i * acc\n\t/*\n\t\tmulti\n\t*/\n\tacc + <- inc\n}\n"},
+		{"string_across_lines", "a <- \"\nb <- c\n// not a comment\n/* nor this\n\" d\ne\n"},
+		{"comment_across_lines", "a\n/*\n\"\n'\nb <- c\n*/ d\ne\n"},
+		{"quotes_in_comments", "// \"\na /* ' */ b\n/* \" \n */ c\n"},
+		{"unterminated_comment", "a\nb\n/* c\nd\ne\n"},
+		{"unterminated_string", "a\nb\n\" c\nd\ne\n"},
+		{"illegal_after_string", "a <- \"\n@\n\"\nb @\n"},
+		{"illegal_character", "a\nb\nc @\nd\n"},
+		{"crlf", "a <- b\r\n\tc <- d\r\n"},
+		{"numbers", "a <- *01 + 1.5 * *5.1\nb <- a*2 - a *2 - (*3)\nc <- 0h1f.8x-1 + 0b1_0 + *0o7 + 1x-4_0\n"},
+		{"wide_number", "a <- 115792089237316195423570985008687907853269984665640564039457584007913129639935\nb <- 1x77\n"},
+		{"malformed_number", "a\nb <- 1abc\nc\n"}
+	};
+	std::mt19937 random(1234);
+	for (size_t i = 0; i < 64; i++)
+		corpus.emplace_back("random_" + std::to_string(i), generateRandomSource(random, 50 + random() % 400, i % 8 != 0));
+
+	size_t checkCount = 0;
+	bool isPassing = true;
+	for (auto &[name, contents] : corpus) {
+		auto path = writeSource(name, contents);
+		{
+			auto file = File(path);
+			auto expected = lex([&](SymbolTable &symbols, NumberTable &numbers){
+				return TokenParser::readTokensSequential(file, symbols, numbers);
+			});
+			for (size_t chunkSize : {1, 2, 3, 5, 8, 13, 64, 1024})
+				for (size_t threadCount : {1, 4}) {
+					auto actual = lex([&](SymbolTable &symbols, NumberTable &numbers){
+						return TokenParser::readTokensParallel(file, symbols, numbers, threadCount, chunkSize);
+					});
+					checkCount++;
+					if (!(actual == expected)) {
+						std::printf("MISMATCH %s (chunk size %zu, %zu threads)\n", name.c_str(), chunkSize, threadCount);
+						isPassing = false;
+					}
+				}
+		}
+		std::filesystem::remove(path);
+	}
+	std::printf("differential check: %zu sources, %zu runs, %s\n", corpus.size(), checkCount, isPassing ? "identical" : "FAILED");
+	return isPassing;
+}
+
+template <typename Lexer>
+static double measure(const char *name, const File &file, Lexer &&lexer) {
+	size_t tokenCount = 0;
+	auto best = harness::measure(5, [&](){
+		tokenCount = lexer().size();
+	});
+	std::printf("%-10s %8.1f ms  %8.1f MB/s  (%zu tokens)\n", name, best * 1000.0, file.getByteCount() / best / 1e6, tokenCount);
+	return best;
+}
+
+int main(int argc, char **argv) {
+	if (!checkCorpus())
+		return 1;
+
+	size_t byteCount = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256) << 20;
+	std::mt19937 random(42);
+	std::string contents;
+	while (contents.size() < byteCount)
+		contents += generateValidSource(random, 1000);
+	auto path = writeSource("throughput", contents);
+	{
+		auto file = File(path);
+		auto threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		auto sequentialSeconds = measure("sequential", file, [&](){
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			return TokenParser::readTokensSequential(file, symbols, numbers);
+		});
+		auto parallelSeconds = measure("parallel", file, [&](){
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			return TokenParser::readTokensParallel(file, symbols, numbers, threadCount, file.getByteCount() / (threadCount * 4));
+		});
+		std::printf("%u threads, speedup %.2fx\n", threadCount, sequentialSeconds / parallelSeconds);
+	}
+	std::filesystem::remove(path);
+	return 0;
+}
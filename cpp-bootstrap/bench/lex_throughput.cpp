@@ -0,0 +1,196 @@
+// Lexer throughput over every corpus mix: MB/s, tokens/s, allocations per token and peak RSS
+// Usage: ./bench/lex_throughput [--size megabytes] [--baseline results.txt] [mix...]
+// With `--baseline`, results are written to the file if it does not exist yet, otherwise compared against it
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <map>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "corpus.hpp"
+#include "harness.hpp"
+
+// Every heap allocation of the process goes through here
+static std::atomic<size_t> allocationCount = 0;
+
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (auto res = std::malloc(size != 0 ? size : 1))
+		return res;
+	throw std::bad_alloc();
+}
+
+// GCC cannot tell that the replaced `operator new` above is backed by `malloc`
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+#pragma GCC diagnostic pop
+
+struct Result {
+	double bytesPerSecond;
+	double tokensPerSecond;
+	double allocationsPerToken;
+	double peakRssMegabytes;
+};
+
+static constexpr size_t repetitionCount = 5;
+
+struct Lexer {
+	const char *name;
+	// Returns the token count
+	size_t (*lex)(const File &sourceFile);
+};
+
+static const Lexer lexers[] = {
+	{"readTokens", [](const File &sourceFile) -> size_t {
+		auto arena = Arena();
+		auto symbols = SymbolTable(arena);
+		auto numbers = NumberTable(arena.getResource());
+		return TokenParser::readTokens(sourceFile, symbols, numbers).size();
+	}},
+	{"TokenCursor", [](const File &sourceFile) -> size_t {
+		size_t res = 0;
+		auto arena = Arena();
+		auto symbols = SymbolTable(arena);
+		auto numbers = NumberTable(arena.getResource());
+		auto cursor = TokenCursor(sourceFile, symbols, numbers);
+		for (auto token : cursor)
+			res += token.getSizeInFile() != 0;
+		return res;
+	}}
+};
+
+// Lexes in a child process, so that its peak RSS is measured in isolation
+static Result measure(const std::filesystem::path &path, const Lexer &lexer) {
+	int resultPipe[2];
+	if (pipe(resultPipe) != 0)
+		throw std::runtime_error("pipe failed");
+	std::fflush(stdout);
+	auto pid = fork();
+	if (pid < 0)
+		throw std::runtime_error("fork failed");
+	if (pid == 0) {
+		close(resultPipe[0]);
+		auto file = File(path);
+		Result res {};
+		size_t tokenCount = 0;
+		size_t allocations = 0;
+		auto bestSeconds = harness::measure(repetitionCount, [&](){
+			auto allocationsBefore = allocationCount.load();
+			tokenCount = lexer.lex(file);
+			allocations = allocationCount.load() - allocationsBefore;
+		});
+		res.bytesPerSecond = file.getByteCount() / bestSeconds;
+		res.tokensPerSecond = tokenCount / bestSeconds;
+		res.allocationsPerToken = static_cast<double>(allocations) / std::max<size_t>(tokenCount, 1);
+		[[maybe_unused]] auto written = write(resultPipe[1], &res, sizeof(res));
+		std::_Exit(0);
+	}
+	close(resultPipe[1]);
+	Result res {};
+	auto readSize = read(resultPipe[0], &res, sizeof(res));
+	close(resultPipe[0]);
+	int status;
+	struct rusage usage;
+	wait4(pid, &status, 0, &usage);
+	if (readSize != sizeof(res) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		throw std::runtime_error("Lexing " + path.string() + " failed");
+	res.peakRssMegabytes = usage.ru_maxrss / 1024.0;
+	return res;
+}
+
+using Results = std::map<std::string, Result>;
+
+static Results loadResults(const std::filesystem::path &path) {
+	Results res;
+	auto file = std::fopen(path.c_str(), "r");
+	if (file == nullptr)
+		return res;
+	char key[256];
+	Result result;
+	while (std::fscanf(file, "%255s %lf %lf %lf %lf", key, &result.bytesPerSecond, &result.tokensPerSecond,
+		&result.allocationsPerToken, &result.peakRssMegabytes) == 5)
+		res[key] = result;
+	std::fclose(file);
+	return res;
+}
+
+static void saveResults(const std::filesystem::path &path, const Results &results) {
+	auto file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		throw std::runtime_error("Cannot write " + path.string());
+	for (auto &[key, result] : results)
+		std::fprintf(file, "%s %.17g %.17g %.17g %.17g\n", key.c_str(), result.bytesPerSecond, result.tokensPerSecond,
+			result.allocationsPerToken, result.peakRssMegabytes);
+	std::fclose(file);
+}
+
+// Relative change against the baseline, blank without one
+static std::string formatChange(double value, const Result *baseline, double Result::*field) {
+	if (baseline == nullptr || baseline->*field == 0.0)
+		return "";
+	char res[32];
+	std::snprintf(res, sizeof(res), " (%+.1f%%)", (value / (baseline->*field) - 1.0) * 100.0);
+	return res;
+}
+
+int main(int argc, char **argv) {
+	try {
+		size_t megabyteCount = 8;
+		std::filesystem::path baselinePath;
+		std::vector<corpus::Mix> mixes;
+		for (int i = 1; i < argc; i++) {
+			if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+				megabyteCount = std::strtoull(argv[++i], nullptr, 10);
+			else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+				baselinePath = argv[++i];
+			else
+				mixes.emplace_back(corpus::getMixByName(argv[i]));
+		}
+		if (mixes.empty())
+			mixes.assign(corpus::allMixes.begin(), corpus::allMixes.end());
+
+		auto baseline = baselinePath.empty() ? Results() : loadResults(baselinePath);
+		Results results;
+		std::printf("%zu MB per mix, best of %zu, kernels: %s\n", megabyteCount, repetitionCount, scan::activeKernels->name);
+		std::printf("%-12s %-12s %9s%-11s %10s%-12s %12s%-11s %9s%-11s\n", "mix", "lexer", "MB/s", "", "Mtokens/s", "", "allocs/token", "", "RSS (MB)", "");
+		for (auto mix : mixes) {
+			auto path = std::filesystem::temp_directory_path() / (std::string("spp_lex_throughput_") + corpus::getMixName(mix) + ".spp");
+			corpus::writeFile(path, corpus::Generator().generate(mix, megabyteCount << 20));
+			for (auto &lexer : lexers) {
+				auto result = measure(path, lexer);
+				auto key = std::string(corpus::getMixName(mix)) + "/" + lexer.name;
+				auto found = baseline.find(key);
+				auto baselineResult = found != baseline.end() ? &found->second : nullptr;
+				std::printf("%-12s %-12s %9.1f%-11s %10.2f%-12s %12.3g%-11s %9.1f%-11s\n", corpus::getMixName(mix), lexer.name,
+					result.bytesPerSecond / 1e6, formatChange(result.bytesPerSecond, baselineResult, &Result::bytesPerSecond).c_str(),
+					result.tokensPerSecond / 1e6, formatChange(result.tokensPerSecond, baselineResult, &Result::tokensPerSecond).c_str(),
+					result.allocationsPerToken, formatChange(result.allocationsPerToken, baselineResult, &Result::allocationsPerToken).c_str(),
+					result.peakRssMegabytes, formatChange(result.peakRssMegabytes, baselineResult, &Result::peakRssMegabytes).c_str());
+				results[key] = result;
+			}
+			std::filesystem::remove(path);
+		}
+
+		if (!baselinePath.empty() && baseline.empty()) {
+			saveResults(baselinePath, results);
+			std::printf("Baseline written to %s\n", baselinePath.c_str());
+		}
+		return 0;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "FATAL ERROR: %s\n", error.what());
+		return 1;
+	}
+}
@@ -0,0 +1,84 @@
+// Long references: ns per hop along a list spread over several stacks, resolved through the registry of stacks,
+// against raw pointers and against stack bases found by hashing the stack id
+// Usage: ./bench/long_ref [node count] [stack count]
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+#include "../src/stack.hpp"
+#include "harness.hpp"
+
+// Both links of a node lead to the same next node
+struct Node {
+	uint64_t value;
+	Stack::Ref<Node> next;
+	Node *nextPointer;
+};
+
+static_assert(sizeof(Stack::Ref<Node>) == sizeof(uint64_t));
+
+int main(int argc, char **argv) {
+	size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+	size_t stackCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 8;
+	if (nodeCount == 0 || stackCount == 0) {
+		std::fprintf(stderr, "FATAL ERROR: expected at least a node and a stack\n");
+		return 1;
+	}
+
+	// Node `i` lies on stack `i % stackCount` and links to node `i + 1`
+	std::vector<Stack> stacks;
+	for (size_t i = 0; i < stackCount; i++)
+		stacks.emplace_back(32);
+	std::vector<Node*> nodes(nodeCount);
+	for (size_t i = 0; i < nodeCount; i++)
+		nodes[i] = stacks[i % stackCount].create<Node>(Node{i, {}, nullptr});
+	for (size_t i = 0; i + 1 < nodeCount; i++) {
+		nodes[i]->next = stacks[(i + 1) % stackCount].ref(nodes[i + 1]);
+		nodes[i]->nextPointer = nodes[i + 1];
+	}
+	auto expected = nodeCount * (nodeCount - 1) / 2;
+	bool isCorrect = true;
+
+	uint64_t result = 0;
+	auto pointerSeconds = harness::measure(5, [&](){
+		result = 0;
+		for (auto node = nodes[0]; node != nullptr; node = node->nextPointer)
+			result += node->value;
+	});
+	isCorrect = isCorrect && result == expected;
+
+	auto registrySeconds = harness::measure(5, [&](){
+		result = 0;
+		for (auto node = nodes[0]; ; node = node->next.get()) {
+			result += node->value;
+			if (!node->next)
+				break;
+		}
+	});
+	isCorrect = isCorrect && result == expected;
+
+	std::unordered_map<uint32_t, const char*> bases;
+	for (auto &stack : stacks)
+		bases.emplace(stack.getId(), stack.getBase());
+	auto hashSeconds = harness::measure(5, [&](){
+		result = 0;
+		for (const Node *node = nodes[0]; ; ) {
+			result += node->value;
+			if (!node->next)
+				break;
+			auto bits = node->next.getBits();
+			node = reinterpret_cast<const Node*>(bases.find(node->next.getStackId())->second + (bits & ((uint64_t(1) << Stack::offsetBitCount) - 1)));
+		}
+	});
+	isCorrect = isCorrect && result == expected;
+
+	std::printf("%zu nodes over %zu stacks, best of 5\n", nodeCount, stackCount);
+	std::printf("%-26s %8.2f ns/hop\n", "64-bit pointers", pointerSeconds * 1e9 / nodeCount);
+	std::printf("%-26s %8.2f ns/hop\n", "long refs, registry", registrySeconds * 1e9 / nodeCount);
+	std::printf("%-26s %8.2f ns/hop\n", "long refs, hashed stack id", hashSeconds * 1e9 / nodeCount);
+	if (!isCorrect) {
+		std::fprintf(stderr, "FATAL ERROR: a traversal did not visit every node\n");
+		return 1;
+	}
+	return 0;
+}
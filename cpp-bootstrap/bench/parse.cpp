@@ -0,0 +1,168 @@
+// Parser: grammar checks against expected trees, then throughput over a generated program
+// Usage: ./bench/parse [megabytes]
+// Exits with a non-zero status if any check fails
+#include <cstdio>
+#include <cstdlib>
+#include "corpus.hpp"
+#include "harness.hpp"
+#include "../src/parser.hpp"
+
+struct Case {
+	const char *source;
+	// S-expression of the root block, or a part of the error message
+	const char *expected;
+};
+
+static const Case treeCases[] = {
+	{"a <- b <- c", "(block (<- a (<- b c)))"},
+	{"a + b * c - d", "(block (- (+ a (* b c)) d))"},
+	{"a * -b", "(block (* a (- b)))"},
+	{"- - a", "(block (- (- a)))"},
+	{"!~a", "(block (! (~ a)))"},
+	{"-a.b", "(block (- (. a b)))"},
+	{"a++ + b", "(block (+ (post++ a) b))"},
+	{"a.b(c, d)[e]", "(block ([] (call (. a b) c d) e))"},
+	{"f()", "(block (call f))"},
+	{"a | b << c", "(block (| a (<< b c)))"},
+	{"a + b << c", "(block (<< (+ a b) c))"},
+	{"a < b", "(block (< a b))"},
+	{"a _< x < b", "(block (chain (_< a x) (< x b)))"},
+	{"x <- a _< b =/= c >_ d", "(block (<- x (chain (_< a b) (=/= b c) (>_ c d))))"},
+	{"(a < b) < c", "(block (< (< a b) c))"},
+	{"a = b and c = d", "(block (and (= a b) (= c d)))"},
+	{"a or b and c xor d", "(block (xor (and (or a b) c) d))"},
+	{"not a and b", "(block (not (and a b)))"},
+	{"not a = b", "(block (not (= a b)))"},
+	{"acc + <- i * x", "(block (+<- acc (* i x)))"},
+	{"a - <- b + c", "(block (-<- a (+ b c)))"},
+	{"x << <- 2", "(block (<<<- x 2))"},
+	{"a <- b & <- c", "(block (<- a (&<- b c)))"},
+	{"std_out <<- \"a\" <<- i <<- end_line", "(block (<<- (<<- (<<- std_out \"a\") i) end_line))"},
+	{"x <- y <<- z", "(block (<- x (<<- y z)))"},
+	{"x <- if a then b else c", "(block (<- x (if-then-else a b c)))"},
+	{"x <- if a then b else if c then d else e", "(block (<- x (if-then-else a b (if-then-else c d e))))"},
+	{"x <- if a < b then b + 1 else c", "(block (<- x (if-then-else (< a b) (+ b 1) c)))"},
+	{"if (a) then b else c", "(block (if-then-else a b c))"},
+	{"f(a,\n\tb)", "(block (call f a b))"},
+	{"x <- (a\n+ b)", "(block (<- x (+ a b)))"},
+	{"a; b\n\nc", "(block a b c)"},
+	{"for (i in count(10)) {\n\tacc + <- i\n}", "(block (for i (call count 10) (block (+<- acc i))))"},
+	{"while (x > 0) x - <- 1", "(block (while (> x 0) (-<- x 1)))"},
+	{"if (a) b else c", "(block (if a b c))"},
+	{"if (a) {\n\tb\n}\nelse {\n\tc\n}\nd", "(block (if a (block b) (block c)) d)"},
+	{"if (a)\n\tb\nc", "(block (if a b _) c)"},
+	{"f <- function(a, b: T) {\n\treturn a + b\n}", "(block (<- f (function (a (: b T)) (block (return (+ a b))))))"},
+	{"g(function() {\n\tx\n\ty\n})", "(block (call g (function () (block x y))))"},
+	{"return", "(block (return _))"},
+	{"x <- 0hff + *01 + 1.5", "(block (<- x (+ (+ 0hff *01) 1.5)))"}
+};
+
+static const Case errorCases[] = {
+	{"a b", "expected the end of the statement"},
+	{"(a", "expected ')'"},
+	{"a +", "expected an expression"},
+	{"}", "unmatched '}'"},
+	{"{ a", "expected '}'"},
+	{"x <- for", "expected an expression"},
+	{"x <- if a then b", "expected 'else'"},
+	{"for (1 in a) b", "expected a name"},
+	{"f(a b)", "expected ')'"}
+};
+
+// Parses `source`, the tree or the error along with its printed diagnostic
+static std::string parse(std::string_view source) {
+	auto path = std::filesystem::temp_directory_path() / "spp_parse_case.spp";
+	corpus::writeFile(path, source);
+	std::string res;
+	auto printed = harness::capture([&](){
+		try {
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			auto file = File(path);
+			auto cursor = TokenCursor(file, symbols, numbers);
+			auto ast = Ast(file, arena.getResource());
+			Parser::parse(cursor, ast);
+			res = ast.format(ast.getRoot(), symbols);
+		} catch (const std::runtime_error &error) {
+			res = error.what();
+		}
+	});
+	res += printed;
+	std::filesystem::remove(path);
+	return res;
+}
+
+static bool check(void) {
+	bool isPassing = true;
+	size_t checkCount = 0;
+	for (auto &treeCase : treeCases) {
+		auto tree = parse(treeCase.source);
+		checkCount++;
+		if (tree != treeCase.expected) {
+			std::printf("MISMATCH %s\n  expected %s\n  got      %s\n", treeCase.source, treeCase.expected, tree.c_str());
+			isPassing = false;
+		}
+	}
+	auto deepSource = std::string(4096, '(') + "a" + std::string(4096, ')');
+	std::vector<Case> allErrorCases(std::begin(errorCases), std::end(errorCases));
+	allErrorCases.push_back({deepSource.c_str(), "nested too deeply"});
+	for (auto &errorCase : allErrorCases) {
+		auto diagnostic = parse(errorCase.source);
+		checkCount++;
+		if (diagnostic.find(errorCase.expected) == std::string::npos || diagnostic.find("Parsing failed") == std::string::npos) {
+			std::printf("MISSED ERROR %.40s\n  expected %s\n  got      %s\n", errorCase.source, errorCase.expected, diagnostic.c_str());
+			isPassing = false;
+		}
+	}
+	std::printf("grammar check: %zu sources, %s\n", checkCount, isPassing ? "as expected" : "FAILED");
+	return isPassing;
+}
+
+static constexpr size_t repetitionCount = 5;
+
+int main(int argc, char **argv) {
+	try {
+		size_t megabyteCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+		if (!check())
+			return 1;
+
+		auto path = std::filesystem::temp_directory_path() / "spp_parse_program.spp";
+		corpus::writeFile(path, corpus::Generator().generateProgram(megabyteCount << 20));
+		auto file = File(path);
+
+		size_t tokenCount = 0;
+		auto lexSeconds = harness::measure(repetitionCount, [&](){
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			auto cursor = TokenCursor(file, symbols, numbers);
+			tokenCount = 0;
+			for (auto token : cursor)
+				tokenCount += token.getSizeInFile() != 0;
+		});
+		size_t nodeCount = 0;
+		size_t arenaByteCount = 0;
+		auto parseSeconds = harness::measure(repetitionCount, [&](){
+			auto arena = Arena();
+			auto symbols = SymbolTable(arena);
+			auto numbers = NumberTable(arena.getResource());
+			auto cursor = TokenCursor(file, symbols, numbers);
+			auto ast = Ast(file, arena.getResource());
+			Parser::parse(cursor, ast);
+			nodeCount = ast.size();
+			arenaByteCount = arena.getAllocatedByteCount();
+		});
+		std::filesystem::remove(path);
+
+		std::printf("%zu MB program, best of %zu: %zu tokens, %zu nodes (%.2f per token), %.1f MB allocated in the arena\n",
+			megabyteCount, repetitionCount, tokenCount, nodeCount, static_cast<double>(nodeCount) / tokenCount, arenaByteCount / 1e6);
+		std::printf("%-14s %8.1f ms  %8.1f MB/s\n", "lex", lexSeconds * 1000.0, file.getByteCount() / lexSeconds / 1e6);
+		std::printf("%-14s %8.1f ms  %8.1f MB/s  %6.1f Mnodes/s\n", "lex + parse", parseSeconds * 1000.0,
+			file.getByteCount() / parseSeconds / 1e6, nodeCount / parseSeconds / 1e6);
+		return 0;
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "FATAL ERROR: %s\n", error.what());
+		return 1;
+	}
+}
@@ -0,0 +1,201 @@
+// Linked structures in segments: binary search trees linked by short references against the same trees linked by pointers
+// Usage: ./bench/segment [node count]
+// One tree of every node, in a single 4 GiB segment with 32-bit links or on the heap with 64-bit pointers,
+// then a forest of trees of 8190 nodes, one per 64 KiB segment with 16-bit links or on the heap
+// Nodes are inserted in the same random order on both sides, traversals visit them in key order
+// Memory is what `malloc` reports in use, its chunk headers included, or the bytes of the segments filled
+// Heap nodes are left to the end of the process, so that no tree reuses the chunks of a previous one
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <malloc.h>
+#include "../src/stack.hpp"
+#include "../src/segment.hpp"
+#include "harness.hpp"
+
+struct PointerNode {
+	uint32_t key;
+	PointerNode *left;
+	PointerNode *right;
+
+	PointerNode(uint32_t key) :
+		key(key),
+		left(nullptr),
+		right(nullptr) {
+	}
+};
+
+template <size_t AddressBitCount>
+struct SegmentNode {
+	using Ref = typename Segment<AddressBitCount>::template Ref<SegmentNode>;
+
+	uint32_t key;
+	Ref left;
+	Ref right;
+
+	SegmentNode(uint32_t key) :
+		key(key) {
+	}
+};
+
+static_assert(sizeof(PointerNode) == 24);
+static_assert(sizeof(SegmentNode<32>) == 12);
+static_assert(sizeof(SegmentNode<16>) == 8);
+
+// Nodes of a forest tree, so that its 16-bit segment is filled, the root link taking the room of a node
+static constexpr size_t forestTreeSize = (Segment<16>::size - sizeof(Segment<16>)) / sizeof(SegmentNode<16>) - 1;
+
+// splitmix64
+static uint32_t getKey(uint64_t index) {
+	auto x = index + 0x9E3779B97F4A7C15;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+	return static_cast<uint32_t>(x ^ (x >> 31));
+}
+
+static void insert(PointerNode *&root, uint32_t key) {
+	auto link = &root;
+	while (*link != nullptr)
+		link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+	*link = new PointerNode(key);
+}
+
+// The links live in the segment, so that they resolve by masking
+template <size_t AddressBitCount>
+static bool insert(Segment<AddressBitCount> &segment, typename SegmentNode<AddressBitCount>::Ref *root, uint32_t key) {
+	if (!segment.template canAllocate<SegmentNode<AddressBitCount>>())
+		return false;
+	auto node = segment.template create<SegmentNode<AddressBitCount>>(key);
+	if (!*root) {
+		*root = node;
+		return true;
+	}
+	auto parent = root->get();
+	while (true) {
+		auto &link = key < parent->key ? parent->left : parent->right;
+		if (!link) {
+			link = node;
+			return true;
+		}
+		parent = link.get();
+	}
+}
+
+static uint64_t sum(const PointerNode *node) {
+	if (node == nullptr)
+		return 0;
+	return sum(node->left) + node->key + sum(node->right);
+}
+
+template <size_t AddressBitCount>
+static uint64_t sum(const typename SegmentNode<AddressBitCount>::Ref &ref) {
+	if (!ref)
+		return 0;
+	auto node = ref.get();
+	return sum<AddressBitCount>(node->left) + node->key + sum<AddressBitCount>(node->right);
+}
+
+static size_t getHeapByteCount(void) {
+	return mallinfo2().uordblks;
+}
+
+static void report(const char *name, size_t nodeCount, double buildSeconds, double traversalSeconds, size_t byteCount) {
+	std::printf("%-28s %10.1f %12.1f %9.2f %9.1f %8.1f\n", name, buildSeconds * 1000.0, traversalSeconds * 1000.0,
+		traversalSeconds * 1e9 / nodeCount, byteCount / 1e6, static_cast<double>(byteCount) / nodeCount);
+}
+
+int main(int argc, char **argv) {
+	size_t nodeCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+	size_t treeCount = (nodeCount + forestTreeSize - 1) / forestTreeSize;
+	uint64_t expected = 0;
+	for (size_t i = 0; i < nodeCount; i++)
+		expected += getKey(i);
+	bool isCorrect = true;
+
+	std::printf("%zu nodes, forests of %zu trees of up to %zu nodes, traversals best of 3\n", nodeCount, treeCount, forestTreeSize);
+	std::printf("%-28s %10s %12s %9s %9s %8s\n", "links", "build ms", "traversal ms", "ns/node", "MB", "B/node");
+
+	{
+		auto heapBefore = getHeapByteCount();
+		PointerNode *root = nullptr;
+		auto buildSeconds = harness::measure(1, [&](){
+			for (size_t i = 0; i < nodeCount; i++)
+				insert(root, getKey(i));
+		});
+		auto byteCount = getHeapByteCount() - heapBefore;
+		uint64_t result = 0;
+		auto traversalSeconds = harness::measure(3, [&](){ result = sum(root); });
+		isCorrect = isCorrect && result == expected;
+		report("tree, 64-bit pointers", nodeCount, buildSeconds, traversalSeconds, byteCount);
+	}
+
+	{
+		auto stack = Stack(33, 32);
+		auto segment = Segment<32>::allocate(stack);
+		// The root link is the first node of the segment
+		auto root = segment->get(segment->create<SegmentNode<32>::Ref>());
+		auto buildSeconds = harness::measure(1, [&](){
+			for (size_t i = 0; i < nodeCount; i++)
+				if (!insert(*segment, root, getKey(i))) {
+					std::fprintf(stderr, "FATAL ERROR: %zu nodes do not fit in a 4 GiB segment\n", nodeCount);
+					std::exit(1);
+				}
+		});
+		uint64_t result = 0;
+		auto traversalSeconds = harness::measure(3, [&](){ result = sum<32>(*root); });
+		isCorrect = isCorrect && result == expected;
+		report("tree, 32-bit segment refs", nodeCount, buildSeconds, traversalSeconds, segment->getUsedByteCount());
+	}
+
+	{
+		std::vector<PointerNode*> roots(treeCount, nullptr);
+		auto heapBefore = getHeapByteCount();
+		auto buildSeconds = harness::measure(1, [&](){
+			for (size_t i = 0; i < nodeCount; i++)
+				insert(roots[i / forestTreeSize], getKey(i));
+		});
+		auto byteCount = getHeapByteCount() - heapBefore;
+		uint64_t result = 0;
+		auto traversalSeconds = harness::measure(3, [&](){
+			result = 0;
+			for (auto root : roots)
+				result += sum(root);
+		});
+		isCorrect = isCorrect && result == expected;
+		report("forest, 64-bit pointers", nodeCount, buildSeconds, traversalSeconds, byteCount);
+	}
+
+	{
+		auto stack = Stack(40, 16);
+		std::vector<Segment<16>*> segments(treeCount);
+		std::vector<SegmentNode<16>::Ref*> roots(treeCount);
+		auto buildSeconds = harness::measure(1, [&](){
+			for (size_t i = 0; i < nodeCount; i++) {
+				auto tree = i / forestTreeSize;
+				if (i % forestTreeSize == 0) {
+					segments[tree] = Segment<16>::allocate(stack);
+					// The root link takes the room of a node
+					roots[tree] = segments[tree]->get(segments[tree]->create<SegmentNode<16>::Ref>());
+				}
+				if (!insert(*segments[tree], roots[tree], getKey(i))) {
+					std::fprintf(stderr, "FATAL ERROR: a tree of %zu nodes does not fit in a 64 KiB segment\n", forestTreeSize);
+					std::exit(1);
+				}
+			}
+		});
+		uint64_t result = 0;
+		auto traversalSeconds = harness::measure(3, [&](){
+			result = 0;
+			for (auto root : roots)
+				result += sum<16>(*root);
+		});
+		isCorrect = isCorrect && result == expected;
+		report("forest, 16-bit segment refs", nodeCount, buildSeconds, traversalSeconds, stack.getUsedByteCount());
+	}
+
+	if (!isCorrect) {
+		std::fprintf(stderr, "FATAL ERROR: a traversal did not visit every key\n");
+		return 1;
+	}
+	return 0;
+}
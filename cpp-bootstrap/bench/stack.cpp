@@ -0,0 +1,132 @@
+// Runtime stacks: `Stack` against `malloc` over millions of small objects, then what `trim` gives back
+// Usage: ./bench/stack [object count]
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include "../src/stack.hpp"
+#include "harness.hpp"
+
+// Shaped like a small runtime object: a header and a few fields, both sides construct the whole object in place
+struct Object {
+	uint64_t header;
+	uint64_t fields[3];
+
+	Object(uint64_t header) :
+		header(header),
+		fields{} {
+	}
+};
+
+static void report(const char *name, size_t count, double mallocSeconds, double stackSeconds) {
+	std::printf("%-30s malloc %7.2f ns  stack %7.2f ns  (%.1fx)\n", name, mallocSeconds * 1e9 / count, stackSeconds * 1e9 / count, mallocSeconds / stackSeconds);
+}
+
+// Resident memory of the process
+static double getResidentMegabytes(void) {
+	size_t pageCount = 0;
+	size_t residentPageCount = 0;
+	if (auto file = std::fopen("/proc/self/statm", "r")) {
+		if (std::fscanf(file, "%zu %zu", &pageCount, &residentPageCount) != 2)
+			residentPageCount = 0;
+		std::fclose(file);
+	}
+	return static_cast<double>(residentPageCount * Stack::getPageSize()) / 1e6;
+}
+
+int main(int argc, char **argv) {
+	size_t objectCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+	// The split section fills 16 objects at a time
+	if (objectCount < 16) {
+		std::fprintf(stderr, "FATAL ERROR: expected at least 16 objects\n");
+		return 1;
+	}
+	size_t checksum = 0;
+	// Room for every object of the benchmark
+	auto stack = Stack(40);
+	std::vector<void*> objects(objectCount);
+
+	// Fixed-size objects, all allocated then all released
+	{
+		auto mallocSeconds = harness::measure(5, [&](){
+			for (size_t i = 0; i < objectCount; i++) {
+				auto object = new (std::malloc(sizeof(Object))) Object(i);
+				objects[i] = object;
+			}
+			checksum += static_cast<Object*>(objects[objectCount - 1])->header;
+			for (auto object : objects)
+				std::free(object);
+		});
+		auto stackSeconds = harness::measure(5, [&](){
+			auto split = stack.split();
+			for (size_t i = 0; i < objectCount; i++) {
+				auto object = split.create<Object>(i);
+				objects[i] = object;
+			}
+			checksum += static_cast<Object*>(objects[objectCount - 1])->header;
+		});
+		report("32-byte object", objectCount, mallocSeconds, stackSeconds);
+	}
+
+	// Sizes from 8 to 128 bytes
+	{
+		auto mallocSeconds = harness::measure(5, [&](){
+			for (size_t i = 0; i < objectCount; i++) {
+				auto object = static_cast<uint64_t*>(std::malloc(8 + (i * 8) % 128));
+				object[0] = i;
+				objects[i] = object;
+			}
+			checksum += *static_cast<uint64_t*>(objects[objectCount - 1]);
+			for (auto object : objects)
+				std::free(object);
+		});
+		auto stackSeconds = harness::measure(5, [&](){
+			auto split = stack.split();
+			for (size_t i = 0; i < objectCount; i++) {
+				auto object = static_cast<uint64_t*>(split.allocate(8 + (i * 8) % 128, alignof(uint64_t)));
+				object[0] = i;
+				objects[i] = object;
+			}
+			checksum += *static_cast<uint64_t*>(objects[objectCount - 1]);
+		});
+		report("8 to 128-byte object", objectCount, mallocSeconds, stackSeconds);
+	}
+
+	// Short-lived objects, released 16 at a time like the locals of a call
+	{
+		auto mallocSeconds = harness::measure(5, [&](){
+			for (size_t i = 0; i < objectCount; i += 16) {
+				for (size_t j = 0; j < 16; j++) {
+					auto object = new (std::malloc(sizeof(Object))) Object(i + j);
+					objects[j] = object;
+				}
+				checksum += static_cast<Object*>(objects[15])->header;
+				for (size_t j = 0; j < 16; j++)
+					std::free(objects[j]);
+			}
+		});
+		auto stackSeconds = harness::measure(5, [&](){
+			for (size_t i = 0; i < objectCount; i += 16) {
+				auto split = stack.split();
+				for (size_t j = 0; j < 16; j++) {
+					auto object = split.create<Object>(i + j);
+					objects[j] = object;
+				}
+				checksum += static_cast<Object*>(objects[15])->header;
+			}
+		});
+		report("32-byte object, 16 per split", objectCount, mallocSeconds, stackSeconds);
+	}
+
+	std::printf("stack: %.1f MB committed by %zu commits, out of %.0f GB reserved\n",
+		stack.getCommittedByteCount() / 1e6, stack.getCommitCount(), stack.getReservedByteCount() / 1e9);
+	auto residentBefore = getResidentMegabytes();
+	auto trimBegin = std::chrono::steady_clock::now();
+	stack.trim();
+	auto trimEnd = std::chrono::steady_clock::now();
+	std::printf("trim: %.1f MB resident before, %.1f MB after, in %.2f ms\n", residentBefore, getResidentMegabytes(),
+		std::chrono::duration<double>(trimEnd - trimBegin).count() * 1000.0);
+
+	std::printf("(checksum %zu)\n", checksum);
+	return 0;
+}
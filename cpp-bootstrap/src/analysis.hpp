@@ -0,0 +1,870 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <span>
+#include <utility>
+#include <vector>
+#include "program.hpp"
+
+// Closed interval of signed integers, bools being 0 or 1
+// Operations give the full range whenever the result could wrap around
+struct Range {
+	int64_t minimum;
+	int64_t maximum;
+
+	static constexpr Range getFull(void) {
+		return Range{INT64_MIN, INT64_MAX};
+	}
+	static constexpr Range getConstant(int64_t value) {
+		return Range{value, value};
+	}
+
+	constexpr bool isFull(void) const {
+		return minimum == INT64_MIN && maximum == INT64_MAX;
+	}
+	constexpr bool isEmpty(void) const {
+		return minimum > maximum;
+	}
+	constexpr bool isConstant(void) const {
+		return minimum == maximum;
+	}
+	constexpr bool contains(int64_t value) const {
+		return minimum <= value && value <= maximum;
+	}
+
+	// Union, as the smallest interval containing both
+	constexpr Range join(Range other) const {
+		return Range{std::min(minimum, other.minimum), std::max(maximum, other.maximum)};
+	}
+	// Intersection, empty if they are disjoint
+	constexpr Range meet(Range other) const {
+		return Range{std::max(minimum, other.minimum), std::min(maximum, other.maximum)};
+	}
+
+	constexpr bool operator==(const Range&) const = default;
+
+	static constexpr Range add(Range a, Range b) {
+		Range res;
+		if (__builtin_add_overflow(a.minimum, b.minimum, &res.minimum) || __builtin_add_overflow(a.maximum, b.maximum, &res.maximum))
+			return getFull();
+		return res;
+	}
+	static constexpr Range subtract(Range a, Range b) {
+		Range res;
+		if (__builtin_sub_overflow(a.minimum, b.maximum, &res.minimum) || __builtin_sub_overflow(a.maximum, b.minimum, &res.maximum))
+			return getFull();
+		return res;
+	}
+	static constexpr Range multiply(Range a, Range b) {
+		int64_t corners[4];
+		if (__builtin_mul_overflow(a.minimum, b.minimum, &corners[0]) || __builtin_mul_overflow(a.minimum, b.maximum, &corners[1])
+			|| __builtin_mul_overflow(a.maximum, b.minimum, &corners[2]) || __builtin_mul_overflow(a.maximum, b.maximum, &corners[3]))
+			return getFull();
+		return Range{*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4)};
+	}
+	// Divisions by zero fail, only the other divisors are considered
+	static constexpr Range divide(Range a, Range b) {
+		std::optional<Range> res;
+		for (auto divisors : {Range{b.minimum, std::min<int64_t>(b.maximum, -1)}, Range{std::max<int64_t>(b.minimum, 1), b.maximum}}) {
+			if (divisors.isEmpty())
+				continue;
+			// The most negative integer divided by -1 wraps around
+			if (a.minimum == INT64_MIN && divisors.contains(-1))
+				return getFull();
+			// Truncated division is monotonic over divisors of a single sign
+			int64_t corners[4] = {a.minimum / divisors.minimum, a.minimum / divisors.maximum, a.maximum / divisors.minimum, a.maximum / divisors.maximum};
+			auto quotients = Range{*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4)};
+			res = res.has_value() ? res->join(quotients) : quotients;
+		}
+		return res.value_or(getFull());
+	}
+	// The remainder has the sign of the dividend and is smaller than the divisor in magnitude
+	static constexpr Range modulo(Range a, Range b) {
+		if (b.minimum == INT64_MIN || b == getConstant(0))
+			return getFull();
+		auto bound = std::max(-b.minimum, b.maximum) - 1;
+		return Range{a.minimum >= 0 ? 0 : std::max(a.minimum, -bound), a.maximum <= 0 ? 0 : std::min(a.maximum, bound)};
+	}
+	static constexpr Range negate(Range a) {
+		if (a.minimum == INT64_MIN)
+			return getFull();
+		return Range{-a.maximum, -a.minimum};
+	}
+	static constexpr Range binaryNot(Range a) {
+		return Range{~a.maximum, ~a.minimum};
+	}
+	// Counts of 64 or more shift everything out, negative ones are huge unsigned counts
+	static constexpr Range shiftLeft(Range a, Range b) {
+		if (a.minimum < 0 || b.minimum < 0 || b.maximum > 62 || a.maximum > (INT64_MAX >> b.maximum))
+			return getFull();
+		return Range{a.minimum << b.minimum, a.maximum << b.maximum};
+	}
+	static constexpr Range shiftRight(Range a, Range b) {
+		auto counts = b.minimum < 0 ? Range{0, 63} : Range{std::min<int64_t>(b.minimum, 63), std::min<int64_t>(b.maximum, 63)};
+		return Range{a.minimum >> (a.minimum >= 0 ? counts.maximum : counts.minimum), a.maximum >> (a.maximum >= 0 ? counts.minimum : counts.maximum)};
+	}
+	// Bitwise operations are only bounded over non-negative integers, which bools are
+	static constexpr Range binaryAnd(Range a, Range b) {
+		if (a.minimum >= 0 && b.minimum >= 0)
+			return Range{0, std::min(a.maximum, b.maximum)};
+		if (a.minimum >= 0 || b.minimum >= 0)
+			return Range{0, a.minimum >= 0 ? a.maximum : b.maximum};
+		return getFull();
+	}
+	static constexpr Range binaryOr(Range a, Range b, bool isXor) {
+		if (a.minimum < 0 || b.minimum < 0)
+			return getFull();
+		auto mask = static_cast<int64_t>((uint64_t(1) << std::bit_width(static_cast<uint64_t>(std::max(a.maximum, b.maximum)))) - 1);
+		return Range{isXor ? 0 : std::max(a.minimum, b.minimum), mask};
+	}
+};
+
+static_assert(Range::divide(Range{-7, 9}, Range{-2, 3}) == Range{-9, 9});
+static_assert(Range::modulo(Range{0, 100}, Range::getConstant(8)) == Range{0, 7});
+static_assert(Range::shiftRight(Range{-8, 40}, Range{1, 2}) == Range{-4, 20});
+static_assert(Range::binaryOr(Range{0, 1}, Range{0, 1}, true) == Range{0, 1});
+
+// Forward data flow over the code of a function, giving for every register at every point:
+// - the types it may hold
+// - the interval of its integer or bool value, or of the size of its array
+// - affine bounds `r + c` relative to the current value of other registers
+// - the comparison which computed it, so that the conditional jumps on it narrow the compared registers along each edge
+// Blocks are processed from a worklist in code order until their entry states settle, widening at loop heads bounds the revisits
+// Relations to a register are carried over to its own bounds once it is written, which stands for versioning the values of registers
+// Element accesses whose index is proven within the size of the array are reported, so that their bounds check can be left out
+class RangeAnalysis {
+	static constexpr uint32_t noBlock = 0xFFFFFFFF;
+	// Intervals growing at loop heads first widen to the constants of the function, then straight to the extremes
+	static constexpr uint32_t maxThresholdWideningCount = 8;
+	// Passes over the code once stable, narrowing what widening overshot
+	static constexpr size_t narrowingPassCount = 2;
+	// Affine bounds followed from an index, and from the size of an array, to find a register relating both
+	static constexpr size_t maxBoundChainLength = 4;
+
+	enum class Pass {
+		// Until the entry states are stable
+		Widen,
+		// From stable entry states to tighter ones
+		Narrow,
+		// Into the annotations
+		Record
+	};
+
+	// Operand of a recorded comparison, a constant if its register was overwritten by the result
+	struct Compared {
+		bool isRegister;
+		uint8_t reg;
+		int64_t value;
+
+		bool operator==(const Compared&) const = default;
+	};
+
+	struct RegisterState {
+		// Bit per `ValueType`, zero while the register holds nothing yet
+		uint8_t typeSet;
+		Range range;
+		std::optional<AffineBound> lowerBound;
+		std::optional<AffineBound> upperBound;
+		// Integer comparison which wrote the register, unless the registers it compared were written since
+		std::optional<Opcode> comparison;
+		Compared lhs;
+		Compared rhs;
+
+		bool operator==(const RegisterState&) const = default;
+	};
+
+	// Unreached while empty
+	using State = std::vector<RegisterState>;
+
+	const Program *m_program;
+	std::span<const Instruction> m_code;
+	std::vector<Annotation> *m_annotations;
+	// By instruction, the block it starts, `noBlock` if it starts none
+	std::vector<uint32_t> m_blocks;
+	// By block
+	std::vector<size_t> m_blockBegins;
+	std::vector<State> m_entryStates;
+	std::vector<bool> m_isLoopHead;
+	// By loop head and register, how many times its interval was widened
+	std::vector<std::vector<uint8_t>> m_wideningCounts;
+	std::vector<State> m_narrowedStates;
+	bool m_isWidened = false;
+	State m_state;
+	State m_takenState;
+	Pass m_pass;
+	std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> m_worklist;
+	std::vector<bool> m_isQueued;
+	// Sorted constants of the function along with their neighbours, the bounds loop heads widen to first
+	std::vector<int64_t> m_thresholds;
+	// Checked element accesses proven in bounds, by instruction index
+	std::vector<size_t> m_inBoundsAccesses;
+	// Lower bounds of the sizes of arrays found by `join`, kept from one call to the next to save allocations
+	std::vector<std::pair<uint8_t, std::optional<AffineBound>>> m_sizeBounds;
+
+	RangeAnalysis(const Program &program, std::span<const Instruction> code, std::vector<Annotation> &annotations) :
+		m_program(&program),
+		m_code(code),
+		m_annotations(&annotations) {
+	}
+
+	static size_t getJumpTarget(size_t index, Instruction instruction) {
+		return static_cast<size_t>(static_cast<int64_t>(index) + 1 + instruction.getJumpOffset());
+	}
+
+	static constexpr uint8_t integerTypeSet = 1 << static_cast<size_t>(ValueType::Integer);
+	static constexpr uint8_t arrayTypeSet = 1 << static_cast<size_t>(ValueType::Array);
+
+	static RegisterState getUnknown(uint8_t typeSet) {
+		auto res = RegisterState{typeSet, Range::getFull(), std::nullopt, std::nullopt, std::nullopt, {}, {}};
+		if (typeSet == 1 << static_cast<size_t>(ValueType::Bool))
+			res.range = Range{0, 1};
+		else if (typeSet == arrayTypeSet)
+			res.range = Range{0, INT64_MAX};
+		return res;
+	}
+
+	void findBlocks(uint16_t registerCount) {
+		m_blocks.assign(m_code.size() + 1, noBlock);
+		std::vector<bool> isLeader(m_code.size() + 1, false);
+		std::vector<bool> isLoopHead(m_code.size() + 1, false);
+		isLeader[0] = true;
+		for (size_t i = 0; i < m_code.size(); i++) {
+			auto instruction = m_code[i];
+			if (!instruction.isJump())
+				continue;
+			auto target = getJumpTarget(i, instruction);
+			isLeader[target] = true;
+			if (target <= i)
+				isLoopHead[target] = true;
+		}
+		for (size_t i = 0; i < m_code.size(); i++)
+			if (isLeader[i]) {
+				m_blocks[i] = static_cast<uint32_t>(m_blockBegins.size());
+				m_blockBegins.emplace_back(i);
+				m_isLoopHead.emplace_back(isLoopHead[i]);
+			}
+		m_entryStates.resize(m_blockBegins.size());
+		m_wideningCounts.resize(m_blockBegins.size());
+		for (size_t block = 0; block < m_blockBegins.size(); block++)
+			if (m_isLoopHead[block])
+				m_wideningCounts[block].assign(registerCount, 0);
+		m_isQueued.assign(m_blockBegins.size(), false);
+	}
+
+	void findThresholds(void) {
+		m_thresholds = {INT64_MIN, INT64_MIN + 1, -1, 0, 1, INT64_MAX - 1, INT64_MAX};
+		for (auto instruction : m_code) {
+			int64_t value;
+			if (instruction.getOpcode() == Opcode::LoadInteger)
+				value = instruction.getSignedBx();
+			else if (instruction.getOpcode() == Opcode::LoadConstant && m_program->getConstantType(instruction.getBx()) == ValueType::Integer)
+				value = static_cast<int64_t>(m_program->getConstants()[instruction.getBx()]);
+			else
+				continue;
+			m_thresholds.emplace_back(value);
+			if (value > INT64_MIN)
+				m_thresholds.emplace_back(value - 1);
+			if (value < INT64_MAX)
+				m_thresholds.emplace_back(value + 1);
+		}
+		std::sort(m_thresholds.begin(), m_thresholds.end());
+		m_thresholds.erase(std::unique(m_thresholds.begin(), m_thresholds.end()), m_thresholds.end());
+	}
+
+	// Relations
+
+	static std::optional<AffineBound> shift(std::optional<AffineBound> bound, int64_t offset) {
+		if (!bound.has_value() || __builtin_add_overflow(bound->offset, offset, &bound->offset))
+			return std::nullopt;
+		return bound;
+	}
+
+	// Before `reg` is written: what refers to its current value no longer holds
+	// A bound `reg + c` first tightens the interval, then becomes the bound of `reg` itself plus `c`, as in `x _< reg + c _< s + d + c`
+	static void forget(State &state, uint8_t reg) {
+		auto &source = state[reg];
+		for (size_t i = 0; i < state.size(); i++) {
+			auto &other = state[i];
+			if (i == reg)
+				continue;
+			int64_t bound;
+			if (other.lowerBound.has_value() && other.lowerBound->reg == reg) {
+				if (!__builtin_add_overflow(source.range.minimum, other.lowerBound->offset, &bound))
+					other.range.minimum = std::max(other.range.minimum, bound);
+				other.lowerBound = source.lowerBound.has_value() && source.lowerBound->reg != i ? shift(source.lowerBound, other.lowerBound->offset) : std::nullopt;
+			}
+			if (other.upperBound.has_value() && other.upperBound->reg == reg) {
+				if (!__builtin_add_overflow(source.range.maximum, other.upperBound->offset, &bound))
+					other.range.maximum = std::min(other.range.maximum, bound);
+				other.upperBound = source.upperBound.has_value() && source.upperBound->reg != i ? shift(source.upperBound, other.upperBound->offset) : std::nullopt;
+			}
+			if (other.comparison.has_value() && ((other.lhs.isRegister && other.lhs.reg == reg) || (other.rhs.isRegister && other.rhs.reg == reg)))
+				other.comparison.reset();
+		}
+	}
+
+	// Once `reg` is written with its previous value plus `offset`: what refers to it is shifted the other way instead
+	static void rebase(State &state, uint8_t reg, int64_t offset) {
+		for (auto &other : state) {
+			if (other.lowerBound.has_value() && other.lowerBound->reg == reg)
+				other.lowerBound = offset != INT64_MIN ? shift(other.lowerBound, -offset) : std::nullopt;
+			if (other.upperBound.has_value() && other.upperBound->reg == reg)
+				other.upperBound = offset != INT64_MIN ? shift(other.upperBound, -offset) : std::nullopt;
+			if (other.comparison.has_value() && ((other.lhs.isRegister && other.lhs.reg == reg) || (other.rhs.isRegister && other.rhs.reg == reg)))
+				other.comparison.reset();
+		}
+	}
+
+	// Tightens the interval of `reg` with its affine bounds
+	static void applyBounds(State &state, uint8_t reg) {
+		auto &target = state[reg];
+		int64_t bound;
+		if (target.upperBound.has_value() && !__builtin_add_overflow(state[target.upperBound->reg].range.maximum, target.upperBound->offset, &bound))
+			target.range.maximum = std::min(target.range.maximum, bound);
+		if (target.lowerBound.has_value() && !__builtin_add_overflow(state[target.lowerBound->reg].range.minimum, target.lowerBound->offset, &bound))
+			target.range.minimum = std::max(target.range.minimum, bound);
+	}
+
+	// Narrowing, each returns false if no execution satisfies the assumption
+
+	static Range getRange(const State &state, Compared operand) {
+		return operand.isRegister ? state[operand.reg].range : Range::getConstant(operand.value);
+	}
+
+	static void setRange(State &state, Compared operand, Range range) {
+		if (operand.isRegister)
+			state[operand.reg].range = range;
+	}
+
+	// `lhs < rhs`, or `lhs <= rhs` if `isOrEqual`
+	static bool assumeLesser(State &state, Compared lhs, Compared rhs, bool isOrEqual) {
+		int64_t gap = isOrEqual ? 0 : 1;
+		if (lhs.isRegister && rhs.isRegister && lhs.reg == rhs.reg)
+			return isOrEqual;
+		auto lhsRange = getRange(state, lhs);
+		auto rhsRange = getRange(state, rhs);
+		int64_t maximum;
+		int64_t minimum;
+		if (__builtin_sub_overflow(rhsRange.maximum, gap, &maximum) || __builtin_add_overflow(lhsRange.minimum, gap, &minimum))
+			return false;
+		lhsRange.maximum = std::min(lhsRange.maximum, maximum);
+		rhsRange.minimum = std::max(rhsRange.minimum, minimum);
+		if (lhsRange.isEmpty() || rhsRange.isEmpty())
+			return false;
+		setRange(state, lhs, lhsRange);
+		setRange(state, rhs, rhsRange);
+		if (lhs.isRegister && rhs.isRegister) {
+			state[lhs.reg].upperBound = AffineBound{rhs.reg, -gap};
+			state[rhs.reg].lowerBound = AffineBound{lhs.reg, gap};
+		}
+		return true;
+	}
+
+	// `lhs = rhs`, or `lhs != rhs` if not `isEqual`
+	static bool assumeEqual(State &state, Compared lhs, Compared rhs, bool isEqual) {
+		auto lhsRange = getRange(state, lhs);
+		auto rhsRange = getRange(state, rhs);
+		if (isEqual) {
+			auto range = lhsRange.meet(rhsRange);
+			if (range.isEmpty())
+				return false;
+			setRange(state, lhs, range);
+			setRange(state, rhs, range);
+			if (lhs.isRegister && rhs.isRegister && lhs.reg != rhs.reg) {
+				state[lhs.reg].lowerBound = state[lhs.reg].upperBound = AffineBound{rhs.reg, 0};
+				state[rhs.reg].lowerBound = state[rhs.reg].upperBound = AffineBound{lhs.reg, 0};
+			}
+			return true;
+		}
+		if (lhs.isRegister && rhs.isRegister && lhs.reg == rhs.reg)
+			return false;
+		// Only a constant at the end of the other interval can be excluded
+		auto exclude = [&](Compared operand, Range range, Range excluded){
+			if (!excluded.isConstant())
+				return true;
+			if (range == excluded)
+				return false;
+			if (range.minimum == excluded.minimum)
+				range.minimum++;
+			else if (range.maximum == excluded.minimum)
+				range.maximum--;
+			setRange(state, operand, range);
+			return !range.isEmpty();
+		};
+		return exclude(lhs, lhsRange, rhsRange) && exclude(rhs, getRange(state, rhs), getRange(state, lhs));
+	}
+
+	static bool assume(State &state, Opcode comparison, Compared lhs, Compared rhs, bool isTrue) {
+		switch (comparison) {
+		case Opcode::EqualInteger:
+			return assumeEqual(state, lhs, rhs, isTrue);
+		case Opcode::DifferentInteger:
+			return assumeEqual(state, lhs, rhs, !isTrue);
+		case Opcode::LesserInteger:
+			return isTrue ? assumeLesser(state, lhs, rhs, false) : assumeLesser(state, rhs, lhs, true);
+		default:
+			return isTrue ? assumeLesser(state, lhs, rhs, true) : assumeLesser(state, rhs, lhs, false);
+		}
+	}
+
+	// The condition register holds `isTrue`
+	static bool assumeCondition(State &state, uint8_t condition, bool isTrue) {
+		auto &target = state[condition];
+		target.range = target.range.meet(Range::getConstant(isTrue ? 1 : 0));
+		if (target.range.isEmpty())
+			return false;
+		if (!target.comparison.has_value())
+			return true;
+		return assume(state, *target.comparison, target.lhs, target.rhs, isTrue);
+	}
+
+	// Transfer
+
+	// Written value of an integer comparison, decided when the intervals allow it
+	static Range compare(Opcode opcode, Range lhs, Range rhs) {
+		bool isTrue;
+		bool isFalse;
+		switch (opcode) {
+		case Opcode::EqualInteger:
+		case Opcode::DifferentInteger:
+			isTrue = lhs.isConstant() && lhs == rhs;
+			isFalse = lhs.meet(rhs).isEmpty();
+			if (opcode == Opcode::DifferentInteger)
+				std::swap(isTrue, isFalse);
+			break;
+		case Opcode::LesserInteger:
+			isTrue = lhs.maximum < rhs.minimum;
+			isFalse = lhs.minimum >= rhs.maximum;
+			break;
+		default:
+			isTrue = lhs.maximum <= rhs.minimum;
+			isFalse = lhs.minimum > rhs.maximum;
+			break;
+		}
+		return isTrue ? Range::getConstant(1) : isFalse ? Range::getConstant(0) : Range{0, 1};
+	}
+
+	// `value`, to be written to `a`, is `b` plus a constant, which must not wrap around for the bounds to hold
+	// Returns whether they hold
+	static bool setOffset(State &state, RegisterState &value, uint8_t a, uint8_t b, int64_t offset) {
+		auto &source = state[b];
+		int64_t sum;
+		if (__builtin_add_overflow(source.range.minimum, offset, &sum) || __builtin_add_overflow(source.range.maximum, offset, &sum))
+			return false;
+		value.lowerBound = source.lowerBound.has_value() ? shift(source.lowerBound, offset) : a != b ? std::optional(AffineBound{b, offset}) : std::nullopt;
+		value.upperBound = source.upperBound.has_value() ? shift(source.upperBound, offset) : a != b ? std::optional(AffineBound{b, offset}) : std::nullopt;
+		for (auto bound : {&value.lowerBound, &value.upperBound})
+			if (bound->has_value() && (*bound)->reg == a)
+				bound->reset();
+		return true;
+	}
+
+	// One more element in the array `reg`, whose size cannot exceed the largest integer
+	static void grow(State &state, uint8_t reg) {
+		auto &array = state[reg];
+		auto increment = [](int64_t size){
+			return size < INT64_MAX ? size + 1 : size;
+		};
+		array.range = Range{increment(array.range.minimum), increment(array.range.maximum)};
+		array.lowerBound = shift(array.lowerBound, 1);
+		array.upperBound = shift(array.upperBound, 1);
+		rebase(state, reg, 1);
+	}
+
+	// Whether `0 _< index < ` the size of `array`
+	// The upper bounds of the index and the lower bounds of the size are followed from register to register, looking for a common one
+	static bool isInBounds(const State &state, uint8_t array, uint8_t index) {
+		auto &size = state[array];
+		auto &position = state[index];
+		if (size.typeSet != arrayTypeSet || position.typeSet != integerTypeSet || position.range.minimum < 0)
+			return false;
+		std::array<AffineBound, maxBoundChainLength + 1> sizeBounds;
+		size_t sizeBoundCount = 0;
+		auto minimumSize = size.range.minimum;
+		for (std::optional<AffineBound> bound = AffineBound{array, 0}; bound.has_value() && sizeBoundCount < sizeBounds.size();
+			bound = shift(state[bound->reg].lowerBound, bound->offset)) {
+			sizeBounds[sizeBoundCount++] = *bound;
+			int64_t minimum;
+			if (!__builtin_add_overflow(state[bound->reg].range.minimum, bound->offset, &minimum))
+				minimumSize = std::max(minimumSize, minimum);
+		}
+		std::optional<AffineBound> bound = AffineBound{index, 0};
+		for (size_t i = 0; i <= maxBoundChainLength && bound.has_value(); i++, bound = shift(state[bound->reg].upperBound, bound->offset)) {
+			int64_t maximum;
+			if (!__builtin_add_overflow(state[bound->reg].range.maximum, bound->offset, &maximum) && maximum < minimumSize)
+				return true;
+			for (size_t j = 0; j < sizeBoundCount; j++)
+				if (sizeBounds[j].reg == bound->reg && bound->offset < sizeBounds[j].offset)
+					return true;
+		}
+		return false;
+	}
+
+	// Applies the instruction at `index` to `state`, other than the branching of jumps
+	void transfer(State &state, size_t index) {
+		auto instruction = m_code[index];
+		auto opcode = instruction.getOpcode();
+		if (opcode == Opcode::BackInsert)
+			grow(state, instruction.getA());
+		if (!instruction.isWritingA())
+			return;
+		auto a = instruction.getA();
+		auto b = instruction.getB();
+		auto c = instruction.getC();
+		auto value = getUnknown(static_cast<uint8_t>((*m_annotations)[index].typeSet));
+		auto integer = [&](Range range){
+			value.typeSet = integerTypeSet;
+			value.range = range;
+		};
+		// Set when `a` is written with its previous value plus this
+		std::optional<int64_t> selfOffset;
+		auto offset = [&](uint8_t source, int64_t amount){
+			if (setOffset(state, value, a, source, amount) && source == a)
+				selfOffset = amount;
+		};
+		switch (opcode) {
+		case Opcode::Move:
+			value = state[b];
+			value.comparison.reset();
+			offset(b, 0);
+			break;
+		case Opcode::LoadInteger:
+			integer(Range::getConstant(instruction.getSignedBx()));
+			break;
+		case Opcode::LoadConstant:
+			if (m_program->getConstantType(instruction.getBx()) == ValueType::Integer)
+				integer(Range::getConstant(static_cast<int64_t>(m_program->getConstants()[instruction.getBx()])));
+			break;
+		case Opcode::AddInteger:
+		case Opcode::SubtractInteger:
+			integer(opcode == Opcode::AddInteger ? Range::add(state[b].range, state[c].range) : Range::subtract(state[b].range, state[c].range));
+			if (state[c].range.isConstant() && state[c].range.minimum != INT64_MIN)
+				offset(b, opcode == Opcode::AddInteger ? state[c].range.minimum : -state[c].range.minimum);
+			else if (opcode == Opcode::AddInteger && state[b].range.isConstant())
+				offset(c, state[b].range.minimum);
+			break;
+		case Opcode::AddIntegerImmediate:
+			integer(Range::add(state[b].range, Range::getConstant(instruction.getSignedC())));
+			offset(b, instruction.getSignedC());
+			break;
+		case Opcode::MultiplyInteger:
+			integer(Range::multiply(state[b].range, state[c].range));
+			break;
+		case Opcode::MultiplyAddInteger:
+			integer(Range::add(state[a].range, Range::multiply(state[b].range, state[c].range)));
+			break;
+		case Opcode::DivideInteger:
+			integer(Range::divide(state[b].range, state[c].range));
+			break;
+		case Opcode::ModuloInteger:
+			integer(Range::modulo(state[b].range, state[c].range));
+			break;
+		case Opcode::NegateInteger:
+			integer(Range::negate(state[b].range));
+			break;
+		case Opcode::ShiftLeft:
+			integer(Range::shiftLeft(state[b].range, state[c].range));
+			break;
+		case Opcode::ShiftRight:
+			integer(Range::shiftRight(state[b].range, state[c].range));
+			break;
+		case Opcode::BinaryNot:
+			integer(Range::binaryNot(state[b].range));
+			break;
+		// Also the boolean operators, the written type is the one of the operands
+		case Opcode::BinaryOr:
+		case Opcode::BinaryXor:
+		case Opcode::BinaryAnd:
+			value.typeSet = state[b].typeSet;
+			value.range = opcode == Opcode::BinaryAnd ? Range::binaryAnd(state[b].range, state[c].range)
+				: Range::binaryOr(state[b].range, state[c].range, opcode == Opcode::BinaryXor);
+			break;
+		case Opcode::BooleanNot:
+			value.range = Range{1 - state[b].range.maximum, 1 - state[b].range.minimum};
+			break;
+		case Opcode::EqualInteger:
+		case Opcode::DifferentInteger:
+		case Opcode::LesserInteger:
+		case Opcode::LesserOrEqualInteger: {
+			value.range = compare(opcode, state[b].range, state[c].range);
+			value.comparison = opcode;
+			value.lhs = Compared{b != a, b, state[b].range.minimum};
+			value.rhs = Compared{c != a, c, state[c].range.minimum};
+			// The overwritten operand is only kept if constant
+			if ((!value.lhs.isRegister && !state[b].range.isConstant()) || (!value.rhs.isRegister && !state[c].range.isConstant()))
+				value.comparison.reset();
+			break;
+		}
+		case Opcode::MultiplyCount:
+		case Opcode::AddCount:
+			integer(Range{0, INT64_MAX});
+			break;
+		case Opcode::NewArray:
+			value.range = Range::getConstant(0);
+			break;
+		case Opcode::IncrementJumpIfLesserInteger:
+			integer(Range::add(state[a].range, Range::getConstant(1)));
+			offset(a, 1);
+			break;
+		case Opcode::Call: {
+			// The frame of the callee is clobbered from `a`
+			for (size_t reg = a; reg < state.size(); reg++) {
+				forget(state, static_cast<uint8_t>(reg));
+				state[reg] = getUnknown((1 << valueTypeCount) - 1);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		if (selfOffset.has_value())
+			rebase(state, a, *selfOffset);
+		else
+			forget(state, a);
+		state[a] = value;
+		applyBounds(state, a);
+	}
+
+	// Worklist
+
+	int64_t widenUp(int64_t bound, uint32_t wideningCount) const {
+		if (wideningCount >= maxThresholdWideningCount)
+			return bound < INT64_MAX - 1 ? INT64_MAX - 1 : INT64_MAX;
+		return *std::lower_bound(m_thresholds.begin(), m_thresholds.end(), bound);
+	}
+
+	int64_t widenDown(int64_t bound, uint32_t wideningCount) const {
+		if (wideningCount >= maxThresholdWideningCount)
+			return bound > INT64_MIN + 1 ? INT64_MIN + 1 : INT64_MIN;
+		return *std::prev(std::upper_bound(m_thresholds.begin(), m_thresholds.end(), bound));
+	}
+
+	// Lower bound of the size of the array `reg` holding in both states
+	// Besides a bound they share, the intervals give one, such as relative to a register both values are known to move along with,
+	// the counter of a loop filling it
+	// When widening, only known values give one, as intervals would bring back the bounds that are dropped for moving
+	static std::optional<AffineBound> joinSizeBounds(const State &entry, const State &incoming, uint8_t reg, bool isWidening) {
+		auto getOffset = [&](const State &state, size_t base) -> std::optional<int64_t> {
+			auto &size = state[reg];
+			if (size.lowerBound.has_value() && size.lowerBound->reg == base)
+				return size.lowerBound->offset;
+			int64_t res;
+			if (state[base].typeSet == integerTypeSet && (!isWidening || (size.range.isConstant() && state[base].range.isConstant()))
+				&& !__builtin_sub_overflow(size.range.minimum, state[base].range.maximum, &res))
+				return res;
+			return std::nullopt;
+		};
+		auto joinOver = [&](size_t base) -> std::optional<AffineBound> {
+			auto entryOffset = getOffset(entry, base);
+			auto incomingOffset = getOffset(incoming, base);
+			// An offset that shrinks along the loop would keep shrinking on every iteration, so widening drops the bound
+			if (!entryOffset.has_value() || !incomingOffset.has_value() || (isWidening && *incomingOffset < *entryOffset))
+				return std::nullopt;
+			return AffineBound{static_cast<uint8_t>(base), std::min(*entryOffset, *incomingOffset)};
+		};
+		for (auto state : {&entry, &incoming})
+			if ((*state)[reg].lowerBound.has_value())
+				if (auto res = joinOver((*state)[reg].lowerBound->reg))
+					return res;
+		if (!entry[reg].range.isConstant() || !incoming[reg].range.isConstant() || entry[reg].range == incoming[reg].range)
+			return std::nullopt;
+		for (size_t base = 0; base < entry.size(); base++)
+			if (base != reg && entry[base].range.isConstant() && incoming[base].range.isConstant() && entry[base].range != incoming[base].range)
+				if (auto res = joinOver(base))
+					return res;
+		return std::nullopt;
+	}
+
+	// Joins `incoming` into `entry`, widening the intervals that grow by `wideningCounts` if not null, returns whether `entry` changed
+	bool join(State &entry, const State &incoming, std::vector<uint8_t> *wideningCounts) {
+		if (entry.empty()) {
+			entry = incoming;
+			return true;
+		}
+		// Before `entry` changes, sizes being bound to other registers
+		m_sizeBounds.clear();
+		for (size_t reg = 0; reg < entry.size(); reg++)
+			if ((entry[reg].typeSet | incoming[reg].typeSet) == arrayTypeSet)
+				m_sizeBounds.emplace_back(static_cast<uint8_t>(reg), joinSizeBounds(entry, incoming, static_cast<uint8_t>(reg), wideningCounts != nullptr));
+		bool isChanged = false;
+		for (size_t reg = 0; reg < entry.size(); reg++) {
+			auto &old = entry[reg];
+			auto &other = incoming[reg];
+			auto joined = old;
+			joined.typeSet |= other.typeSet;
+			joined.range = old.range.join(other.range);
+			bool isWidening = wideningCounts != nullptr;
+			if (isWidening && joined.range != old.range) {
+				auto &count = (*wideningCounts)[reg];
+				if (joined.range.maximum > old.range.maximum)
+					joined.range.maximum = widenUp(joined.range.maximum, count);
+				if (joined.range.minimum < old.range.minimum)
+					joined.range.minimum = widenDown(joined.range.minimum, count);
+				count = static_cast<uint8_t>(std::min<uint32_t>(count + 1, maxThresholdWideningCount));
+				m_isWidened = true;
+			}
+			// A bound survives when both sides are bound by the same register, at the looser offset, unless widening loosens it
+			if (joined.lowerBound.has_value() && (!other.lowerBound.has_value() || other.lowerBound->reg != joined.lowerBound->reg
+				|| (isWidening && other.lowerBound->offset < joined.lowerBound->offset)))
+				joined.lowerBound.reset();
+			else if (joined.lowerBound.has_value())
+				joined.lowerBound->offset = std::min(joined.lowerBound->offset, other.lowerBound->offset);
+			if (joined.upperBound.has_value() && (!other.upperBound.has_value() || other.upperBound->reg != joined.upperBound->reg
+				|| (isWidening && other.upperBound->offset > joined.upperBound->offset)))
+				joined.upperBound.reset();
+			else if (joined.upperBound.has_value())
+				joined.upperBound->offset = std::max(joined.upperBound->offset, other.upperBound->offset);
+			if (joined.comparison.has_value() && (joined.comparison != other.comparison || joined.lhs != other.lhs || joined.rhs != other.rhs))
+				joined.comparison.reset();
+			if (joined != old) {
+				old = joined;
+				isChanged = true;
+			}
+		}
+		for (auto &[reg, bound] : m_sizeBounds)
+			if (entry[reg].lowerBound != bound) {
+				entry[reg].lowerBound = bound;
+				isChanged = true;
+			}
+		return isChanged;
+	}
+
+	void propagate(size_t target, const State &state) {
+		auto block = m_blocks[target];
+		if (m_pass == Pass::Narrow) {
+			join(m_narrowedStates[block], state, nullptr);
+			return;
+		}
+		auto &wideningCounts = m_wideningCounts[block];
+		if (!join(m_entryStates[block], state, m_isLoopHead[block] ? &wideningCounts : nullptr) || m_isQueued[block])
+			return;
+		m_isQueued[block] = true;
+		m_worklist.push(block);
+	}
+
+	// Runs the block from its entry state, propagating to its successors unless recording the annotations
+	void process(uint32_t block) {
+		bool isRecording = m_pass == Pass::Record;
+		// Copied into storage kept from block to block, which saves allocations
+		auto &state = m_state;
+		state = m_entryStates[block];
+		for (size_t i = m_blockBegins[block];; i++) {
+			auto instruction = m_code[i];
+			auto opcode = instruction.getOpcode();
+			// Checked before the loaded element may overwrite the index
+			if (isRecording && ((opcode == Opcode::LoadElement && isInBounds(state, instruction.getB(), instruction.getC()))
+				|| (opcode == Opcode::StoreElement && isInBounds(state, instruction.getA(), instruction.getB()))))
+				m_inBoundsAccesses.emplace_back(i);
+			transfer(state, i);
+			if (isRecording)
+				annotate(state, i);
+			if (opcode == Opcode::Return || opcode == Opcode::ReturnNothing)
+				return;
+			if (instruction.isJump()) {
+				auto target = getJumpTarget(i, instruction);
+				if (opcode == Opcode::Jump) {
+					if (!isRecording)
+						propagate(target, state);
+					return;
+				}
+				auto &taken = m_takenState;
+				taken = state;
+				bool isTakenReachable;
+				bool isFallthroughReachable;
+				if (opcode == Opcode::JumpIfTrue || opcode == Opcode::JumpIfFalse) {
+					isTakenReachable = assumeCondition(taken, instruction.getA(), opcode == Opcode::JumpIfTrue);
+					isFallthroughReachable = assumeCondition(state, instruction.getA(), opcode != Opcode::JumpIfTrue);
+				} else {
+					auto lhs = Compared{true, instruction.getA(), 0};
+					auto rhs = Compared{true, instruction.getB(), 0};
+					isTakenReachable = assumeLesser(taken, lhs, rhs, false);
+					isFallthroughReachable = assumeLesser(state, rhs, lhs, true);
+				}
+				if (isTakenReachable && !isRecording)
+					propagate(target, taken);
+				if (!isFallthroughReachable)
+					return;
+			}
+			if (m_blocks[i + 1] != noBlock) {
+				if (!isRecording)
+					propagate(i + 1, state);
+				return;
+			}
+		}
+	}
+
+	void annotate(const State &state, size_t index) {
+		auto instruction = m_code[index];
+		auto &annotation = (*m_annotations)[index];
+		annotation.hasRange = false;
+		annotation.lowerBound.reset();
+		annotation.upperBound.reset();
+		if (!instruction.isWritingA())
+			return;
+		auto &written = state[instruction.getA()];
+		annotation.typeSet = written.typeSet;
+		bool isInteger = written.typeSet == 1 << static_cast<size_t>(ValueType::Integer);
+		bool isBool = written.typeSet == 1 << static_cast<size_t>(ValueType::Bool);
+		if ((isInteger && !written.range.isFull()) || (isBool && written.range.isConstant())) {
+			annotation.hasRange = true;
+			annotation.minimum = written.range.minimum;
+			annotation.maximum = written.range.maximum;
+		}
+		if (isInteger) {
+			annotation.lowerBound = written.lowerBound;
+			annotation.upperBound = written.upperBound;
+		}
+	}
+
+	void run(uint16_t registerCount, std::span<const ValueType> parameterTypes) {
+		findBlocks(registerCount);
+		findThresholds();
+		auto &entry = m_entryStates[0];
+		entry.assign(registerCount, getUnknown(0));
+		for (size_t i = 0; i < parameterTypes.size(); i++)
+			entry[i] = getUnknown(static_cast<uint8_t>(1 << static_cast<size_t>(parameterTypes[i])));
+		m_pass = Pass::Widen;
+		m_isQueued[0] = true;
+		m_worklist.push(0);
+		while (!m_worklist.empty()) {
+			auto block = m_worklist.top();
+			m_worklist.pop();
+			m_isQueued[block] = false;
+			process(block);
+		}
+
+		// Without widening, the entry states are already the tightest
+		m_pass = Pass::Narrow;
+		for (size_t i = 0; i < (m_isWidened ? narrowingPassCount : 0); i++) {
+			m_narrowedStates.assign(m_blockBegins.size(), State());
+			m_narrowedStates[0] = m_entryStates[0];
+			for (uint32_t block = 0; block < m_blockBegins.size(); block++)
+				if (!m_entryStates[block].empty())
+					process(block);
+			std::swap(m_entryStates, m_narrowedStates);
+		}
+
+		m_pass = Pass::Record;
+		for (uint32_t block = 0; block < m_blockBegins.size(); block++)
+			if (!m_entryStates[block].empty())
+				process(block);
+	}
+
+public:
+	// Sets the types and bounds of the written registers in `annotations`, by instruction of `code`
+	// The type of what a `call` returns is the one already annotated, unreachable instructions keep their annotations
+	// Returns the indices of the `load_element` and `store_element` instructions whose index is always within the size of the array
+	static std::vector<size_t> analyze(const Program &program, std::span<const Instruction> code, uint16_t registerCount,
+		std::span<const ValueType> parameterTypes, std::vector<Annotation> &annotations) {
+		auto analysis = RangeAnalysis(program, code, annotations);
+		analysis.run(registerCount, parameterTypes);
+		return std::move(analysis.m_inBoundsAccesses);
+	}
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+// Bump-pointer allocator for data living as long as a compilation
+// Nothing is freed individually: `reset` releases every allocation at once in constant time, keeping the blocks for reuse
+// Blocks go back to the heap when the arena is destroyed
+// Not thread-safe
+class Arena {
+	static constexpr size_t initialBlockSize = 64 << 10;
+	static constexpr size_t maxBlockSize = 64 << 20;
+
+	// Header at the beginning of every block, blocks are chained from the most recent one
+	struct Block {
+		Block *previous;
+		// Header included
+		size_t size;
+	};
+
+	// Adapter for `std::pmr` containers, deallocation is a no-op
+	class Resource : public std::pmr::memory_resource {
+		Arena *m_arena;
+
+		void* do_allocate(size_t size, size_t alignment) override {
+			return m_arena->allocate(size, alignment);
+		}
+		void do_deallocate(void*, size_t, size_t) override {
+		}
+		bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+			return this == &other;
+		}
+
+	public:
+		Resource(Arena &arena) :
+			m_arena(&arena) {
+		}
+	};
+
+	Block *m_lastBlock;
+	// The oldest block in use, which `reset` links to the free blocks
+	Block *m_firstBlock;
+	// Blocks released by `reset`, the most recent ones, hence the largest, first
+	Block *m_freeBlocks;
+	char *m_cursor;
+	char *m_end;
+	size_t m_nextBlockSize;
+	Resource m_resource;
+
+	size_t m_allocationCount;
+	size_t m_allocatedByteCount;
+	size_t m_reservedByteCount;
+	size_t m_blockCount;
+
+	void* allocateFromNewBlock(size_t size, size_t alignment) {
+		auto requiredSize = sizeof(Block) + size + alignment;
+		// Large allocations get a block of their own, so that the current one keeps serving small ones
+		bool isDedicated = requiredSize > m_nextBlockSize / 4;
+		auto blockSize = isDedicated ? requiredSize : m_nextBlockSize;
+		Block *block;
+		// Only the first free block is considered, the others are at most as large unless dedicated
+		if (m_freeBlocks != nullptr && m_freeBlocks->size >= requiredSize) {
+			block = m_freeBlocks;
+			m_freeBlocks = block->previous;
+			blockSize = block->size;
+		} else {
+			block = static_cast<Block*>(::operator new(blockSize));
+			block->size = blockSize;
+		}
+		m_reservedByteCount += blockSize;
+		m_blockCount++;
+
+		auto blockBegin = reinterpret_cast<char*>(block + 1);
+		auto blockEnd = reinterpret_cast<char*>(block) + blockSize;
+		if (isDedicated && m_lastBlock != nullptr) {
+			// Chained behind the current block, which stays the one being bumped
+			block->previous = m_lastBlock->previous;
+			m_lastBlock->previous = block;
+		} else {
+			block->previous = m_lastBlock;
+			m_lastBlock = block;
+			m_nextBlockSize = std::min(m_nextBlockSize * 2, maxBlockSize);
+		}
+		if (block->previous == nullptr)
+			m_firstBlock = block;
+
+		auto res = reinterpret_cast<char*>(alignUp(reinterpret_cast<uintptr_t>(blockBegin), alignment));
+		if (!isDedicated || m_lastBlock == block) {
+			m_cursor = res + size;
+			m_end = blockEnd;
+		}
+		return res;
+	}
+
+	static uintptr_t alignUp(uintptr_t address, size_t alignment) {
+		return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+public:
+	Arena(void) :
+		m_lastBlock(nullptr),
+		m_firstBlock(nullptr),
+		m_freeBlocks(nullptr),
+		m_cursor(nullptr),
+		m_end(nullptr),
+		m_nextBlockSize(initialBlockSize),
+		m_resource(*this),
+		m_allocationCount(0),
+		m_allocatedByteCount(0),
+		m_reservedByteCount(0),
+		m_blockCount(0) {
+	}
+
+	// `m_resource` points back to the arena
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	~Arena(void) {
+		reset();
+		while (m_freeBlocks != nullptr) {
+			auto previous = m_freeBlocks->previous;
+			::operator delete(m_freeBlocks);
+			m_freeBlocks = previous;
+		}
+	}
+
+	// `alignment` must be a power of two
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		m_allocationCount++;
+		m_allocatedByteCount += size;
+		auto res = reinterpret_cast<char*>(alignUp(reinterpret_cast<uintptr_t>(m_cursor), alignment));
+		if (m_cursor != nullptr && size <= static_cast<size_t>(m_end - res)) {
+			m_cursor = res + size;
+			return res;
+		}
+		return allocateFromNewBlock(size, alignment);
+	}
+
+	// Destructors are never run, hence trivially destructible types only
+	template <typename Type, typename ...Args>
+	Type* create(Args &&...args) {
+		static_assert(std::is_trivially_destructible_v<Type>, "Arena never runs destructors");
+		return new (allocate(sizeof(Type), alignof(Type))) Type(std::forward<Args>(args)...);
+	}
+
+	// Uninitialized storage for `count` elements
+	template <typename Type>
+	Type* allocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<Type>, "Arena never runs destructors");
+		return static_cast<Type*>(allocate(sizeof(Type) * count, alignof(Type)));
+	}
+
+	std::string_view copyString(std::string_view string) {
+		auto res = static_cast<char*>(allocate(string.size(), 1));
+		std::memcpy(res, string.data(), string.size());
+		return std::string_view(res, string.size());
+	}
+
+	// For `std::pmr` containers, which must not outlive the arena nor its next `reset`
+	std::pmr::memory_resource* getResource(void) {
+		return &m_resource;
+	}
+
+	// Releases every allocation at once, the blocks in use are put in front of the free ones
+	// The size of the next block is kept, the free blocks being served first
+	void reset(void) {
+		if (m_lastBlock != nullptr) {
+			m_firstBlock->previous = m_freeBlocks;
+			m_freeBlocks = m_lastBlock;
+		}
+		m_lastBlock = nullptr;
+		m_firstBlock = nullptr;
+		m_cursor = nullptr;
+		m_end = nullptr;
+		m_allocationCount = 0;
+		m_allocatedByteCount = 0;
+		m_reservedByteCount = 0;
+		m_blockCount = 0;
+	}
+
+	size_t getAllocationCount(void) const {
+		return m_allocationCount;
+	}
+	// Bytes requested, excluding alignment padding
+	size_t getAllocatedByteCount(void) const {
+		return m_allocatedByteCount;
+	}
+	// Bytes of the blocks in use since the last `reset`, including block headers and unused block tails
+	size_t getReservedByteCount(void) const {
+		return m_reservedByteCount;
+	}
+	size_t getBlockCount(void) const {
+		return m_blockCount;
+	}
+};
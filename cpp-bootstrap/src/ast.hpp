@@ -0,0 +1,348 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include "token.hpp"
+
+// Index of a node within its `Ast`
+using NodeIndex = uint32_t;
+
+namespace Nodes {
+	// Absent optional child, such as the `else` of an `if` scope without one
+	static constexpr NodeIndex none = 0xFFFFFFFF;
+}
+
+enum class NodeKind : uint8_t {
+	// Operands, by node: symbol
+	Identifier,
+	// Reference within the `NumberTable` of the compilation
+	NumberLiteral,
+	// None, the node span is the literal along with its delimiters
+	StringLiteral,
+
+	// Object, member symbol
+	Member,
+	// Callee, first argument within the lists, argument count
+	Call,
+	// Array, index
+	Subscript,
+	// Operand
+	Prefix,
+	// Operand
+	Postfix,
+	// Left, right
+	Binary,
+	// Left, right
+	Comparison,
+	// First `Comparison` within the lists, comparison count
+	// Links are in source order and each link's left is the previous link's right, evaluated once
+	ComparisonChain,
+	// Predicate, value if true, value if false
+	Conditional,
+	// Target, value
+	// The operator is `Assign`, `BackInsert`, or the arithmetic or binary operator of a compound assignment
+	Assignment,
+	// First `Parameter` within the lists, parameter count, body
+	Function,
+	// Symbol, type or none
+	Parameter,
+	// Size or none, element type: `[]integer`, called to construct an array
+	ArrayType,
+
+	// First statement within the lists, statement count
+	Block,
+	// Variable symbol, iterated value, body
+	For,
+	// Condition, body
+	While,
+	// Condition, body if true, body if false or none
+	If,
+	// Value or none
+	Return
+};
+
+enum class Operator : uint8_t {
+	None,
+
+	// Upper unary
+	BooleanNot,
+	BinaryNot,
+	Plus,
+	Minus,
+	Increment,
+	Decrement,
+
+	// Arithmetic
+	Multiplication,
+	Division,
+	Modulo,
+	Addition,
+	Subtraction,
+
+	// Binary
+	ShiftedToLeftBy,
+	ShiftedToRightBy,
+	BinaryOr,
+	BinaryXor,
+	BinaryAnd,
+
+	// Comparison
+	EqualTo,
+	DifferentFrom,
+	GreaterThan,
+	LesserThan,
+	GreaterThanOrEqualTo,
+	LesserThanOrEqualTo,
+
+	// Boolean
+	And,
+	Or,
+	Xor,
+
+	// Lower unary
+	Not,
+
+	// Assignment
+	Assign,
+	BackInsert
+};
+
+inline std::string_view getOperatorString(Operator op) {
+	static constexpr std::array<std::string_view, 29> strings = {
+		"",
+		"!", "~", "+", "-", "++", "--",
+		"*", "/", "%", "+", "-",
+		"<<", ">>", "|", "^", "&",
+		"=", "=/=", ">", "<", ">_", "_<",
+		"and", "or", "xor",
+		"not",
+		"<-", "<<-"
+	};
+	static_assert(strings.size() == static_cast<size_t>(Operator::BackInsert) + 1);
+	return strings[static_cast<size_t>(op)];
+}
+
+// Nodes are addressed by index, children always come before their parent
+struct Node {
+	NodeKind kind;
+	Operator op;
+	// Class of the token at `offset`
+	TokenClass tokenClass;
+	// Token the node was built from: the operator of operations, the keyword of statements
+	uint32_t offset;
+	uint32_t sizeInFile;
+	// Meaning depends on `kind`, `Nodes::none` when absent
+	std::array<uint32_t, 3> operands;
+};
+
+static_assert(sizeof(Node) == 24);
+
+// Syntax tree of a single file, as one contiguous array of nodes
+// Variable-size children (arguments, statements, ...) are contiguous ranges of a second array, the lists
+class Ast {
+	const File *m_file;
+	std::pmr::vector<Node> m_nodes;
+	std::pmr::vector<NodeIndex> m_lists;
+	NodeIndex m_root;
+
+	void format(NodeIndex index, const SymbolTable &symbols, std::string &res) const {
+		auto &node = m_nodes[index];
+		auto appendList = [&](uint32_t begin, uint32_t count){
+			for (auto child : getList(begin, count)) {
+				res += ' ';
+				format(child, symbols, res);
+			}
+		};
+		auto appendOperands = [&](size_t count){
+			for (size_t i = 0; i < count; i++) {
+				res += ' ';
+				if (node.operands[i] == Nodes::none)
+					res += "_";
+				else
+					format(node.operands[i], symbols, res);
+			}
+		};
+
+		switch (node.kind) {
+		case NodeKind::Identifier:
+			res += symbols.getSpelling(node.operands[0]);
+			return;
+		case NodeKind::Parameter:
+			if (node.operands[1] != Nodes::none)
+				break;
+			res += symbols.getSpelling(node.operands[0]);
+			return;
+		case NodeKind::NumberLiteral:
+		case NodeKind::StringLiteral:
+			res += getSpelling(index);
+			return;
+		default:
+			break;
+		}
+
+		res += '(';
+		switch (node.kind) {
+		case NodeKind::Member:
+			res += ". ";
+			format(node.operands[0], symbols, res);
+			res += ' ';
+			res += symbols.getSpelling(node.operands[1]);
+			break;
+		case NodeKind::Call:
+			res += "call ";
+			format(node.operands[0], symbols, res);
+			appendList(node.operands[1], node.operands[2]);
+			break;
+		case NodeKind::Subscript:
+			res += "[]";
+			appendOperands(2);
+			break;
+		case NodeKind::Prefix:
+			res += getOperatorString(node.op);
+			appendOperands(1);
+			break;
+		case NodeKind::Postfix:
+			res += "post";
+			res += getOperatorString(node.op);
+			appendOperands(1);
+			break;
+		case NodeKind::Binary:
+		case NodeKind::Comparison:
+			res += getOperatorString(node.op);
+			appendOperands(2);
+			break;
+		case NodeKind::ComparisonChain:
+			res += "chain";
+			appendList(node.operands[0], node.operands[1]);
+			break;
+		case NodeKind::Conditional:
+			res += "if-then-else";
+			appendOperands(3);
+			break;
+		case NodeKind::Assignment:
+			if (node.op != Operator::Assign && node.op != Operator::BackInsert)
+				res += getOperatorString(node.op);
+			res += getOperatorString(node.op == Operator::BackInsert ? Operator::BackInsert : Operator::Assign);
+			appendOperands(2);
+			break;
+		case NodeKind::Function:
+			res += "function (";
+			for (auto parameter : getList(node.operands[0], node.operands[1])) {
+				if (res.back() != '(')
+					res += ' ';
+				format(parameter, symbols, res);
+			}
+			res += ") ";
+			format(node.operands[2], symbols, res);
+			break;
+		case NodeKind::ArrayType:
+			res += "array";
+			appendOperands(2);
+			break;
+		case NodeKind::Parameter:
+			res += ": ";
+			res += symbols.getSpelling(node.operands[0]);
+			res += ' ';
+			format(node.operands[1], symbols, res);
+			break;
+		case NodeKind::Block:
+			res += "block";
+			appendList(node.operands[0], node.operands[1]);
+			break;
+		case NodeKind::For:
+			res += "for ";
+			res += symbols.getSpelling(node.operands[0]);
+			res += ' ';
+			format(node.operands[1], symbols, res);
+			res += ' ';
+			format(node.operands[2], symbols, res);
+			break;
+		case NodeKind::While:
+			res += "while";
+			appendOperands(2);
+			break;
+		case NodeKind::If:
+			res += "if";
+			appendOperands(3);
+			break;
+		case NodeKind::Return:
+			res += "return";
+			appendOperands(1);
+			break;
+		default:
+			break;
+		}
+		res += ')';
+	}
+
+public:
+	// The tree must not outlive `file` nor the memory behind `resource`
+	Ast(const File &file, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) :
+		m_file(&file),
+		m_nodes(resource),
+		m_lists(resource),
+		m_root(Nodes::none) {
+	}
+
+	const File& getFile(void) const {
+		return *m_file;
+	}
+
+	NodeIndex add(NodeKind kind, Operator op, const Token &token, uint32_t first = Nodes::none, uint32_t second = Nodes::none, uint32_t third = Nodes::none) {
+		auto res = static_cast<NodeIndex>(m_nodes.size());
+		m_nodes.push_back(Node{kind, op, token.getClass(), static_cast<uint32_t>(token.getOffset()), static_cast<uint32_t>(token.getSizeInFile()), {first, second, third}});
+		return res;
+	}
+
+	// Copies `children` to the lists, returns the index of the first one there
+	uint32_t addList(std::span<const NodeIndex> children) {
+		auto res = static_cast<uint32_t>(m_lists.size());
+		m_lists.insert(m_lists.end(), children.begin(), children.end());
+		return res;
+	}
+
+	const Node& operator[](NodeIndex index) const {
+		return m_nodes[index];
+	}
+
+	std::span<const NodeIndex> getList(uint32_t begin, uint32_t count) const {
+		return std::span<const NodeIndex>(m_lists.data() + begin, count);
+	}
+
+	size_t size(void) const {
+		return m_nodes.size();
+	}
+
+	// Top-level `Block` of the file
+	NodeIndex getRoot(void) const {
+		return m_root;
+	}
+	void setRoot(NodeIndex root) {
+		m_root = root;
+	}
+
+	// For diagnostics
+	Token getToken(NodeIndex index) const {
+		auto &node = m_nodes[index];
+		return Token(*m_file, node.tokenClass, node.offset, node.sizeInFile);
+	}
+
+	// Source text of the node's token, string literals along with their delimiters
+	std::string_view getSpelling(NodeIndex index) const {
+		auto &node = m_nodes[index];
+		return m_file->getBytes().substr(node.offset, node.sizeInFile);
+	}
+
+	// S-expression of the subtree, for debugging and tests
+	std::string format(NodeIndex index, const SymbolTable &symbols) const {
+		std::string res;
+		format(index, symbols, res);
+		return res;
+	}
+};
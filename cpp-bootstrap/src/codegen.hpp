@@ -0,0 +1,1629 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bitset>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "token.hpp"
+#include "ast.hpp"
+#include "program.hpp"
+#include "peephole.hpp"
+#include "evaluator.hpp"
+#include "analysis.hpp"
+
+// Semantic error, reported with a diagnostic pointing at the token of `getNode()` by `CodeGenerator::generate`
+class CompileError : public std::runtime_error {
+	NodeIndex m_node;
+
+public:
+	CompileError(NodeIndex node, const std::string &message) :
+		std::runtime_error(message),
+		m_node(node) {
+	}
+
+	NodeIndex getNode(void) const {
+		return m_node;
+	}
+};
+
+// Lowers an `Ast` to the register bytecode of a `Program`
+// Every variable lives in a register of its function frame, its type being the one of its first assignment
+// Functions are templates: each call site with new argument types compiles a new specialization
+// Expressions whose value can be computed at compile time are, by `Evaluator`, and loops over `count` of such a value are unrolled
+class CodeGenerator {
+	// Value computed by an expression
+	struct Operand {
+		uint8_t reg;
+		ValueType type;
+		// Known at compile time
+		std::optional<Value> constant = std::nullopt;
+	};
+
+	// What a name stands for, bindings are stacked in scope order
+	struct Binding {
+		enum class Kind : uint8_t {
+			Variable,
+			// `function` literal, compiled on call
+			Function
+		};
+
+		Kind kind;
+		ValueType type;
+		uint8_t reg;
+		// Iterator variables cannot be assigned
+		bool isReadOnly;
+		Symbol symbol;
+		// Index of the binding of the same name this one shadows, `noBinding` if none
+		uint32_t shadowed;
+		// Function context the variable belongs to
+		uint32_t context;
+		// For functions
+		NodeIndex node;
+		// For functions: bindings below this index were in scope at the definition
+		uint32_t visibleBindingCount;
+		// For variables assigned once by the program, if their value is known at compile time
+		std::optional<Value> constant = std::nullopt;
+		// Iterators of unrolled loops are only constants
+		bool hasRegister = true;
+		// Never assigned once bound, so its value is the same wherever it is in scope
+		bool isInvariant = false;
+		// For arrays
+		ValueType elementType = ValueType::Integer;
+	};
+
+	static constexpr uint32_t noBinding = 0xFFFFFFFF;
+
+	// A function being compiled, the entry point or a specialization
+	struct Context {
+		uint32_t functionIndex;
+		std::vector<Instruction> code;
+		std::vector<SourceLocation> sourceLocations;
+		// By instruction
+		std::vector<Annotation> annotations;
+		// First free register, registers above it are free and below it are variables or live temporaries
+		uint32_t registerTop;
+		uint32_t registerCount;
+		// Set by the first `return` of a value
+		std::optional<ValueType> returnType;
+		// Set by a `return` without a value
+		bool isReturningNothing;
+		// Bindings of the function start there, those below come from its definition scope
+		uint32_t bindingBase;
+		uint32_t visibleBindingCount;
+		// Upper bound on the executions of what is being compiled, `Annotation::unknownCount` if none is known
+		uint64_t executionCount;
+		// By register, the value of the constant variable it holds
+		std::vector<std::optional<Value>> registerConstants = std::vector<std::optional<Value>>(Instruction::maxRegisterCount);
+		std::vector<ValueType> parameterTypes = {};
+		// Statement the function runs, whose arrays are popped by returning
+		NodeIndex body = Nodes::none;
+	};
+
+	struct Specialization {
+		uint32_t functionIndex;
+		// Unset until known from a `return`, or if it returns nothing
+		std::optional<ValueType> returnType;
+		bool isCompiled;
+	};
+
+	// Loop enclosing back-insertions being counted
+	struct CountedLoop {
+		NodeIndex node;
+		// Once compiled at the declaration of the array: at least the number of iterations, none if negative
+		std::optional<Operand> limit;
+	};
+
+	// Back-insertions into an array, counted over its scope
+	struct InsertionCount {
+		Symbol array;
+		// Where the code computing the size is emitted
+		NodeIndex declaration;
+		// Loops enclosing the statement being counted, outermost first
+		std::vector<CountedLoop> loops;
+		// Sum of the counts only known at runtime, once there is one
+		std::optional<uint8_t> sum;
+	};
+
+	const Ast *m_ast;
+	const SymbolTable *m_symbols;
+	const NumberTable *m_numbers;
+	Program *m_program;
+	std::vector<Binding> m_bindings;
+	// By symbol, last binding of the name, `noBinding` if unbound
+	std::vector<uint32_t> m_latestBindings;
+	std::vector<Context> m_contexts;
+	// By function node and argument types
+	std::map<std::pair<NodeIndex, std::vector<ValueType>>, Specialization> m_specializations;
+	std::map<std::pair<ValueType, Value>, uint32_t> m_constantIndices;
+	std::map<std::string, uint32_t, std::less<>> m_stringIndices;
+	// Builtin names, only meaningful when not bound by the program
+	std::optional<Symbol> m_stdOut;
+	std::optional<Symbol> m_endLine;
+	std::optional<Symbol> m_count;
+	// By symbol, how many times the program assigns variables of that name, declarations included
+	std::vector<uint32_t> m_assignmentCounts;
+	Evaluator m_evaluator;
+	// Statement of a `Block` being compiled and those following it there, the scope of the array it may declare
+	NodeIndex m_blockStatement;
+	std::span<const NodeIndex> m_followingStatements;
+
+	CodeGenerator(const Ast &ast, const SymbolTable &symbols, const NumberTable &numbers, const EvaluationBudget &budget, Program &program) :
+		m_ast(&ast),
+		m_symbols(&symbols),
+		m_numbers(&numbers),
+		m_program(&program),
+		m_latestBindings(symbols.size(), noBinding),
+		m_stdOut(symbols.find("std_out")),
+		m_endLine(symbols.find("end_line")),
+		m_count(symbols.find("count")),
+		m_assignmentCounts(symbols.size(), 0),
+		m_evaluator(program, budget),
+		m_blockStatement(Nodes::none) {
+		for (NodeIndex i = 0; i < ast.size(); i++) {
+			auto &node = ast[i];
+			bool isAssigning = (node.kind == NodeKind::Assignment && node.op != Operator::BackInsert) || node.kind == NodeKind::Postfix
+				|| (node.kind == NodeKind::Prefix && (node.op == Operator::Increment || node.op == Operator::Decrement));
+			if (isAssigning && ast[node.operands[0]].kind == NodeKind::Identifier)
+				m_assignmentCounts[ast[node.operands[0]].operands[0]]++;
+		}
+	}
+
+	const Node& getNode(NodeIndex index) const {
+		return (*m_ast)[index];
+	}
+
+	std::string getName(Symbol symbol) const {
+		// Appended rather than concatenated, which GCC 12 misreports as an overlapping copy once inlined
+		auto res = std::string("`");
+		res += m_symbols->getSpelling(symbol);
+		res += '`';
+		return res;
+	}
+
+	Context& getContext(void) {
+		return m_contexts.back();
+	}
+
+	// Bindings
+
+	// Binding of `symbol` visible from the current function, if any
+	const Binding* find(Symbol symbol) const {
+		auto &context = m_contexts.back();
+		for (auto index = m_latestBindings[symbol]; index != noBinding; index = m_bindings[index].shadowed)
+			if (index >= context.bindingBase || index < context.visibleBindingCount)
+				return &m_bindings[index];
+		return nullptr;
+	}
+
+	bool isBuiltin(Symbol symbol, const std::optional<Symbol> &builtin) const {
+		return builtin.has_value() && symbol == *builtin && find(symbol) == nullptr;
+	}
+
+	void bind(const Binding &binding) {
+		m_bindings.emplace_back(binding);
+		m_bindings.back().shadowed = m_latestBindings[binding.symbol];
+		m_latestBindings[binding.symbol] = static_cast<uint32_t>(m_bindings.size() - 1);
+	}
+
+	// A constant operand makes a constant variable, which must not be assigned again
+	void bindVariable(Symbol symbol, Operand operand, bool isReadOnly = false, bool isInvariant = false) {
+		bind(Binding{Binding::Kind::Variable, operand.type, operand.reg, isReadOnly, symbol, noBinding,
+			static_cast<uint32_t>(m_contexts.size() - 1), Nodes::none, 0, operand.constant, true, isReadOnly || isInvariant});
+		if (operand.constant.has_value())
+			getContext().registerConstants[operand.reg] = operand.constant;
+	}
+
+	// Iterator of an unrolled loop
+	void bindConstant(Symbol symbol, ValueType type, Value value) {
+		bind(Binding{Binding::Kind::Variable, type, 0, true, symbol, noBinding,
+			static_cast<uint32_t>(m_contexts.size() - 1), Nodes::none, 0, value, false, true});
+	}
+
+	// Drops the bindings made since `bindingCount`
+	void unbindTo(size_t bindingCount) {
+		while (m_bindings.size() > bindingCount) {
+			auto &binding = m_bindings.back();
+			if (binding.constant.has_value() && binding.hasRegister && binding.context < m_contexts.size())
+				m_contexts[binding.context].registerConstants[binding.reg].reset();
+			m_latestBindings[binding.symbol] = binding.shadowed;
+			m_bindings.pop_back();
+		}
+	}
+
+	// Emission
+
+	uint8_t allocateRegister(NodeIndex node) {
+		auto &context = getContext();
+		if (context.registerTop >= Instruction::maxRegisterCount)
+			throw CompileError(node, "more than " + std::to_string(Instruction::maxRegisterCount) + " registers are live in "
+				+ m_program->getFunction(context.functionIndex).name);
+		auto res = static_cast<uint8_t>(context.registerTop++);
+		context.registerCount = std::max(context.registerCount, context.registerTop);
+		return res;
+	}
+
+	uint8_t getDestination(std::optional<uint8_t> destination, NodeIndex node) {
+		return destination.has_value() ? *destination : allocateRegister(node);
+	}
+
+	// Type of the register written by the instruction, unset if it depends on the operands or nothing is written
+	std::optional<ValueType> getWrittenType(Instruction instruction) const {
+		switch (instruction.getOpcode()) {
+		case Opcode::LoadInteger:
+		case Opcode::AddInteger:
+		case Opcode::SubtractInteger:
+		case Opcode::MultiplyInteger:
+		case Opcode::DivideInteger:
+		case Opcode::ModuloInteger:
+		case Opcode::AddIntegerImmediate:
+		case Opcode::NegateInteger:
+		case Opcode::ShiftLeft:
+		case Opcode::ShiftRight:
+		case Opcode::BinaryNot:
+		case Opcode::MultiplyCount:
+		case Opcode::AddCount:
+			return ValueType::Integer;
+		case Opcode::LoadConstant:
+			return m_program->getConstantType(instruction.getBx());
+		case Opcode::LoadString:
+			return ValueType::String;
+		case Opcode::IntegerToReal:
+		case Opcode::AddReal:
+		case Opcode::SubtractReal:
+		case Opcode::MultiplyReal:
+		case Opcode::DivideReal:
+		case Opcode::ModuloReal:
+		case Opcode::NegateReal:
+			return ValueType::Real;
+		case Opcode::BooleanNot:
+		case Opcode::EqualInteger:
+		case Opcode::DifferentInteger:
+		case Opcode::LesserInteger:
+		case Opcode::LesserOrEqualInteger:
+		case Opcode::EqualReal:
+		case Opcode::DifferentReal:
+		case Opcode::LesserReal:
+		case Opcode::LesserOrEqualReal:
+			return ValueType::Bool;
+		case Opcode::NewArray:
+			return ValueType::Array;
+		default:
+			return std::nullopt;
+		}
+	}
+
+	// Returns the index of the instruction within the current function
+	// `writtenType` is only needed when `getWrittenType` cannot tell
+	size_t emit(Instruction instruction, NodeIndex node, std::optional<ValueType> writtenType = std::nullopt) {
+		auto &context = getContext();
+		auto &source = getNode(node);
+		auto &file = m_ast->getFile();
+		auto line = static_cast<uint32_t>(file.getLineAt(source.offset));
+		auto column = static_cast<uint32_t>(file.getColumnAt(source.offset));
+		auto &locations = context.sourceLocations;
+		if (locations.empty() || locations.back().line != line || locations.back().column != column)
+			locations.emplace_back(SourceLocation{static_cast<uint32_t>(context.code.size()), line, column});
+		context.code.emplace_back(instruction);
+
+		// Ranges are left to `RangeAnalysis`, once the function is complete
+		auto annotation = Annotation{0, false, 0, 0, context.executionCount};
+		if (!writtenType.has_value())
+			writtenType = getWrittenType(instruction);
+		if (writtenType.has_value())
+			annotation.typeSet = 1 << static_cast<size_t>(*writtenType);
+		context.annotations.emplace_back(annotation);
+		return context.code.size() - 1;
+	}
+
+	// Jumps are emitted before their target is known, then patched
+	size_t emitJump(Opcode opcode, NodeIndex node, uint8_t condition = 0) {
+		if (opcode == Opcode::Jump)
+			return emit(Instruction::makeJump(opcode, 0), node);
+		return emit(Instruction::makeSignedWide(opcode, condition, 0), node);
+	}
+
+	size_t getNextInstructionIndex(void) {
+		return getContext().code.size();
+	}
+
+	// Drops the instructions from `instructionCount` onwards, none of them must be a jump target
+	void truncateTo(size_t instructionCount) {
+		auto &context = getContext();
+		context.code.resize(instructionCount);
+		context.annotations.resize(instructionCount);
+		while (!context.sourceLocations.empty() && context.sourceLocations.back().instructionIndex >= instructionCount)
+			context.sourceLocations.pop_back();
+	}
+
+	void patchJump(size_t jumpIndex, size_t targetIndex, NodeIndex node) {
+		auto &instruction = getContext().code[jumpIndex];
+		auto offset = static_cast<int64_t>(targetIndex) - static_cast<int64_t>(jumpIndex) - 1;
+		auto maxOffset = instruction.getOpcode() == Opcode::Jump ? Instruction::maxSignedAx : Instruction::maxSignedBx;
+		if (offset < -maxOffset - 1 || offset > maxOffset)
+			throw CompileError(node, "branch spans more than " + std::to_string(maxOffset) + " instructions");
+		if (instruction.getOpcode() == Opcode::Jump)
+			instruction.setSignedAx(static_cast<int32_t>(offset));
+		else
+			instruction.setSignedBx(static_cast<int32_t>(offset));
+	}
+
+	uint32_t getConstantIndex(ValueType type, Value value, NodeIndex node) {
+		auto [found, isInserted] = m_constantIndices.try_emplace({type, value}, 0);
+		if (isInserted)
+			found->second = m_program->addConstant(type, value);
+		if (found->second > 0xFFFF)
+			throw CompileError(node, "more than 65536 constants in the program");
+		return found->second;
+	}
+
+	uint32_t getStringIndex(std::string_view string, NodeIndex node) {
+		auto found = m_stringIndices.find(string);
+		if (found == m_stringIndices.end())
+			found = m_stringIndices.emplace(std::string(string), m_program->addString(string)).first;
+		if (found->second > 0xFFFF)
+			throw CompileError(node, "more than 65536 strings in the program");
+		return found->second;
+	}
+
+	void emitLoadInteger(uint8_t destination, int64_t value, NodeIndex node) {
+		if (value >= -Instruction::maxSignedBx - 1 && value <= Instruction::maxSignedBx)
+			emit(Instruction::makeSignedWide(Opcode::LoadInteger, destination, static_cast<int32_t>(value)), node);
+		else
+			emit(Instruction::makeWide(Opcode::LoadConstant, destination, getConstantIndex(ValueType::Integer, static_cast<Value>(value), node)), node);
+	}
+
+	// Strings are their index in the program, bools are 0 or 1
+	Operand emitConstant(uint8_t destination, ValueType type, Value value, NodeIndex node) {
+		switch (type) {
+		case ValueType::Integer:
+			emitLoadInteger(destination, static_cast<int64_t>(value), node);
+			break;
+		case ValueType::Real:
+			emit(Instruction::makeWide(Opcode::LoadConstant, destination, getConstantIndex(ValueType::Real, value, node)), node);
+			break;
+		case ValueType::Bool:
+			emit(Instruction::makeSignedWide(Opcode::LoadInteger, destination, value != 0 ? 1 : 0), node, ValueType::Bool);
+			break;
+		case ValueType::String:
+			emit(Instruction::makeWide(Opcode::LoadString, destination, static_cast<uint16_t>(value)), node);
+			break;
+		// Never constant
+		case ValueType::Array:
+			break;
+		}
+		return Operand{destination, type, value};
+	}
+
+	// Types
+
+	static bool isNumeric(ValueType type) {
+		return type == ValueType::Integer || type == ValueType::Real;
+	}
+
+	std::string describe(ValueType type) {
+		return "a value of type " + std::string(getValueTypeName(type));
+	}
+
+	// Converts an integer operand to a real in a new temporary
+	Operand promote(Operand operand, NodeIndex node) {
+		auto res = Operand{allocateRegister(node), ValueType::Real};
+		emit(Instruction::make(Opcode::IntegerToReal, res.reg, operand.reg), node);
+		return res;
+	}
+
+	// Makes the operand of type `type` in `destination`, or in place when not given and already of that type
+	Operand convert(Operand operand, ValueType type, std::optional<uint8_t> destination, NodeIndex node, const std::string &what) {
+		if (operand.type == type) {
+			if (destination.has_value() && *destination != operand.reg)
+				emit(Instruction::make(Opcode::Move, *destination, operand.reg), node, type);
+			return Operand{destination.value_or(operand.reg), type, operand.constant};
+		}
+		if (operand.type == ValueType::Integer && type == ValueType::Real) {
+			auto res = Operand{getDestination(destination, node), ValueType::Real};
+			emit(Instruction::make(Opcode::IntegerToReal, res.reg, operand.reg), node);
+			return res;
+		}
+		throw CompileError(node, what + " expects " + describe(type) + ", got " + describe(operand.type));
+	}
+
+	// Expressions
+
+	// Whether the expression writes its destination with its very last instruction, after reading all of its operands
+	// Those can be built straight into a variable which they read
+	bool isWrittenLast(NodeIndex index) const {
+		auto &node = getNode(index);
+		switch (node.kind) {
+		case NodeKind::Identifier:
+		case NodeKind::NumberLiteral:
+		case NodeKind::StringLiteral:
+		case NodeKind::Binary:
+		case NodeKind::Comparison:
+		case NodeKind::Call:
+		case NodeKind::Subscript:
+			return true;
+		case NodeKind::Prefix:
+			return node.op != Operator::Increment && node.op != Operator::Decrement;
+		default:
+			return false;
+		}
+	}
+
+	// Result goes to `destination` if given, otherwise to a new temporary unless it is already in a register
+	// Temporaries may be left allocated, the enclosing statement releases them
+	Operand compileExpression(NodeIndex index, std::optional<uint8_t> destination = std::nullopt) {
+		auto begin = getNextInstructionIndex();
+		auto top = getContext().registerTop;
+		auto res = compileOperation(index, destination);
+		if (res.constant.has_value() || getNextInstructionIndex() == begin)
+			return res;
+		return fold(index, res, begin, top);
+	}
+
+	// Replaces the code of the expression, from `begin`, by the load of its value if it can be computed now
+	// The code must only read registers it wrote before or holding constant variables, and only write its result or temporaries from `top`
+	Operand fold(NodeIndex index, Operand res, size_t begin, uint32_t top) {
+		auto &context = getContext();
+		// Registers whose value is known to the evaluation
+		std::bitset<Instruction::maxRegisterCount> known;
+		std::vector<std::pair<uint8_t, Value>> inputs;
+		bool isFoldable = true;
+		for (size_t i = begin; i < context.code.size() && isFoldable; i++) {
+			auto instruction = context.code[i];
+			m_program->forEachReadRegister(instruction, [&](uint8_t reg){
+				if (known.test(reg))
+					return;
+				auto &constant = context.registerConstants[reg];
+				if (!constant.has_value()) {
+					isFoldable = false;
+					return;
+				}
+				known.set(reg);
+				inputs.emplace_back(reg, *constant);
+			});
+			if (instruction.isWritingA()) {
+				if (instruction.getA() < top && instruction.getA() != res.reg)
+					isFoldable = false;
+				known.set(instruction.getA());
+			}
+		}
+		if (!isFoldable)
+			return res;
+
+		std::vector<Instruction> code(context.code.begin() + static_cast<ptrdiff_t>(begin), context.code.end());
+		code.emplace_back(Instruction::make(Opcode::Return, res.reg));
+		auto value = m_evaluator.evaluate(code, inputs);
+		if (!value.has_value())
+			return res;
+		truncateTo(begin);
+		return emitConstant(res.reg, res.type, *value, index);
+	}
+
+	Operand compileOperation(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		switch (node.kind) {
+		case NodeKind::Identifier:
+			return compileIdentifier(index, destination);
+		case NodeKind::NumberLiteral:
+			return compileNumber(index, destination);
+		case NodeKind::StringLiteral:
+			return emitConstant(getDestination(destination, index), ValueType::String, getStringIndex(m_ast->getToken(index).getString(), index), index);
+		case NodeKind::Prefix:
+			return compilePrefix(index, destination);
+		case NodeKind::Postfix:
+			return compilePostfix(index, destination);
+		case NodeKind::Binary:
+			return compileBinary(index, destination);
+		case NodeKind::Comparison:
+			return compileComparison(index, destination);
+		case NodeKind::ComparisonChain:
+			return compileComparisonChain(index, destination);
+		case NodeKind::Conditional:
+			return compileConditional(index, destination);
+		case NodeKind::Assignment: {
+			auto res = compileAssignment(index, false);
+			return convert(res, res.type, destination, index, "assignment");
+		}
+		case NodeKind::Call:
+			return compileCall(index, destination, true);
+		case NodeKind::Function:
+			throw CompileError(index, "functions must be named by an assignment statement");
+		case NodeKind::Subscript:
+			return compileSubscript(index, destination);
+		case NodeKind::Member:
+			throw CompileError(index, "member access is not supported by the bytecode yet");
+		default:
+			throw CompileError(index, "expected an expression");
+		}
+	}
+
+	Operand compileIdentifier(NodeIndex index, std::optional<uint8_t> destination) {
+		auto symbol = getNode(index).operands[0];
+		auto binding = find(symbol);
+		if (binding == nullptr) {
+			if (isBuiltin(symbol, m_stdOut) || isBuiltin(symbol, m_endLine))
+				throw CompileError(index, getName(symbol) + " can only be used along with `<<-`");
+			throw CompileError(index, "unknown name " + getName(symbol));
+		}
+		if (binding->kind == Binding::Kind::Function)
+			throw CompileError(index, getName(symbol) + " is a function, it can only be called");
+		if (binding->context != m_contexts.size() - 1)
+			throw CompileError(index, getName(symbol) + " belongs to an enclosing function, which is not supported yet");
+		// Arrays lie on the runtime stack of their frame, popped as their scope ends: no reference to one can be taken,
+		// so none outlives it, and nothing checks liveness at runtime
+		if (binding->type == ValueType::Array)
+			throw CompileError(index, getName(symbol) + " is an array, only its elements and back-insertion into it are supported for now");
+		if (!binding->hasRegister)
+			return emitConstant(getDestination(destination, index), binding->type, *binding->constant, index);
+		return convert(Operand{binding->reg, binding->type, binding->constant}, binding->type, destination, index, "");
+	}
+
+	Operand compileNumber(NodeIndex index, std::optional<uint8_t> destination) {
+		auto literal = (*m_numbers)[getNode(index).operands[0]];
+		auto reg = getDestination(destination, index);
+		if (!literal.isInteger() || literal.isFractional())
+			return emitConstant(reg, ValueType::Real, std::bit_cast<Value>(literal.getReal()), index);
+		if (literal.getInteger().getBitWidth() > 63)
+			throw CompileError(index, "numeric literal does not fit in 64-bit integers, the widest of the bytecode");
+		return emitConstant(reg, ValueType::Integer, literal.getInteger().getLimb(0), index);
+	}
+
+	Operand compilePrefix(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		if (node.op == Operator::Increment || node.op == Operator::Decrement) {
+			auto res = compileIncrement(index, node.operands[0]);
+			return convert(res, res.type, destination, index, "");
+		}
+
+		auto top = getContext().registerTop;
+		auto operand = compileExpression(node.operands[0]);
+		auto name = "`" + std::string(getOperatorString(node.op)) + "`";
+		Opcode opcode;
+		switch (node.op) {
+		case Operator::Plus:
+			if (!isNumeric(operand.type))
+				throw CompileError(index, name + " expects a number, got " + describe(operand.type));
+			return convert(operand, operand.type, destination, index, "");
+		case Operator::Minus:
+			if (!isNumeric(operand.type))
+				throw CompileError(index, name + " expects a number, got " + describe(operand.type));
+			opcode = operand.type == ValueType::Integer ? Opcode::NegateInteger : Opcode::NegateReal;
+			break;
+		case Operator::BinaryNot:
+			if (operand.type != ValueType::Integer)
+				throw CompileError(index, name + " expects " + describe(ValueType::Integer) + ", got " + describe(operand.type));
+			opcode = Opcode::BinaryNot;
+			break;
+		default:
+			if (operand.type != ValueType::Bool)
+				throw CompileError(index, name + " expects " + describe(ValueType::Bool) + ", got " + describe(operand.type));
+			opcode = Opcode::BooleanNot;
+			break;
+		}
+		getContext().registerTop = top;
+		auto res = Operand{getDestination(destination, index), operand.type};
+		emit(Instruction::make(opcode, res.reg, operand.reg), index);
+		return res;
+	}
+
+	// Variable named by `target`, which is about to be assigned
+	Binding getAssignedVariable(NodeIndex target) {
+		auto &node = getNode(target);
+		if (node.kind != NodeKind::Identifier)
+			throw CompileError(target, "only variables can be assigned for now");
+		auto binding = find(node.operands[0]);
+		if (binding == nullptr)
+			throw CompileError(target, "unknown name " + getName(node.operands[0]));
+		if (binding->kind != Binding::Kind::Variable)
+			throw CompileError(target, getName(node.operands[0]) + " is a function, it cannot be assigned");
+		if (binding->context != m_contexts.size() - 1)
+			throw CompileError(target, getName(node.operands[0]) + " belongs to an enclosing function, which is not supported yet");
+		if (binding->isReadOnly)
+			throw CompileError(target, getName(node.operands[0]) + " is an iterator variable, it cannot be assigned");
+		if (binding->type == ValueType::Array)
+			throw CompileError(target, getName(node.operands[0]) + " is an array, it cannot be assigned");
+		return *binding;
+	}
+
+	// `++` or `--` on the variable `target`, returns the variable
+	Operand compileIncrement(NodeIndex index, NodeIndex target) {
+		auto variable = getAssignedVariable(target);
+		auto res = Operand{variable.reg, variable.type};
+		int8_t amount = getNode(index).op == Operator::Increment ? 1 : -1;
+		if (res.type == ValueType::Integer)
+			emit(Instruction::make(Opcode::AddIntegerImmediate, res.reg, res.reg, static_cast<uint8_t>(amount)), index);
+		else if (res.type == ValueType::Real) {
+			auto top = getContext().registerTop;
+			auto one = allocateRegister(index);
+			emit(Instruction::makeWide(Opcode::LoadConstant, one, getConstantIndex(ValueType::Real, std::bit_cast<Value>(static_cast<double>(amount)), index)), index);
+			emit(Instruction::make(Opcode::AddReal, res.reg, res.reg, one), index);
+			getContext().registerTop = top;
+		} else
+			throw CompileError(index, "`" + std::string(getOperatorString(getNode(index).op)) + "` expects a number, got " + describe(res.type));
+		return res;
+	}
+
+	// The value before the increment is copied first
+	Operand compilePostfix(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		auto variable = getAssignedVariable(node.operands[0]);
+		auto res = Operand{getDestination(destination, index), variable.type};
+		emit(Instruction::make(Opcode::Move, res.reg, variable.reg), index, variable.type);
+		compileIncrement(index, node.operands[0]);
+		return res;
+	}
+
+	// Emits `op` over two operands already in registers, an integer along with a real is promoted
+	// Temporaries from `resetTop` onwards are released before allocating the destination, which only the last instruction writes
+	Operand emitBinary(NodeIndex index, Operator op, Operand lhs, Operand rhs, std::optional<uint8_t> destination, uint32_t resetTop) {
+		auto name = "`" + std::string(getOperatorString(op)) + "`";
+		auto type = lhs.type;
+		Opcode opcode;
+		switch (op) {
+		case Operator::Multiplication:
+		case Operator::Division:
+		case Operator::Modulo:
+		case Operator::Addition:
+		case Operator::Subtraction: {
+			static constexpr std::array<Opcode, 5> integerOpcodes = {Opcode::MultiplyInteger, Opcode::DivideInteger, Opcode::ModuloInteger, Opcode::AddInteger, Opcode::SubtractInteger};
+			static constexpr std::array<Opcode, 5> realOpcodes = {Opcode::MultiplyReal, Opcode::DivideReal, Opcode::ModuloReal, Opcode::AddReal, Opcode::SubtractReal};
+			if (!isNumeric(lhs.type) || !isNumeric(rhs.type))
+				throw CompileError(index, name + " expects numbers, got " + describe(lhs.type) + " and " + describe(rhs.type));
+			if (lhs.type != rhs.type) {
+				type = ValueType::Real;
+				if (lhs.type == ValueType::Integer)
+					lhs = promote(lhs, index);
+				else
+					rhs = promote(rhs, index);
+			}
+			if (auto immediate = getImmediate(op, lhs, rhs); immediate.has_value()) {
+				// The constant needs no register when just loaded in a temporary
+				auto &code = getContext().code;
+				auto last = code.back().getOpcode();
+				if (rhs.reg >= resetTop && (last == Opcode::LoadInteger || last == Opcode::LoadConstant) && code.back().getA() == rhs.reg)
+					truncateTo(code.size() - 1);
+				getContext().registerTop = resetTop;
+				auto res = Operand{getDestination(destination, index), ValueType::Integer};
+				if (*immediate != 0 || res.reg != lhs.reg)
+					emit(Instruction::make(Opcode::AddIntegerImmediate, res.reg, lhs.reg, static_cast<uint8_t>(*immediate)), index);
+				return res;
+			}
+			auto opcodeIndex = static_cast<size_t>(op) - static_cast<size_t>(Operator::Multiplication);
+			opcode = type == ValueType::Integer ? integerOpcodes[opcodeIndex] : realOpcodes[opcodeIndex];
+			break;
+		}
+		case Operator::ShiftedToLeftBy:
+		case Operator::ShiftedToRightBy:
+			if (lhs.type != ValueType::Integer || rhs.type != ValueType::Integer)
+				throw CompileError(index, name + " expects integers, got " + describe(lhs.type) + " and " + describe(rhs.type));
+			opcode = op == Operator::ShiftedToLeftBy ? Opcode::ShiftLeft : Opcode::ShiftRight;
+			break;
+		case Operator::BinaryOr:
+		case Operator::BinaryXor:
+		case Operator::BinaryAnd:
+		case Operator::And:
+		case Operator::Or:
+		case Operator::Xor: {
+			bool isBoolean = op == Operator::And || op == Operator::Or || op == Operator::Xor;
+			bool isAccepted = lhs.type == rhs.type && (lhs.type == ValueType::Bool || (!isBoolean && lhs.type == ValueType::Integer));
+			if (!isAccepted)
+				throw CompileError(index, name + " expects " + (isBoolean ? "bools" : "integers or bools") + ", got " + describe(lhs.type) + " and " + describe(rhs.type));
+			if (op == Operator::BinaryOr || op == Operator::Or)
+				opcode = Opcode::BinaryOr;
+			else if (op == Operator::BinaryXor || op == Operator::Xor)
+				opcode = Opcode::BinaryXor;
+			else
+				opcode = Opcode::BinaryAnd;
+			break;
+		}
+		default:
+			throw CompileError(index, "unexpected operator " + name);
+		}
+		getContext().registerTop = resetTop;
+		auto res = Operand{getDestination(destination, index), type};
+		emit(Instruction::make(opcode, res.reg, lhs.reg, rhs.reg), index, type);
+		return res;
+	}
+
+	// Constant right operand of an integer addition or subtraction which fits the immediate of `AddIntegerImmediate`, negated for subtractions
+	static std::optional<int8_t> getImmediate(Operator op, Operand lhs, Operand rhs) {
+		if ((op != Operator::Addition && op != Operator::Subtraction) || lhs.type != ValueType::Integer || rhs.type != ValueType::Integer
+			|| !rhs.constant.has_value())
+			return std::nullopt;
+		auto value = static_cast<int64_t>(*rhs.constant);
+		if (value < -Instruction::maxSignedC || value > Instruction::maxSignedC)
+			return std::nullopt;
+		return static_cast<int8_t>(op == Operator::Addition ? value : -value);
+	}
+
+	Operand compileBinary(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		auto top = getContext().registerTop;
+		auto lhs = compileExpression(node.operands[0]);
+		auto rhs = compileExpression(node.operands[1]);
+		return emitBinary(index, node.op, lhs, rhs, destination, top);
+	}
+
+	// Like `emitBinary`, greater-than comparisons swap their operands
+	Operand emitComparison(NodeIndex index, Operator op, Operand lhs, Operand rhs, std::optional<uint8_t> destination, uint32_t resetTop) {
+		bool isOrdering = op != Operator::EqualTo && op != Operator::DifferentFrom;
+		bool isReal = false;
+		if (isNumeric(lhs.type) && isNumeric(rhs.type)) {
+			isReal = lhs.type == ValueType::Real || rhs.type == ValueType::Real;
+			if (lhs.type == ValueType::Integer && isReal)
+				lhs = promote(lhs, index);
+			else if (rhs.type == ValueType::Integer && isReal)
+				rhs = promote(rhs, index);
+		} else if (isOrdering || lhs.type != ValueType::Bool || rhs.type != ValueType::Bool)
+			throw CompileError(index, "`" + std::string(getOperatorString(op)) + "` cannot compare " + describe(lhs.type) + " and " + describe(rhs.type));
+
+		Opcode opcode;
+		switch (op) {
+		case Operator::EqualTo:
+			opcode = isReal ? Opcode::EqualReal : Opcode::EqualInteger;
+			break;
+		case Operator::DifferentFrom:
+			opcode = isReal ? Opcode::DifferentReal : Opcode::DifferentInteger;
+			break;
+		case Operator::GreaterThan:
+			std::swap(lhs, rhs);
+			opcode = isReal ? Opcode::LesserReal : Opcode::LesserInteger;
+			break;
+		case Operator::LesserThan:
+			opcode = isReal ? Opcode::LesserReal : Opcode::LesserInteger;
+			break;
+		case Operator::GreaterThanOrEqualTo:
+			std::swap(lhs, rhs);
+			opcode = isReal ? Opcode::LesserOrEqualReal : Opcode::LesserOrEqualInteger;
+			break;
+		default:
+			opcode = isReal ? Opcode::LesserOrEqualReal : Opcode::LesserOrEqualInteger;
+			break;
+		}
+		getContext().registerTop = resetTop;
+		auto res = Operand{getDestination(destination, index), ValueType::Bool};
+		emit(Instruction::make(opcode, res.reg, lhs.reg, rhs.reg), index);
+		return res;
+	}
+
+	Operand compileComparison(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		auto top = getContext().registerTop;
+		auto lhs = compileExpression(node.operands[0]);
+		auto rhs = compileExpression(node.operands[1]);
+		return emitComparison(index, node.op, lhs, rhs, destination, top);
+	}
+
+	// Shared operands are evaluated once, the results of the links are combined with `and`
+	Operand compileComparisonChain(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		auto res = Operand{getDestination(destination, index), ValueType::Bool};
+		auto links = m_ast->getList(node.operands[0], node.operands[1]);
+		auto lhs = compileExpression(getNode(links[0]).operands[0]);
+		for (size_t i = 0; i < links.size(); i++) {
+			auto &link = getNode(links[i]);
+			auto linkTop = getContext().registerTop;
+			auto rhs = compileExpression(link.operands[1]);
+			auto rhsTop = getContext().registerTop;
+			if (i == 0)
+				emitComparison(links[i], link.op, lhs, rhs, res.reg, rhsTop);
+			else {
+				auto result = emitComparison(links[i], link.op, lhs, rhs, std::nullopt, rhsTop);
+				emit(Instruction::make(Opcode::BinaryAnd, res.reg, res.reg, result.reg), links[i], ValueType::Bool);
+			}
+			// The right operand is the left one of the next link
+			getContext().registerTop = std::max(linkTop, rhsTop);
+			lhs = rhs;
+		}
+		return res;
+	}
+
+	// Both values are built in the same register, and must have the same type
+	// With a constant predicate, the other value is only checked
+	Operand compileConditional(NodeIndex index, std::optional<uint8_t> destination) {
+		auto &node = getNode(index);
+		auto reg = getDestination(destination, index);
+		auto top = getContext().registerTop;
+		auto begin = getNextInstructionIndex();
+		auto predicate = compileCondition(node.operands[0]);
+		if (predicate.constant.has_value()) {
+			truncateTo(begin);
+			getContext().registerTop = top;
+			auto skipped = compileExpression(node.operands[*predicate.constant != 0 ? 2 : 1], reg);
+			truncateTo(begin);
+			getContext().registerTop = top;
+			auto res = compileExpression(node.operands[*predicate.constant != 0 ? 1 : 2], reg);
+			getContext().registerTop = top;
+			if (res.type != skipped.type)
+				throw CompileError(index, "both values of a conditional must have the same type, got " + describe(res.type) + " and " + describe(skipped.type));
+			return res;
+		}
+		auto skipToElse = emitJump(Opcode::JumpIfFalse, index, predicate.reg);
+		getContext().registerTop = top;
+		auto valueIfTrue = compileExpression(node.operands[1], reg);
+		auto skipToEnd = emitJump(Opcode::Jump, index);
+		patchJump(skipToElse, getNextInstructionIndex(), index);
+		getContext().registerTop = top;
+		auto valueIfFalse = compileExpression(node.operands[2], reg);
+		patchJump(skipToEnd, getNextInstructionIndex(), index);
+		getContext().registerTop = top;
+		if (valueIfTrue.type != valueIfFalse.type)
+			throw CompileError(index, "both values of a conditional must have the same type, got " + describe(valueIfTrue.type) + " and " + describe(valueIfFalse.type));
+		return Operand{reg, valueIfTrue.type};
+	}
+
+	Operand compileCondition(NodeIndex index) {
+		auto res = compileExpression(index);
+		if (res.type != ValueType::Bool)
+			throw CompileError(index, "expected a condition, got " + describe(res.type));
+		return res;
+	}
+
+	// Returns the assigned variable
+	// Variables are declared by their first assignment, which must be a statement or the value of one
+	Operand compileAssignment(NodeIndex index, bool isStatement) {
+		auto &node = getNode(index);
+		if (node.op == Operator::BackInsert)
+			throw CompileError(index, "back-insertion into `std_out` is not a value");
+		if (getNode(node.operands[1]).kind == NodeKind::Function)
+			throw CompileError(index, "functions must be named by an assignment statement");
+
+		auto &target = getNode(node.operands[0]);
+		if (target.kind == NodeKind::Subscript)
+			return compileElementAssignment(index, isStatement);
+		if (node.op == Operator::Assign && target.kind == NodeKind::Identifier) {
+			auto binding = find(target.operands[0]);
+			if (binding == nullptr || binding->kind != Binding::Kind::Variable || binding->context != m_contexts.size() - 1) {
+				if (!isStatement)
+					throw CompileError(node.operands[0], "variables must be declared by a statement, " + getName(target.operands[0]) + " is not declared yet");
+				auto reg = allocateRegister(index);
+				if (isArrayConstruction(node.operands[1]))
+					return compileArrayDeclaration(index, reg);
+				Operand value;
+				if (getNode(node.operands[1]).kind == NodeKind::Assignment) {
+					auto chained = compileAssignment(node.operands[1], true);
+					if (chained.type == ValueType::Array)
+						throw CompileError(index, "arrays cannot be copied");
+					value = convert(chained, chained.type, reg, index, "");
+				} else {
+					value = compileExpression(node.operands[1], reg);
+					getContext().registerTop = reg + 1;
+				}
+				bool isAssignedOnce = m_assignmentCounts[target.operands[0]] == 1;
+				if (!isAssignedOnce)
+					value.constant.reset();
+				bindVariable(target.operands[0], value, false, isAssignedOnce);
+				return value;
+			}
+		}
+
+		auto variable = getAssignedVariable(node.operands[0]);
+		auto res = Operand{variable.reg, variable.type};
+		auto what = "assignment to " + getName(target.operands[0]);
+		auto top = getContext().registerTop;
+		if (node.op == Operator::Assign) {
+			auto valueIndex = node.operands[1];
+			Operand value;
+			if (getNode(valueIndex).kind == NodeKind::Assignment)
+				value = compileAssignment(valueIndex, isStatement);
+			else if (isWrittenLast(valueIndex))
+				value = compileExpression(valueIndex, res.reg);
+			else
+				value = compileExpression(valueIndex);
+			// An integer built in place is converted in place
+			convert(value, res.type, res.reg, index, what);
+		} else {
+			auto value = compileExpression(node.operands[1]);
+			if (emitBinary(index, node.op, res, value, res.reg, top).type != res.type)
+				throw CompileError(index, what + " expects " + describe(res.type) + ", got " + describe(ValueType::Real));
+		}
+		if (getNode(node.operands[1]).kind != NodeKind::Assignment)
+			getContext().registerTop = top;
+		return res;
+	}
+
+	// `std_out <<- a <<- b` or `array <<- a <<- b`: the sink is at the bottom of the chain, values are inserted from there
+	// `array` is the sink, none for `std_out`
+	void compileBackInsert(NodeIndex index, const std::optional<Binding> &array) {
+		auto &node = getNode(index);
+		auto &target = getNode(node.operands[0]);
+		if (target.kind == NodeKind::Assignment && target.op == Operator::BackInsert)
+			compileBackInsert(node.operands[0], array);
+
+		auto &value = getNode(node.operands[1]);
+		if (value.kind == NodeKind::Identifier && isBuiltin(value.operands[0], m_endLine)) {
+			if (array.has_value())
+				throw CompileError(node.operands[1], "`end_line` can only be back-inserted into `std_out`");
+			emit(Instruction::make(Opcode::PrintLinefeed), index);
+			return;
+		}
+		static constexpr std::array<Opcode, 4> printOpcodes = {Opcode::PrintInteger, Opcode::PrintReal, Opcode::PrintBool, Opcode::PrintString};
+		auto top = getContext().registerTop;
+		auto operand = compileExpression(node.operands[1]);
+		if (array.has_value()) {
+			operand = convert(operand, array->elementType, std::nullopt, node.operands[1], "back-insertion into " + getName(array->symbol));
+			emit(Instruction::make(Opcode::BackInsert, array->reg, operand.reg), index);
+		} else
+			emit(Instruction::make(printOpcodes[static_cast<size_t>(operand.type)], operand.reg), index);
+		getContext().registerTop = top;
+	}
+
+	// Array at the bottom of the chain of back-insertions, none for `std_out`
+	std::optional<Binding> findInsertedArray(NodeIndex index) const {
+		auto sink = index;
+		while (getNode(sink).kind == NodeKind::Assignment && getNode(sink).op == Operator::BackInsert)
+			sink = getNode(sink).operands[0];
+		auto &node = getNode(sink);
+		if (node.kind == NodeKind::Identifier && isBuiltin(node.operands[0], m_stdOut))
+			return std::nullopt;
+		if (auto res = findArray(sink))
+			return *res;
+		throw CompileError(sink, "back-insertion is only supported into `std_out` and arrays for now");
+	}
+
+	// Array variable named by the node, null if it names none
+	const Binding* findArray(NodeIndex index) const {
+		auto &node = getNode(index);
+		if (node.kind != NodeKind::Identifier)
+			return nullptr;
+		auto binding = find(node.operands[0]);
+		if (binding == nullptr || binding->kind != Binding::Kind::Variable || binding->type != ValueType::Array)
+			return nullptr;
+		if (binding->context != m_contexts.size() - 1)
+			throw CompileError(index, getName(node.operands[0]) + " belongs to an enclosing function, which is not supported yet");
+		return binding;
+	}
+
+	// Arrays
+
+	// `[]type()`
+	bool isArrayConstruction(NodeIndex index) const {
+		auto &node = getNode(index);
+		return node.kind == NodeKind::Call && getNode(node.operands[0]).kind == NodeKind::ArrayType;
+	}
+
+	// `integer`, `real`, `bool` or `string`, unless the name is bound by the program
+	ValueType getElementType(NodeIndex index) const {
+		auto &node = getNode(index);
+		if (node.kind == NodeKind::ArrayType)
+			throw CompileError(index, "arrays of arrays are not supported yet");
+		if (node.kind == NodeKind::Identifier && find(node.operands[0]) == nullptr)
+			for (size_t type = 0; type < static_cast<size_t>(ValueType::Array); type++)
+				if (m_symbols->getSpelling(node.operands[0]) == getValueTypeName(static_cast<ValueType>(type)))
+					return static_cast<ValueType>(type);
+		throw CompileError(index, "expected the type of the elements: `integer`, `real`, `bool` or `string`");
+	}
+
+	// `a <- []type()`: the array is created with room for every back-insertion into `a` its scope can run, and never grows
+	// The scope is what follows the declaration within its block, and is counted by `countInsertions`
+	Operand compileArrayDeclaration(NodeIndex index, uint8_t reg) {
+		auto &node = getNode(index);
+		auto &construction = getNode(node.operands[1]);
+		auto &arrayType = getNode(construction.operands[0]);
+		auto symbol = getNode(node.operands[0]).operands[0];
+		if (arrayType.operands[0] != Nodes::none)
+			throw CompileError(arrayType.operands[0], "arrays of explicit size are not supported yet, the size is counted from the back-insertions");
+		if (construction.operands[2] != 0)
+			throw CompileError(node.operands[1], "array constructors take no arguments");
+		auto elementType = getElementType(arrayType.operands[1]);
+
+		auto count = InsertionCount{symbol, index, {}, std::nullopt};
+		uint64_t size = 0;
+		if (m_blockStatement == index)
+			for (auto statement : m_followingStatements)
+				size = addSizes(size, countInsertions(statement, count));
+		if (!count.sum.has_value())
+			emitLoadInteger(reg, static_cast<int64_t>(size), index);
+		else if (size > 0) {
+			auto constant = allocateRegister(index);
+			emitLoadInteger(constant, static_cast<int64_t>(size), index);
+			emit(Instruction::make(Opcode::AddCount, *count.sum, *count.sum, constant), index);
+		}
+		emit(Instruction::make(Opcode::NewArray, reg, count.sum.value_or(reg)), index);
+		getContext().registerTop = reg + 1;
+		auto res = Operand{reg, ValueType::Array};
+		bindVariable(symbol, res);
+		m_bindings.back().elementType = elementType;
+		return res;
+	}
+
+	// `a[i]`: the array and the index in registers, the index being checked to be an integer
+	std::pair<Binding, Operand> compileElement(NodeIndex index) {
+		auto &node = getNode(index);
+		auto array = findArray(node.operands[0]);
+		if (array == nullptr)
+			throw CompileError(node.operands[0], "only arrays can be subscripted for now");
+		auto binding = *array;
+		auto position = compileExpression(node.operands[1]);
+		if (position.type != ValueType::Integer)
+			throw CompileError(node.operands[1], "subscript of " + getName(binding.symbol) + " expects " + describe(ValueType::Integer) + ", got "
+				+ describe(position.type));
+		return {binding, position};
+	}
+
+	// Emitted with its bounds check, which `finishContext` removes where `RangeAnalysis` proves the index within the size of the array
+	Operand compileSubscript(NodeIndex index, std::optional<uint8_t> destination) {
+		auto top = getContext().registerTop;
+		auto [array, position] = compileElement(index);
+		getContext().registerTop = top;
+		auto res = Operand{getDestination(destination, index), array.elementType};
+		emit(Instruction::make(Opcode::LoadElement, res.reg, array.reg, position.reg), index, res.type);
+		return res;
+	}
+
+	// `a[i] <- x` or a compound assignment like `a[i] + <- x`, returns the assigned value
+	Operand compileElementAssignment(NodeIndex index, bool isStatement) {
+		auto &node = getNode(index);
+		auto [array, position] = compileElement(node.operands[0]);
+		auto what = "assignment to an element of " + getName(array.symbol);
+		Operand value;
+		if (node.op == Operator::Assign) {
+			if (getNode(node.operands[1]).kind == NodeKind::Assignment)
+				value = compileAssignment(node.operands[1], isStatement);
+			else
+				value = compileExpression(node.operands[1]);
+			value = convert(value, array.elementType, std::nullopt, index, what);
+		} else {
+			auto element = Operand{allocateRegister(index), array.elementType};
+			emit(Instruction::make(Opcode::LoadElement, element.reg, array.reg, position.reg), index, element.type);
+			value = emitBinary(index, node.op, element, compileExpression(node.operands[1]), std::nullopt, element.reg);
+			if (value.type != array.elementType)
+				throw CompileError(index, what + " expects " + describe(array.elementType) + ", got " + describe(value.type));
+		}
+		emit(Instruction::make(Opcode::StoreElement, array.reg, position.reg, value.reg), index);
+		return value;
+	}
+
+	// Array sizes saturate at the largest integer, as `MultiplyCount` and `AddCount` do at runtime
+	static uint64_t addSizes(uint64_t a, uint64_t b) {
+		return std::min<uint64_t>(a + b, INT64_MAX);
+	}
+	static uint64_t multiplySizes(uint64_t a, uint64_t b) {
+		uint64_t res;
+		if (__builtin_mul_overflow(a, b, &res) || res > INT64_MAX)
+			return INT64_MAX;
+		return res;
+	}
+
+	// Upper bound on the back-insertions into `count.array` by the statement, for a single run of it
+	// The counts depending on limits of `count` only known at runtime are added to `count.sum` by code emitted at the declaration,
+	// the others are returned
+	uint64_t countInsertions(NodeIndex index, InsertionCount &count) {
+		auto &node = getNode(index);
+		switch (node.kind) {
+		case NodeKind::Block: {
+			uint64_t res = 0;
+			for (auto statement : m_ast->getList(node.operands[0], node.operands[1]))
+				res = addSizes(res, countInsertions(statement, count));
+			return res;
+		}
+		// Counts only known at runtime are summed over both branches instead
+		case NodeKind::If: {
+			auto res = countInsertions(node.operands[1], count);
+			if (node.operands[2] != Nodes::none)
+				res = std::max(res, countInsertions(node.operands[2], count));
+			return res;
+		}
+		case NodeKind::For:
+		case NodeKind::While: {
+			count.loops.emplace_back(CountedLoop{index, std::nullopt});
+			auto res = countInsertions(node.operands[node.kind == NodeKind::For ? 2 : 1], count);
+			count.loops.pop_back();
+			return res;
+		}
+		case NodeKind::Assignment: {
+			if (node.op != Operator::BackInsert)
+				return 0;
+			uint64_t linkCount = 0;
+			auto sink = index;
+			for (; getNode(sink).kind == NodeKind::Assignment && getNode(sink).op == Operator::BackInsert; sink = getNode(sink).operands[0])
+				linkCount++;
+			if (getNode(sink).kind != NodeKind::Identifier || getNode(sink).operands[0] != count.array)
+				return 0;
+			return countRuns(linkCount, count);
+		}
+		default:
+			return 0;
+		}
+	}
+
+	// `runCount` times the iterations of every loop enclosing the statement, like `countInsertions`
+	uint64_t countRuns(uint64_t runCount, InsertionCount &count) {
+		std::vector<uint8_t> factors;
+		for (size_t i = 0; i < count.loops.size(); i++) {
+			auto limit = getCountedLimit(i, count);
+			if (limit.constant.has_value())
+				runCount = multiplySizes(runCount, static_cast<uint64_t>(std::max<int64_t>(static_cast<int64_t>(*limit.constant), 0)));
+			else
+				factors.emplace_back(limit.reg);
+		}
+		if (factors.empty() || runCount == 0)
+			return runCount;
+		auto term = allocateRegister(count.declaration);
+		emitLoadInteger(term, static_cast<int64_t>(runCount), count.declaration);
+		for (auto factor : factors)
+			emit(Instruction::make(Opcode::MultiplyCount, term, term, factor), count.declaration);
+		if (!count.sum.has_value())
+			count.sum = term;
+		else {
+			emit(Instruction::make(Opcode::AddCount, *count.sum, *count.sum, term), count.declaration);
+			getContext().registerTop = term;
+		}
+		return 0;
+	}
+
+	// Limit of the `i`th loop enclosing the counted statement, compiled at the declaration of the array when first needed
+	Operand getCountedLimit(size_t i, InsertionCount &count) {
+		if (count.loops[i].limit.has_value())
+			return *count.loops[i].limit;
+		auto loop = count.loops[i].node;
+		auto &node = getNode(loop);
+		auto arrayName = getName(count.array);
+		if (node.kind == NodeKind::While)
+			throw CompileError(loop, "back-insertions into " + arrayName + " within a `while` loop cannot be counted, so the size of the array cannot be bounded");
+		if (!isCountCall(node.operands[1]))
+			throw CompileError(node.operands[1], "only `count(n)` can be iterated for now");
+		auto limit = m_ast->getList(getNode(node.operands[1]).operands[1], 1)[0];
+
+		// The iterator of an enclosing loop is lesser than the limit of that loop
+		auto &limitNode = getNode(limit);
+		if (limitNode.kind == NodeKind::Identifier)
+			for (size_t j = i; j-- > 0;) {
+				auto &enclosing = getNode(count.loops[j].node);
+				if (enclosing.kind == NodeKind::For && enclosing.operands[0] == limitNode.operands[0]) {
+					auto res = getCountedLimit(j, count);
+					count.loops[i].limit = res;
+					return res;
+				}
+			}
+		if (!isInvariantOver(limit, i, count))
+			throw CompileError(limit, "back-insertions into " + arrayName + " cannot be counted: the limit of `count` must only depend on variables declared before "
+				+ arrayName + " and never assigned again, and only divide by nonzero literals");
+		auto top = getContext().registerTop;
+		auto begin = getNextInstructionIndex();
+		auto res = compileExpression(limit);
+		if (res.type != ValueType::Integer)
+			throw CompileError(limit, "`count` expects " + describe(ValueType::Integer) + ", got " + describe(res.type));
+		// A known limit is folded into the size, its register is never read
+		if (res.constant.has_value()) {
+			truncateTo(begin);
+			getContext().registerTop = top;
+		}
+		count.loops[i].limit = res;
+		return res;
+	}
+
+	// Whether the expression has the same value at the declaration of the array as within the first `loopCount` loops of `count`
+	bool isInvariantOver(NodeIndex index, size_t loopCount, const InsertionCount &count) const {
+		auto &node = getNode(index);
+		switch (node.kind) {
+		case NodeKind::NumberLiteral:
+			return true;
+		case NodeKind::Identifier: {
+			for (size_t i = 0; i < loopCount; i++) {
+				auto &loop = getNode(count.loops[i].node);
+				if (loop.kind == NodeKind::For && loop.operands[0] == node.operands[0])
+					return false;
+			}
+			auto binding = find(node.operands[0]);
+			return binding != nullptr && binding->kind == Binding::Kind::Variable && binding->context == m_contexts.size() - 1
+				&& binding->type != ValueType::Array && binding->isInvariant;
+		}
+		case NodeKind::Prefix:
+			return (node.op == Operator::Plus || node.op == Operator::Minus || node.op == Operator::BinaryNot)
+				&& isInvariantOver(node.operands[0], loopCount, count);
+		case NodeKind::Binary:
+			// Evaluated ahead of the loops, so a division must not be able to fail where the loops would never have run
+			if ((node.op == Operator::Division || node.op == Operator::Modulo) && !isNonZeroInteger(node.operands[1]))
+				return false;
+			return isInvariantOver(node.operands[0], loopCount, count) && isInvariantOver(node.operands[1], loopCount, count);
+		default:
+			return false;
+		}
+	}
+
+	bool isNonZeroInteger(NodeIndex index) const {
+		auto &node = getNode(index);
+		if (node.kind != NodeKind::NumberLiteral)
+			return false;
+		auto literal = (*m_numbers)[node.operands[0]];
+		return literal.isInteger() && !literal.isFractional() && literal.getInteger().getBitWidth() <= 63 && literal.getInteger().getLimb(0) != 0;
+	}
+
+	// Arguments are built at the top of the frame, which becomes the base of the frame of the callee
+	Operand compileCall(NodeIndex index, std::optional<uint8_t> destination, bool isValueUsed) {
+		auto &node = getNode(index);
+		auto &callee = getNode(node.operands[0]);
+		if (callee.kind == NodeKind::ArrayType)
+			throw CompileError(index, "arrays can only be constructed to declare a variable, by an assignment statement");
+		if (callee.kind != NodeKind::Identifier)
+			throw CompileError(node.operands[0], "only named functions can be called for now");
+		auto found = find(callee.operands[0]);
+		if (found == nullptr && isBuiltin(callee.operands[0], m_count))
+			throw CompileError(index, "`count` can only be iterated by `for` for now");
+		if (found == nullptr)
+			throw CompileError(node.operands[0], "unknown name " + getName(callee.operands[0]));
+		if (found->kind != Binding::Kind::Function)
+			throw CompileError(node.operands[0], getName(callee.operands[0]) + " is not a function");
+		auto binding = *found;
+
+		auto parameterCount = getNode(binding.node).operands[1];
+		auto arguments = m_ast->getList(node.operands[1], node.operands[2]);
+		if (arguments.size() != parameterCount)
+			throw CompileError(index, getName(callee.operands[0]) + " expects " + std::to_string(parameterCount) + " arguments, got " + std::to_string(arguments.size()));
+
+		auto top = getContext().registerTop;
+		auto base = allocateRegister(index);
+		getContext().registerTop = top;
+		std::vector<ValueType> argumentTypes;
+		for (auto argument : arguments) {
+			auto reg = allocateRegister(argument);
+			argumentTypes.emplace_back(compileExpression(argument, reg).type);
+			getContext().registerTop = reg + 1;
+		}
+
+		auto &specialization = specialize(index, binding, argumentTypes);
+		if (isValueUsed && !specialization.returnType.has_value()) {
+			if (specialization.isCompiled)
+				throw CompileError(index, getName(callee.operands[0]) + " returns nothing");
+			throw CompileError(index, "cannot infer what the recursive call to " + getName(callee.operands[0]) + " returns, return a value before it");
+		}
+		emit(Instruction::makeWide(Opcode::Call, base, static_cast<uint16_t>(specialization.functionIndex)), index, specialization.returnType);
+		getContext().registerTop = top;
+		if (!isValueUsed)
+			return Operand{base, ValueType::Integer};
+		auto type = *specialization.returnType;
+		return convert(Operand{base, type}, type, getDestination(destination, index), index, "");
+	}
+
+	// Compiles the function for these argument types, unless already done
+	Specialization& specialize(NodeIndex callIndex, const Binding &binding, const std::vector<ValueType> &argumentTypes) {
+		auto key = std::make_pair(binding.node, argumentTypes);
+		auto found = m_specializations.find(key);
+		if (found != m_specializations.end())
+			return found->second;
+
+		auto name = std::string(m_symbols->getSpelling(binding.symbol)) + "(";
+		for (size_t i = 0; i < argumentTypes.size(); i++) {
+			if (i > 0)
+				name += ", ";
+			name += getValueTypeName(argumentTypes[i]);
+		}
+		name += ")";
+		if (m_program->getFunctionCount() > 0xFFFF)
+			throw CompileError(callIndex, "more than 65536 function specializations in the program");
+		auto functionIndex = m_program->addFunction(name, static_cast<uint8_t>(argumentTypes.size()));
+		// Registered before its body is compiled, for recursive calls
+		auto &res = m_specializations.emplace(key, Specialization{functionIndex, std::nullopt, false}).first->second;
+
+		auto &function = getNode(binding.node);
+		auto bindingCount = m_bindings.size();
+		m_contexts.emplace_back(Context{functionIndex, {}, {}, {}, 0, 0, std::nullopt, false, static_cast<uint32_t>(bindingCount), binding.visibleBindingCount,
+			Annotation::unknownCount});
+		getContext().parameterTypes = argumentTypes;
+		getContext().body = function.operands[2];
+		auto parameters = m_ast->getList(function.operands[0], function.operands[1]);
+		for (size_t i = 0; i < parameters.size(); i++) {
+			auto &parameter = getNode(parameters[i]);
+			if (parameter.operands[1] != Nodes::none)
+				throw CompileError(parameters[i], "parameter types are not supported yet, they are inferred from the arguments");
+			bindVariable(parameter.operands[0], Operand{allocateRegister(parameters[i]), argumentTypes[i]}, false,
+				m_assignmentCounts[parameter.operands[0]] == 0);
+		}
+		compileStatement(function.operands[2], &res);
+		if (getContext().returnType.has_value() && !isReturning(function.operands[2]))
+			throw CompileError(binding.node, "the function returns a value on some paths only");
+		if (!getContext().returnType.has_value())
+			emit(Instruction::make(Opcode::ReturnNothing), function.operands[2]);
+		finishContext();
+		unbindTo(bindingCount);
+		res.isCompiled = true;
+		return res;
+	}
+
+	void finishContext(void) {
+		auto &context = getContext();
+		auto registerCount = static_cast<uint16_t>(std::max<uint32_t>(context.registerCount, 1));
+		Peephole::optimize(*m_program, context.code, context.sourceLocations, context.annotations);
+		auto inBoundsAccesses = RangeAnalysis::analyze(*m_program, context.code, registerCount, context.parameterTypes, context.annotations);
+		// With `SPP_BOUNDS_CHECKED_ARRAYS`, every element access keeps its check, the baseline of `bench/interpret_bounds_checked`
+#ifndef SPP_BOUNDS_CHECKED_ARRAYS
+		for (auto i : inBoundsAccesses) {
+			auto &instruction = context.code[i];
+			auto opcode = instruction.getOpcode() == Opcode::LoadElement ? Opcode::LoadElementUnchecked : Opcode::StoreElementUnchecked;
+			instruction = Instruction::make(opcode, instruction.getA(), instruction.getB(), instruction.getC());
+		}
+#else
+		(void)inBoundsAccesses;
+#endif
+		m_program->setFunctionCode(context.functionIndex, registerCount, context.code, context.sourceLocations, context.annotations);
+		m_contexts.pop_back();
+	}
+
+	// Whether every path through the statement ends with a `return`
+	bool isReturning(NodeIndex index) const {
+		auto &node = getNode(index);
+		switch (node.kind) {
+		case NodeKind::Return:
+			return true;
+		case NodeKind::Block:
+			return node.operands[1] > 0 && isReturning(m_ast->getList(node.operands[0], node.operands[1]).back());
+		case NodeKind::If:
+			return node.operands[2] != Nodes::none && isReturning(node.operands[1]) && isReturning(node.operands[2]);
+		default:
+			return false;
+		}
+	}
+
+	// Statements
+
+	// `specialization` is the function being compiled, null for the entry point
+	void compileStatement(NodeIndex index, Specialization *specialization) {
+		auto &node = getNode(index);
+		auto top = getContext().registerTop;
+		switch (node.kind) {
+		case NodeKind::Block: {
+			auto bindingCount = m_bindings.size();
+			auto statements = m_ast->getList(node.operands[0], node.operands[1]);
+			for (size_t i = 0; i < statements.size(); i++) {
+				m_blockStatement = statements[i];
+				m_followingStatements = statements.subspan(i + 1);
+				compileStatement(statements[i], specialization);
+			}
+			popArrays(index, bindingCount);
+			unbindTo(bindingCount);
+			break;
+		}
+		case NodeKind::For:
+			compileFor(index, specialization);
+			break;
+		case NodeKind::While: {
+			auto skipToCondition = emitJump(Opcode::Jump, index);
+			auto bodyIndex = getNextInstructionIndex();
+			auto executionCount = getContext().executionCount;
+			getContext().executionCount = Annotation::unknownCount;
+			compileScope(node.operands[1], specialization);
+			patchJump(skipToCondition, getNextInstructionIndex(), index);
+			auto condition = compileCondition(node.operands[0]);
+			patchJump(emitJump(Opcode::JumpIfTrue, index, condition.reg), bodyIndex, index);
+			getContext().executionCount = executionCount;
+			break;
+		}
+		case NodeKind::If: {
+			auto begin = getNextInstructionIndex();
+			auto condition = compileCondition(node.operands[0]);
+			getContext().registerTop = top;
+			if (condition.constant.has_value()) {
+				// The branch not taken is still compiled for its errors, then dropped
+				truncateTo(begin);
+				auto taken = *condition.constant != 0 ? node.operands[1] : node.operands[2];
+				auto skipped = *condition.constant != 0 ? node.operands[2] : node.operands[1];
+				if (skipped != Nodes::none) {
+					compileScope(skipped, specialization);
+					truncateTo(begin);
+				}
+				if (taken != Nodes::none)
+					compileScope(taken, specialization);
+				break;
+			}
+			auto skipToElse = emitJump(Opcode::JumpIfFalse, index, condition.reg);
+			compileScope(node.operands[1], specialization);
+			if (node.operands[2] == Nodes::none)
+				patchJump(skipToElse, getNextInstructionIndex(), index);
+			else {
+				auto skipToEnd = emitJump(Opcode::Jump, index);
+				patchJump(skipToElse, getNextInstructionIndex(), index);
+				compileScope(node.operands[2], specialization);
+				patchJump(skipToEnd, getNextInstructionIndex(), index);
+			}
+			break;
+		}
+		case NodeKind::Return:
+			compileReturn(index, specialization);
+			break;
+		case NodeKind::Assignment:
+			if (node.op == Operator::BackInsert)
+				compileBackInsert(index, findInsertedArray(index));
+			else if (node.op == Operator::Assign && getNode(node.operands[1]).kind == NodeKind::Function)
+				defineFunction(index);
+			else
+				compileAssignment(index, true);
+			// Variables it declared stay allocated
+			return;
+		case NodeKind::Prefix:
+		case NodeKind::Postfix:
+			// The value is unused, whether it is the one before or after the increment does not matter
+			if (node.op == Operator::Increment || node.op == Operator::Decrement)
+				compileIncrement(index, node.operands[0]);
+			else
+				compileExpression(index);
+			break;
+		case NodeKind::Call:
+			compileCall(index, std::nullopt, false);
+			break;
+		default:
+			compileExpression(index);
+			break;
+		}
+		getContext().registerTop = top;
+	}
+
+	// Body of a control statement, the variables it declares do not outlive it
+	void compileScope(NodeIndex index, Specialization *specialization) {
+		auto bindingCount = m_bindings.size();
+		compileStatement(index, specialization);
+		popArrays(index, bindingCount);
+		unbindTo(bindingCount);
+	}
+
+	// As the scope `index` ends, pops the arrays it declared since `bindingCount`, which restores the array stack
+	// to where the first of them was allocated, so that a loop body reuses the same storage on every iteration
+	// Nothing is emitted where the scope returns, which pops the arrays of the frame anyway
+	void popArrays(NodeIndex index, size_t bindingCount) {
+		if (index == getContext().body || isReturning(index))
+			return;
+		for (size_t i = bindingCount; i < m_bindings.size(); i++) {
+			auto &binding = m_bindings[i];
+			if (binding.kind == Binding::Kind::Variable && binding.type == ValueType::Array && binding.context == m_contexts.size() - 1) {
+				emit(Instruction::make(Opcode::PopArrays, binding.reg), index);
+				return;
+			}
+		}
+	}
+
+	// Nothing is emitted until the function is called
+	void defineFunction(NodeIndex index) {
+		auto &node = getNode(index);
+		auto &target = getNode(node.operands[0]);
+		if (target.kind != NodeKind::Identifier)
+			throw CompileError(node.operands[0], "functions must be named by a variable");
+		auto binding = find(target.operands[0]);
+		if (binding != nullptr && binding->kind == Binding::Kind::Variable && binding->context == m_contexts.size() - 1)
+			throw CompileError(node.operands[0], getName(target.operands[0]) + " is a variable, it cannot be assigned a function");
+		// The function sees itself, for recursion
+		bind(Binding{Binding::Kind::Function, ValueType::Integer, 0, true, target.operands[0], noBinding,
+			static_cast<uint32_t>(m_contexts.size() - 1), node.operands[1], static_cast<uint32_t>(m_bindings.size() + 1)});
+	}
+
+	void compileReturn(NodeIndex index, Specialization *specialization) {
+		auto &node = getNode(index);
+		auto &context = getContext();
+		if (node.operands[0] == Nodes::none) {
+			if (context.returnType.has_value())
+				throw CompileError(index, "expected a value, the function returns " + describe(*context.returnType) + " elsewhere");
+			context.isReturningNothing = true;
+			emit(Instruction::make(Opcode::ReturnNothing), index);
+			return;
+		}
+		if (specialization == nullptr)
+			throw CompileError(index, "the entry point cannot return a value");
+		if (context.isReturningNothing)
+			throw CompileError(index, "the function also returns nothing elsewhere");
+		auto value = compileExpression(node.operands[0]);
+		if (!context.returnType.has_value()) {
+			context.returnType = value.type;
+			specialization->returnType = value.type;
+		}
+		value = convert(value, *context.returnType, std::nullopt, index, "return");
+		emit(Instruction::make(Opcode::Return, value.reg), index);
+	}
+
+	// Only `count(n)` is iterable for now: the iterator variable itself counts from zero to `n`
+	// Product of execution counts, unknown if either is or if it overflows
+	static uint64_t multiplyCounts(uint64_t a, uint64_t b) {
+		uint64_t res;
+		if (a == Annotation::unknownCount || b == Annotation::unknownCount || __builtin_mul_overflow(a, b, &res) || res == Annotation::unknownCount)
+			return Annotation::unknownCount;
+		return res;
+	}
+
+	bool isCountCall(NodeIndex index) const {
+		auto &node = getNode(index);
+		return node.kind == NodeKind::Call && getNode(node.operands[0]).kind == NodeKind::Identifier
+			&& isBuiltin(getNode(node.operands[0]).operands[0], m_count) && node.operands[2] == 1;
+	}
+
+	void compileFor(NodeIndex index, Specialization *specialization) {
+		auto &node = getNode(index);
+		auto &iterated = getNode(node.operands[1]);
+		if (!isCountCall(node.operands[1]))
+			throw CompileError(node.operands[1], "only `count(n)` can be iterated for now");
+
+		auto bindingCount = m_bindings.size();
+		auto limit = allocateRegister(index);
+		auto countArgument = m_ast->getList(iterated.operands[1], 1)[0];
+		auto limitBegin = getNextInstructionIndex();
+		// An invariant variable is its own limit, which saves the copy and keeps its relations to the iterator once the loop is done
+		bool isLimitInPlace = isInvariantVariable(countArgument);
+		auto limitOperand = isLimitInPlace ? compileExpression(countArgument) : compileExpression(countArgument, limit);
+		if (limitOperand.type != ValueType::Integer)
+			throw CompileError(countArgument, "`count` expects " + describe(ValueType::Integer) + ", got " + describe(limitOperand.type));
+		auto iterationCount = Annotation::unknownCount;
+		if (limitOperand.constant.has_value()) {
+			auto limitValue = static_cast<int64_t>(*limitOperand.constant);
+			iterationCount = static_cast<uint64_t>(std::max<int64_t>(limitValue, 0));
+			truncateTo(limitBegin);
+			getContext().registerTop = limit;
+			if (unroll(index, iterationCount, specialization))
+				return;
+			allocateRegister(index);
+			emitConstant(limit, ValueType::Integer, *limitOperand.constant, countArgument);
+		}
+		getContext().registerTop = isLimitInPlace ? limit : limit + 1;
+		auto variable = allocateRegister(index);
+		// The loop is entered at the step, so that the step and the condition are a single sequence `Peephole` can fuse
+		emitLoadInteger(variable, -1, index);
+		bindVariable(node.operands[0], Operand{variable, ValueType::Integer}, true);
+
+		auto skipToStep = emitJump(Opcode::Jump, index);
+		auto bodyIndex = getNextInstructionIndex();
+		auto executionCount = getContext().executionCount;
+		getContext().executionCount = multiplyCounts(executionCount, iterationCount);
+		compileScope(node.operands[2], specialization);
+		patchJump(skipToStep, getNextInstructionIndex(), index);
+		// Once more than the body, for the last test
+		getContext().executionCount = multiplyCounts(executionCount, iterationCount == Annotation::unknownCount ? iterationCount : iterationCount + 1);
+		emit(Instruction::make(Opcode::AddIntegerImmediate, variable, variable, 1), index);
+		auto condition = allocateRegister(index);
+		emit(Instruction::make(Opcode::LesserInteger, condition, variable, limitOperand.reg), index);
+		patchJump(emitJump(Opcode::JumpIfTrue, index, condition), bodyIndex, index);
+		getContext().executionCount = executionCount;
+		unbindTo(bindingCount);
+	}
+
+	// Variable of the current function never assigned while in scope, and not known at compile time
+	bool isInvariantVariable(NodeIndex index) const {
+		auto &node = getNode(index);
+		if (node.kind != NodeKind::Identifier)
+			return false;
+		auto binding = find(node.operands[0]);
+		return binding != nullptr && binding->kind == Binding::Kind::Variable && binding->context == m_contexts.size() - 1 && binding->hasRegister
+			&& binding->isInvariant && !binding->constant.has_value();
+	}
+
+	// Compiles the body of `for` once per iteration, the iterator being a constant in each
+	// Returns false without emitting anything if that takes more instructions than the budget
+	bool unroll(NodeIndex index, uint64_t iterationCount, Specialization *specialization) {
+		auto &node = getNode(index);
+		auto maxInstructionCount = m_evaluator.getBudget().unrolledInstructionCount;
+		// Even an empty body costs an instruction by iteration, so that the compilation stays bounded too
+		if (iterationCount > maxInstructionCount)
+			return false;
+		auto begin = getNextInstructionIndex();
+		auto top = getContext().registerTop;
+		for (uint64_t i = 0; i < iterationCount; i++) {
+			auto bindingCount = m_bindings.size();
+			bindConstant(node.operands[0], ValueType::Integer, i);
+			compileScope(node.operands[2], specialization);
+			unbindTo(bindingCount);
+			getContext().registerTop = top;
+			if (getNextInstructionIndex() - begin > maxInstructionCount) {
+				truncateTo(begin);
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	// Compiles the top-level `Block` of `ast` as the entry point of `program`, along with every function it calls
+	static void generate(const Ast &ast, const SymbolTable &symbols, const NumberTable &numbers, const EvaluationBudget &budget, Program &program) {
+		auto generator = CodeGenerator(ast, symbols, numbers, budget, program);
+		try {
+			program.setSourcePath(ast.getFile().getPath().string());
+			generator.m_contexts.emplace_back(Context{program.addFunction("entry_point", 0), {}, {}, {}, 0, 0, std::nullopt, false, 0, 0, 1});
+			generator.getContext().body = ast.getRoot();
+			generator.compileStatement(ast.getRoot(), nullptr);
+			generator.emit(Instruction::make(Opcode::ReturnNothing), ast.getRoot());
+			generator.finishContext();
+		} catch (const CompileError &error) {
+			token::printMessage({ast.getToken(error.getNode())}, error.what());
+			throw std::runtime_error("Compilation failed");
+		}
+	}
+};
@@ -1,26 +1,38 @@
 #pragma once
 
 #include <filesystem>
+#include "arena.hpp"
 #include "token.hpp"
+#include "ast.hpp"
+#include "parser.hpp"
+#include "codegen.hpp"
+#include "evaluator.hpp"
 #include "program.hpp"
 
-#include <cstdio>
-
 class Compiler {
+	// Everything built while compiling, released at once when the program is done
+	Arena m_arena;
+	EvaluationBudget m_budget;
+
 public:
-	Compiler(void) {
+	Compiler(const EvaluationBudget &budget = {}) :
+		m_budget(budget) {
 	}
 
 	Program build(const std::filesystem::path &entryPointPath) {
-		auto sourceFile = File(entryPointPath);
-		auto tokens = TokenParser::readTokens(sourceFile);
-		for (auto &token : tokens) {
-			if (token.getClass() == TokenClass::StringLiteral)
-				std::printf("\"%s\"\n", token.getString().c_str());
-			else
-				std::printf("%s\n", token.getString().c_str());
+		auto res = Program();
+		{
+			auto symbols = SymbolTable(m_arena);
+			auto numbers = NumberTable(m_arena.getResource());
+			auto sourceFile = File(entryPointPath);
+			auto tokens = TokenCursor(sourceFile, symbols, numbers);
+			auto ast = Ast(sourceFile, m_arena.getResource());
+			Parser::parse(tokens, ast);
+			CodeGenerator::generate(ast, symbols, numbers, m_budget, res);
 		}
 
-		return Program();
+		// The program must not point into the arena, whose blocks are kept for the next build
+		m_arena.reset();
+		return res;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,415 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <string_view>
+#include "program.hpp"
+#include "output.hpp"
+
+// Prints the code of a program for `--inspect`, along with what the compiler knows about each instruction
+// Everything goes through a single buffered sink, so that the listing streams as fast as it is formatted
+class Disassembler {
+public:
+	enum class Format {
+		Text,
+		Json
+	};
+
+private:
+	enum class OperandKind : uint8_t {
+		Register,
+		Immediate,
+		// Instruction index
+		Target,
+		// Index within the constants of the program
+		Constant,
+		String,
+		Function
+	};
+
+	struct Operand {
+		OperandKind kind;
+		int64_t value;
+	};
+
+	struct Operands {
+		std::array<Operand, 3> operands;
+		size_t count;
+
+		void add(OperandKind kind, int64_t value) {
+			operands[count++] = Operand{kind, value};
+		}
+	};
+
+	const Program *m_program;
+	OutputBuffer m_output;
+
+	Disassembler(const Program &program) :
+		m_program(&program) {
+	}
+
+	static Operands decode(Instruction instruction, size_t index) {
+		Operands res{};
+		auto opcode = instruction.getOpcode();
+		auto target = [&](int32_t offset){
+			return static_cast<int64_t>(index) + 1 + offset;
+		};
+		switch (getOpcodeInfo(opcode).format) {
+		case OperandFormat::None:
+			break;
+		case OperandFormat::A:
+			res.add(OperandKind::Register, instruction.getA());
+			break;
+		case OperandFormat::AB:
+			res.add(OperandKind::Register, instruction.getA());
+			res.add(OperandKind::Register, instruction.getB());
+			break;
+		case OperandFormat::ABC:
+			res.add(OperandKind::Register, instruction.getA());
+			res.add(OperandKind::Register, instruction.getB());
+			res.add(OperandKind::Register, instruction.getC());
+			break;
+		case OperandFormat::ABsC:
+			res.add(OperandKind::Register, instruction.getA());
+			res.add(OperandKind::Register, instruction.getB());
+			if (instruction.isJump())
+				res.add(OperandKind::Target, target(instruction.getSignedC()));
+			else
+				res.add(OperandKind::Immediate, instruction.getSignedC());
+			break;
+		case OperandFormat::ABx:
+			res.add(OperandKind::Register, instruction.getA());
+			res.add(opcode == Opcode::LoadConstant ? OperandKind::Constant : opcode == Opcode::LoadString ? OperandKind::String : OperandKind::Function,
+				instruction.getBx());
+			break;
+		case OperandFormat::AsBx:
+			res.add(OperandKind::Register, instruction.getA());
+			if (opcode == Opcode::LoadInteger)
+				res.add(OperandKind::Immediate, instruction.getSignedBx());
+			else
+				res.add(OperandKind::Target, target(instruction.getSignedBx()));
+			break;
+		case OperandFormat::sAx:
+			res.add(OperandKind::Target, target(instruction.getSignedAx()));
+			break;
+		}
+		return res;
+	}
+
+	// Quoted, with the escapes of JSON, which text listings also use
+	void writeString(std::string_view string) {
+		static constexpr std::string_view hexDigits = "0123456789abcdef";
+		m_output.write('"');
+		for (auto c : string) {
+			auto byte = static_cast<unsigned char>(c);
+			if (c == '"' || c == '\\') {
+				m_output.write('\\');
+				m_output.write(c);
+			} else if (c == '\n')
+				m_output.write("\\n");
+			else if (c == '\t')
+				m_output.write("\\t");
+			else if (byte < 0x20) {
+				m_output.write("\\u00");
+				m_output.write(hexDigits[byte >> 4]);
+				m_output.write(hexDigits[byte & 0xF]);
+			} else
+				m_output.write(c);
+		}
+		m_output.write('"');
+	}
+
+	// `r3 - 1`
+	void writeBound(AffineBound bound) {
+		m_output.write('r');
+		m_output.writeNumber(bound.reg);
+		if (bound.offset != 0) {
+			m_output.write(bound.offset > 0 ? " + " : " - ");
+			m_output.writeNumber(bound.offset > 0 ? static_cast<uint64_t>(bound.offset) : uint64_t(0) - static_cast<uint64_t>(bound.offset));
+		}
+	}
+
+	void writeConstant(uint32_t index) {
+		auto value = m_program->getConstants()[index];
+		if (m_program->getConstantType(index) == ValueType::Real)
+			m_output.writeNumber(std::bit_cast<double>(value));
+		else
+			m_output.writeNumber(static_cast<int64_t>(value));
+	}
+
+	// Text
+
+	// Returns the number of characters written
+	size_t writeTextOperand(Operand operand) {
+		char buffer[32];
+		auto end = buffer;
+		switch (operand.kind) {
+		case OperandKind::Register:
+			*end++ = 'r';
+			break;
+		case OperandKind::Target:
+			*end++ = '@';
+			break;
+		case OperandKind::Function: {
+			auto &name = m_program->getFunction(static_cast<uint32_t>(operand.value)).name;
+			m_output.write(name);
+			return name.size();
+		}
+		default:
+			break;
+		}
+		end = std::to_chars(end, buffer + sizeof(buffer), operand.value).ptr;
+		m_output.write(std::string_view(buffer, end - buffer));
+		return static_cast<size_t>(end - buffer);
+	}
+
+	void writeTextInstruction(size_t index) {
+		static constexpr size_t annotationColumn = 48;
+		auto instruction = m_program->getCode()[index];
+		auto name = getOpcodeInfo(instruction.getOpcode()).name;
+
+		char indexBuffer[24];
+		auto indexEnd = std::to_chars(indexBuffer, indexBuffer + sizeof(indexBuffer), index).ptr;
+		for (auto i = indexEnd - indexBuffer; i < 6; i++)
+			m_output.write(' ');
+		m_output.write(std::string_view(indexBuffer, indexEnd - indexBuffer));
+		m_output.write("  ");
+		m_output.write(name);
+		size_t column = 8 + name.size();
+		auto operands = decode(instruction, index);
+		for (size_t i = 0; i < operands.count; i++) {
+			m_output.write(i == 0 ? " " : ", ");
+			column += (i == 0 ? 1 : 2) + writeTextOperand(operands.operands[i]);
+		}
+
+		for (; column < annotationColumn; column++)
+			m_output.write(' ');
+		m_output.write(" ;");
+		auto &annotation = m_program->getAnnotation(index);
+		for (size_t type = 0; type < valueTypeCount; type++)
+			if (annotation.typeSet & (1 << type)) {
+				m_output.write(' ');
+				m_output.write(getValueTypeName(static_cast<ValueType>(type)));
+			}
+		if (annotation.hasRange) {
+			if (annotation.minimum == annotation.maximum) {
+				m_output.write(" = ");
+				m_output.writeNumber(annotation.minimum);
+			} else {
+				m_output.write(" [");
+				m_output.writeNumber(annotation.minimum);
+				m_output.write(", ");
+				m_output.writeNumber(annotation.maximum);
+				m_output.write(']');
+			}
+		} else if (instruction.getOpcode() == Opcode::LoadConstant) {
+			m_output.write(" = ");
+			writeConstant(instruction.getBx());
+		} else if (instruction.getOpcode() == Opcode::LoadString) {
+			m_output.write(" = ");
+			writeString(m_program->getString(instruction.getBx()));
+		}
+		if (annotation.lowerBound.has_value()) {
+			m_output.write(" >= ");
+			writeBound(*annotation.lowerBound);
+		}
+		if (annotation.upperBound.has_value()) {
+			m_output.write(" <= ");
+			writeBound(*annotation.upperBound);
+		}
+		m_output.write(" x");
+		if (annotation.executionCount == Annotation::unknownCount)
+			m_output.write('?');
+		else
+			m_output.writeNumber(annotation.executionCount);
+		auto location = m_program->getSourceLocation(index);
+		m_output.write(' ');
+		m_output.writeNumber(location.line);
+		m_output.write(':');
+		m_output.writeNumber(location.column);
+		m_output.write('\n');
+	}
+
+	// Element accesses of the function, and how many of them run without a bounds check
+	struct BoundsChecks {
+		size_t accessCount;
+		size_t eliminatedCount;
+	};
+
+	BoundsChecks countBoundsChecks(const Function &function) const {
+		BoundsChecks res{};
+		for (auto instruction : m_program->getCode().subspan(function.codeBegin, function.codeSize)) {
+			auto opcode = instruction.getOpcode();
+			bool isUnchecked = opcode == Opcode::LoadElementUnchecked || opcode == Opcode::StoreElementUnchecked;
+			if (isUnchecked || opcode == Opcode::LoadElement || opcode == Opcode::StoreElement)
+				res.accessCount++;
+			if (isUnchecked)
+				res.eliminatedCount++;
+		}
+		return res;
+	}
+
+	void writeText(void) {
+		for (size_t i = 0; i < m_program->getFunctionCount(); i++) {
+			auto &function = m_program->getFunction(static_cast<uint32_t>(i));
+			m_output.write("function ");
+			m_output.write(function.name);
+			m_output.write(": ");
+			m_output.writeNumber(function.parameterCount);
+			m_output.write(" parameters, ");
+			m_output.writeNumber(function.registerCount);
+			m_output.write(" registers");
+			auto boundsChecks = countBoundsChecks(function);
+			if (boundsChecks.accessCount > 0) {
+				m_output.write(", ");
+				m_output.writeNumber(boundsChecks.eliminatedCount);
+				m_output.write(" of ");
+				m_output.writeNumber(boundsChecks.accessCount);
+				m_output.write(" bounds checks eliminated (");
+				m_output.writeNumber(boundsChecks.eliminatedCount * 100 / boundsChecks.accessCount);
+				m_output.write("%)");
+			}
+			m_output.write('\n');
+			for (size_t j = function.codeBegin; j < function.codeBegin + function.codeSize; j++)
+				writeTextInstruction(j);
+		}
+		auto code = m_program->getCode();
+		m_output.writeNumber(code.size());
+		m_output.write(" instructions (");
+		m_output.writeNumber(code.size() * sizeof(Instruction));
+		m_output.write(" bytes), ");
+		m_output.writeNumber(m_program->getConstants().size());
+		m_output.write(" constants, ");
+		m_output.writeNumber(m_program->getStringCount());
+		m_output.write(" strings, ");
+		m_output.writeNumber(m_program->getFunctionCount());
+		m_output.write(" functions\n");
+	}
+
+	// JSON, one instruction by line
+
+	void writeJsonInstruction(size_t index) {
+		static constexpr std::array<std::string_view, 6> operandKindNames = {"register", "immediate", "target", "constant", "string", "function"};
+		auto instruction = m_program->getCode()[index];
+		m_output.write("{\"index\": ");
+		m_output.writeNumber(index);
+		m_output.write(", \"opcode\": \"");
+		m_output.write(getOpcodeInfo(instruction.getOpcode()).name);
+		m_output.write("\", \"operands\": [");
+		auto operands = decode(instruction, index);
+		for (size_t i = 0; i < operands.count; i++) {
+			if (i > 0)
+				m_output.write(", ");
+			m_output.write("{\"");
+			m_output.write(operandKindNames[static_cast<size_t>(operands.operands[i].kind)]);
+			m_output.write("\": ");
+			m_output.writeNumber(operands.operands[i].value);
+			m_output.write('}');
+		}
+
+		auto &annotation = m_program->getAnnotation(index);
+		m_output.write("], \"types\": [");
+		bool isFirst = true;
+		for (size_t type = 0; type < valueTypeCount; type++)
+			if (annotation.typeSet & (1 << type)) {
+				if (!isFirst)
+					m_output.write(", ");
+				isFirst = false;
+				m_output.write('"');
+				m_output.write(getValueTypeName(static_cast<ValueType>(type)));
+				m_output.write('"');
+			}
+		m_output.write("], \"range\": ");
+		if (annotation.hasRange) {
+			m_output.write('[');
+			m_output.writeNumber(annotation.minimum);
+			m_output.write(", ");
+			m_output.writeNumber(annotation.maximum);
+			m_output.write(']');
+		} else
+			m_output.write("null");
+		for (auto [name, bound] : {std::pair{", \"lowerBound\": ", annotation.lowerBound}, std::pair{", \"upperBound\": ", annotation.upperBound}}) {
+			m_output.write(name);
+			if (bound.has_value()) {
+				m_output.write("{\"register\": ");
+				m_output.writeNumber(bound->reg);
+				m_output.write(", \"offset\": ");
+				m_output.writeNumber(bound->offset);
+				m_output.write('}');
+			} else
+				m_output.write("null");
+		}
+		m_output.write(", \"executionCount\": ");
+		if (annotation.executionCount == Annotation::unknownCount)
+			m_output.write("null");
+		else
+			m_output.writeNumber(annotation.executionCount);
+		auto location = m_program->getSourceLocation(index);
+		m_output.write(", \"line\": ");
+		m_output.writeNumber(location.line);
+		m_output.write(", \"column\": ");
+		m_output.writeNumber(location.column);
+		m_output.write('}');
+	}
+
+	void writeJson(void) {
+		m_output.write("{\"source\": ");
+		writeString(m_program->getSourcePath());
+		m_output.write(",\n\"constants\": [");
+		for (size_t i = 0; i < m_program->getConstants().size(); i++) {
+			if (i > 0)
+				m_output.write(", ");
+			m_output.write("{\"type\": \"");
+			m_output.write(getValueTypeName(m_program->getConstantType(static_cast<uint32_t>(i))));
+			m_output.write("\", \"value\": ");
+			auto value = m_program->getConstants()[i];
+			// Infinities and NaNs have no JSON literal
+			if (m_program->getConstantType(static_cast<uint32_t>(i)) == ValueType::Real && !std::isfinite(std::bit_cast<double>(value)))
+				m_output.write("null");
+			else
+				writeConstant(static_cast<uint32_t>(i));
+			m_output.write('}');
+		}
+		m_output.write("],\n\"strings\": [");
+		for (size_t i = 0; i < m_program->getStringCount(); i++) {
+			if (i > 0)
+				m_output.write(", ");
+			writeString(m_program->getString(static_cast<uint32_t>(i)));
+		}
+		m_output.write("],\n\"functions\": [");
+		for (size_t i = 0; i < m_program->getFunctionCount(); i++) {
+			auto &function = m_program->getFunction(static_cast<uint32_t>(i));
+			m_output.write(i > 0 ? ",\n{\"name\": " : "\n{\"name\": ");
+			writeString(function.name);
+			m_output.write(", \"parameterCount\": ");
+			m_output.writeNumber(function.parameterCount);
+			m_output.write(", \"registerCount\": ");
+			m_output.writeNumber(function.registerCount);
+			auto boundsChecks = countBoundsChecks(function);
+			m_output.write(", \"elementAccessCount\": ");
+			m_output.writeNumber(boundsChecks.accessCount);
+			m_output.write(", \"eliminatedBoundsCheckCount\": ");
+			m_output.writeNumber(boundsChecks.eliminatedCount);
+			m_output.write(", \"instructions\": [");
+			for (size_t j = function.codeBegin; j < function.codeBegin + function.codeSize; j++) {
+				m_output.write(j > function.codeBegin ? ",\n" : "\n");
+				writeJsonInstruction(j);
+			}
+			m_output.write("]}");
+		}
+		m_output.write("]}\n");
+	}
+
+public:
+	static void print(const Program &program, Format format) {
+		auto disassembler = Disassembler(program);
+		if (format == Format::Json)
+			disassembler.writeJson();
+		else
+			disassembler.writeText();
+	}
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+#include <map>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "program.hpp"
+#include "runner.hpp"
+
+// How far compile-time evaluation may go, code beyond it is left to run at runtime
+struct EvaluationBudget {
+	// Instructions run to evaluate a single expression, calls included
+	uint64_t stepCount = 1 << 20;
+	// Registers of all the frames of an evaluation
+	size_t registerCount = 1 << 16;
+	// Instructions emitted for all the iterations of an unrolled loop
+	size_t unrolledInstructionCount = 1 << 12;
+	// Values remembered by `Evaluator`
+	size_t memoizedValueCount = 1 << 16;
+};
+
+// Computes the value of side-effect-free code while the program is being compiled, by running it with `Runner`
+// Values are memoized by code and inputs, so that the same expression, such as a pure call with the same arguments, runs once
+class Evaluator {
+	const Program *m_program;
+	EvaluationBudget m_budget;
+	// Instructions followed by the inputs, as register and value
+	std::map<std::vector<uint32_t>, Value> m_values;
+
+public:
+	Evaluator(const Program &program, const EvaluationBudget &budget) :
+		m_program(&program),
+		m_budget(budget) {
+	}
+
+	const EvaluationBudget& getBudget(void) const {
+		return m_budget;
+	}
+
+	// `code` ends with the `Return` of the value, `inputs` are the registers it reads before writing them
+	// Nothing is returned if the code cannot run now or within the budget
+	std::optional<Value> evaluate(std::span<const Instruction> code, std::span<const std::pair<uint8_t, Value>> inputs) {
+		std::vector<uint32_t> key;
+		key.reserve(code.size() + inputs.size() * 3);
+		for (auto instruction : code)
+			key.emplace_back(std::bit_cast<uint32_t>(instruction));
+		for (auto [reg, value] : inputs) {
+			key.emplace_back(reg);
+			key.emplace_back(static_cast<uint32_t>(value));
+			key.emplace_back(static_cast<uint32_t>(value >> 32));
+		}
+		auto found = m_values.find(key);
+		if (found != m_values.end())
+			return found->second;
+
+		std::vector<Value> registers(Instruction::maxRegisterCount);
+		for (auto [reg, value] : inputs)
+			registers[reg] = value;
+		// Failures are not remembered: a call may fail only because its function is still being compiled
+		auto res = Runner::evaluate(*m_program, code, registers, m_budget.stepCount, m_budget.registerCount);
+		if (res.has_value() && m_values.size() < m_budget.memoizedValueCount)
+			m_values.emplace(std::move(key), *res);
+		return res;
+	}
+};
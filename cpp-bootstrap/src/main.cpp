@@ -6,14 +6,17 @@
 #include <set>
 #include "compiler.hpp"
 #include "runner.hpp"
+#include "disassembler.hpp"
 
 int main(int argc, char **argv) {
 	enum class Flag {
-		Inspect
+		Inspect,
+		InspectJson
 	};
 	static std::map<std::string, Flag> stringToFlag {
 		{"-i", Flag::Inspect},
-		{"--inspect", Flag::Inspect}
+		{"--inspect", Flag::Inspect},
+		{"--inspect=json", Flag::InspectJson}
 	};
 
 	try {
@@ -39,11 +42,13 @@ int main(int argc, char **argv) {
 		while (currentArg < args.size())
 			runnerArgs.emplace_back(args[currentArg++]);
 
-		auto compiler = Compiler();
-		auto program = compiler.build(entrypointPath);
+		// The compiler is dropped before running, returning the blocks of its arena to the heap
+		auto program = Compiler().build(entrypointPath);
 
-		if (flags.contains(Flag::Inspect))
-			program.inspect();
+		if (flags.contains(Flag::InspectJson))
+			Disassembler::print(program, Disassembler::Format::Json);
+		else if (flags.contains(Flag::Inspect))
+			Disassembler::print(program, Disassembler::Format::Text);
 		else {
 			auto runner = Runner();
 			runner.run(program, runnerArgs);
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include "scan.hpp"
+
+// Natural up to 256 bits, the widest scalar of the language
+class UInt256 {
+	// Least significant first
+	std::array<uint64_t, 4> m_limbs;
+
+public:
+	constexpr UInt256(uint64_t value = 0) :
+		m_limbs{value, 0, 0, 0} {
+	}
+
+	constexpr uint64_t getLimb(size_t index) const {
+		return m_limbs[index];
+	}
+
+	// Becomes `this * factor + addend`, returns false on overflow
+	constexpr bool multiplyAdd(uint64_t factor, uint64_t addend) {
+		auto carry = addend;
+		for (auto &limb : m_limbs) {
+			auto product = static_cast<unsigned __int128>(limb) * factor + carry;
+			limb = static_cast<uint64_t>(product);
+			carry = static_cast<uint64_t>(product >> 64);
+		}
+		return carry == 0;
+	}
+
+	// Smallest `N` such that `unsigned(N)` holds the value, zero for zero
+	constexpr size_t getBitWidth(void) const {
+		for (size_t i = m_limbs.size(); i > 0; i--)
+			if (m_limbs[i - 1] != 0)
+				return (i - 1) * 64 + (64 - std::countl_zero(m_limbs[i - 1]));
+		return 0;
+	}
+
+	// Becomes `this / divisor`, returns the remainder
+	constexpr uint64_t divide(uint64_t divisor) {
+		unsigned __int128 remainder = 0;
+		for (size_t i = m_limbs.size(); i > 0; i--) {
+			auto current = (remainder << 64) | m_limbs[i - 1];
+			m_limbs[i - 1] = static_cast<uint64_t>(current / divisor);
+			remainder = current % divisor;
+		}
+		return static_cast<uint64_t>(remainder);
+	}
+
+	// Nearest double, ties to even
+	constexpr double toDouble(void) const {
+		auto bitWidth = getBitWidth();
+		if (bitWidth <= 64)
+			return static_cast<double>(m_limbs[0]);
+		// The 64 most significant bits, the lowest one set if any bit below is, round as the whole value would
+		auto shift = bitWidth - 64;
+		auto limb = shift / 64;
+		auto bit = shift % 64;
+		auto top = bit == 0 ? m_limbs[limb] : (m_limbs[limb] >> bit) | (m_limbs[limb + 1] << (64 - bit));
+		bool isSticky = bit != 0 && (m_limbs[limb] & ((uint64_t(1) << bit) - 1)) != 0;
+		for (size_t i = 0; i < limb; i++)
+			isSticky = isSticky || m_limbs[i] != 0;
+		auto res = static_cast<double>(top | isSticky);
+		for (size_t i = 0; i < shift; i++)
+			res *= 2.0;
+		return res;
+	}
+
+	constexpr bool operator==(const UInt256&) const = default;
+
+	std::string toString(void) const {
+		auto remaining = *this;
+		std::string res;
+		do
+			res += static_cast<char>('0' + remaining.divide(10));
+		while (remaining != UInt256());
+		std::reverse(res.begin(), res.end());
+		return res;
+	}
+};
+
+// Value of a numeric literal: a natural when it is one, otherwise the nearest double
+// A natural written with a fraction or a negative exponent, such as `2.0`, keeps that notation and its nearest double too
+class NumberLiteral {
+	UInt256 m_integer;
+	double m_real;
+	bool m_isInteger;
+	bool m_isFractional;
+
+public:
+	constexpr NumberLiteral(const UInt256 &integer, bool isFractional = false) :
+		m_integer(integer),
+		m_real(isFractional ? integer.toDouble() : 0.0),
+		m_isInteger(true),
+		m_isFractional(isFractional) {
+	}
+	constexpr NumberLiteral(double real) :
+		m_integer(),
+		m_real(real),
+		m_isInteger(false),
+		m_isFractional(true) {
+	}
+
+	constexpr bool isInteger(void) const {
+		return m_isInteger;
+	}
+	// Written with a fraction or a negative exponent, hence a real to the program whatever its value
+	constexpr bool isFractional(void) const {
+		return m_isFractional;
+	}
+	constexpr const UInt256& getInteger(void) const {
+		return m_integer;
+	}
+	constexpr double getReal(void) const {
+		return m_real;
+	}
+
+	constexpr bool operator==(const NumberLiteral&) const = default;
+};
+
+// Values of the numeric literals of a compilation, referred to by 32-bit token payloads
+// Most literals are small naturals: these are not stored, their reference holds the value itself
+class NumberTable {
+	static constexpr uint32_t inlineBit = 1u << 31;
+
+	std::pmr::vector<NumberLiteral> m_literals;
+
+public:
+	NumberTable(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) :
+		m_literals(resource) {
+	}
+
+	// Returns the reference of the literal
+	uint32_t add(const NumberLiteral &literal) {
+		if (literal.isInteger() && !literal.isFractional() && literal.getInteger().getBitWidth() < 32)
+			return inlineBit | static_cast<uint32_t>(literal.getInteger().getLimb(0));
+		m_literals.emplace_back(literal);
+		return static_cast<uint32_t>(m_literals.size() - 1);
+	}
+
+	NumberLiteral operator[](uint32_t reference) const {
+		if (reference & inlineBit)
+			return NumberLiteral(UInt256(reference & ~inlineBit));
+		return m_literals[reference];
+	}
+
+	// Stored literals only
+	size_t size(void) const {
+		return m_literals.size();
+	}
+};
+
+// Numeric literals as of 1.3 in the specification: `*([BASE])([FRACTION].)[INTEGER](x(-)[EXPONENT])` in little-endian
+// notation, or `([BASE])[INTEGER](.[FRACTION])(x(-)[EXPONENT])` in arabic notation
+namespace number {
+	struct Scan {
+		// Past the literal, or past the malformed sequence when `value` is empty
+		size_t endOffset;
+		std::optional<NumberLiteral> value;
+		const char *error;
+	};
+
+	// Value of every byte as a hexadecimal digit, 16 for non-digits
+	inline constexpr auto digitValues = [](){
+		std::array<uint8_t, 256> res;
+		for (size_t byte = 0; byte < res.size(); byte++) {
+			if (byte >= '0' && byte <= '9')
+				res[byte] = byte - '0';
+			else if ((byte | 0x20) >= 'a' && (byte | 0x20) <= 'f')
+				res[byte] = (byte | 0x20) - 'a' + 10;
+			else
+				res[byte] = 16;
+		}
+		return res;
+	}();
+
+	// Value of `byte` as a digit, `base` or more if it is not one
+	constexpr unsigned getDigitValue(char byte) {
+		return digitValues[static_cast<uint8_t>(byte)];
+	}
+
+	constexpr unsigned getBase(char prefix) {
+		switch (prefix) {
+		case 'h':
+			return 16;
+		case 'o':
+			return 8;
+		case 'q':
+			return 4;
+		case 'b':
+			return 2;
+		default:
+			return 0;
+		}
+	}
+
+	// Digits and `_` separators, must begin with a digit
+	constexpr size_t skipDigits(std::string_view bytes, size_t offset, unsigned base) {
+		if (!(offset < bytes.size() && getDigitValue(bytes[offset]) < base))
+			return offset;
+		while (offset < bytes.size() && (getDigitValue(bytes[offset]) < base || bytes[offset] == '_'))
+			offset++;
+		return offset;
+	}
+
+	// Eight bytes, the first one in memory being the least significant
+	constexpr uint64_t loadWord(const char *data) {
+		uint64_t res = 0;
+		if consteval {
+			for (size_t i = 0; i < 8; i++)
+				res |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+		} else {
+			std::memcpy(&res, data, sizeof(res));
+		}
+		return res;
+	}
+
+	// Whether all of the eight bytes are ASCII decimal digits
+	constexpr bool isEightDigits(uint64_t word) {
+		return ((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+	}
+
+	// Value of eight decimal digits in three multiplies, the least significant byte holding the most significant digit
+	constexpr uint64_t parseEightDigits(uint64_t word) {
+		word -= 0x3030303030303030;
+		word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FF;
+		word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFF;
+		return (word * 10000 + (word >> 32)) & 0xFFFFFFFF;
+	}
+
+	// Number of decimal digits at the beginning of the word, from its least significant byte
+	constexpr unsigned countLeadingDigits(uint64_t word) {
+		// Bytes are non-zero unless their high nibble is 3 and their low nibble at most 9
+		auto nonDigits = ((word & 0xF0F0F0F0F0F0F0F0) ^ 0x3030303030303030) | (((word & 0x0F0F0F0F0F0F0F0F) + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0);
+		auto nonDigitBits = (((nonDigits & 0x7F7F7F7F7F7F7F7F) + 0x7F7F7F7F7F7F7F7F) | nonDigits) & 0x8080808080808080;
+		return std::countr_zero(nonDigitBits) / 8;
+	}
+
+	// Value of the first `count` digits of the word, the others being ignored
+	constexpr uint64_t parseLeadingDigits(uint64_t word, unsigned count, bool isLittleEndian) {
+		if (count == 0)
+			return 0;
+		// Digits are moved to the most significant bytes, below them is padding with zeros
+		auto paddingBitCount = (8 - count) * 8;
+		if (isLittleEndian)
+			word = std::byteswap(word) >> paddingBitCount << paddingBitCount;
+		else
+			word <<= paddingBitCount;
+		if (paddingBitCount != 0)
+			word |= 0x3030303030303030 >> (64 - paddingBitCount);
+		return parseEightDigits(word);
+	}
+
+	static constexpr auto powersOfTen = [](){
+		std::array<uint64_t, 17> res;
+		res[0] = 1;
+		for (size_t i = 1; i < res.size(); i++)
+			res[i] = res[i - 1] * 10;
+		return res;
+	}();
+
+	// Past this scale, the next eight digits may not fit in the 64-bit word anymore
+	static constexpr uint64_t maxScale = std::numeric_limits<uint64_t>::max() / 100000000;
+
+	// Appends the digits of `run` to `res`, returns false on overflow
+	// Digits are gathered in a 64-bit word first, only folded into `res` when the word is full
+	constexpr bool accumulateDigits(UInt256 &res, std::string_view run, unsigned base, bool isLittleEndian) {
+		uint64_t chunk = 0;
+		uint64_t scale = 1;
+		size_t i = 0;
+		while (i < run.size()) {
+			if (scale > maxScale) {
+				if (!res.multiplyAdd(scale, chunk))
+					return false;
+				chunk = 0;
+				scale = 1;
+			}
+			if (base == 10 && run.size() - i >= 8) {
+				auto word = loadWord(isLittleEndian ? run.data() + run.size() - i - 8 : run.data() + i);
+				if (isLittleEndian)
+					word = std::byteswap(word);
+				if (isEightDigits(word)) {
+					chunk = chunk * 100000000 + parseEightDigits(word);
+					scale *= 100000000;
+					i += 8;
+					continue;
+				}
+			}
+			auto byte = isLittleEndian ? run[run.size() - 1 - i] : run[i];
+			i++;
+			if (byte != '_') {
+				chunk = chunk * base + getDigitValue(byte);
+				scale *= base;
+			}
+		}
+		return res.multiplyAdd(scale, chunk);
+	}
+
+	// Exponents past this are out of the range of any double anyway
+	static constexpr int64_t maxExponent = 1 << 30;
+
+	constexpr int64_t parseExponent(std::string_view run, unsigned base, bool isLittleEndian) {
+		int64_t res = 0;
+		for (size_t i = 0; i < run.size(); i++) {
+			auto byte = isLittleEndian ? run[run.size() - 1 - i] : run[i];
+			if (byte != '_')
+				res = std::min<int64_t>(res * base + getDigitValue(byte), maxExponent);
+		}
+		return res;
+	}
+
+	constexpr double powerOfTen(int64_t exponent) {
+		double res = 1.0;
+		for (int64_t i = 0; i < exponent; i++)
+			res *= 10.0;
+		return res;
+	}
+
+	constexpr Scan scaleNatural(size_t endOffset, UInt256 significand, unsigned base, int64_t exponent, bool isFractional) {
+		if (significand != UInt256())
+			for (int64_t i = 0; i < exponent; i++)
+				if (!significand.multiplyAdd(base, 0))
+					return Scan{endOffset, std::nullopt, "numeric literal does not fit in 256 bits"};
+		return Scan{endOffset, NumberLiteral(significand, isFractional), nullptr};
+	}
+
+	// `significand * base^exponent` when a single rounding gives the nearest double, `std::nullopt` otherwise
+	constexpr std::optional<double> computeNarrowReal(uint64_t significand, unsigned base, int64_t exponent) {
+		if (base == 10) {
+			// Clinger's fast path: both operands are exact doubles
+			if (significand <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+				return exponent >= 0 ? static_cast<double>(significand) * powerOfTen(exponent) : static_cast<double>(significand) / powerOfTen(-exponent);
+			return std::nullopt;
+		}
+		// Scaling by a power of two is exact as long as the result stays normal
+		if (significand > (uint64_t(1) << 53))
+			return std::nullopt;
+		auto res = static_cast<double>(significand) * std::pow(2.0, static_cast<double>(exponent * std::countr_zero(base)));
+		if (!std::isnormal(res))
+			return std::nullopt;
+		return res;
+	}
+
+	// Slow path for significands wider than 256 bits or reals off the fast path: digits are gathered as text
+	constexpr Scan evaluateWide(size_t endOffset, std::string_view integerRun, std::string_view fractionRun, unsigned base, bool isLittleEndian, int64_t exponent) {
+		// `exponent` only counts the fraction digits when there are some
+		bool isFractional = !fractionRun.empty() || exponent < 0;
+		std::string significand;
+		for (auto run : {integerRun, fractionRun})
+			for (size_t i = 0; i < run.size(); i++) {
+				auto byte = isLittleEndian ? run[run.size() - 1 - i] : run[i];
+				if (byte != '_')
+					significand += byte;
+			}
+		while (significand.size() > 1 && significand.back() == '0' && exponent < 0) {
+			significand.pop_back();
+			exponent++;
+		}
+		if (exponent >= 0 || significand.find_first_not_of('0') == std::string::npos) {
+			UInt256 res;
+			if (!accumulateDigits(res, significand, base, false))
+				return Scan{endOffset, std::nullopt, "numeric literal does not fit in 256 bits"};
+			return scaleNatural(endOffset, res, base, exponent, isFractional);
+		}
+
+		if consteval {
+			return Scan{endOffset, std::nullopt, "numeric literal is too precise to evaluate at compile time"};
+		} else {
+			std::string text;
+			std::chars_format format;
+			if (base == 10) {
+				text = significand;
+				text += 'e';
+				text += std::to_string(exponent);
+				format = std::chars_format::scientific;
+			} else {
+				// Regrouped into hexadecimal digits from the least significant bit
+				auto bitsPerDigit = std::countr_zero(base);
+				unsigned pendingBits = 0;
+				unsigned pendingBitCount = 0;
+				for (size_t i = significand.size(); i > 0; i--) {
+					pendingBits |= getDigitValue(significand[i - 1]) << pendingBitCount;
+					pendingBitCount += bitsPerDigit;
+					while (pendingBitCount >= 4) {
+						text += "0123456789abcdef"[pendingBits & 0xF];
+						pendingBits >>= 4;
+						pendingBitCount -= 4;
+					}
+				}
+				if (pendingBitCount > 0)
+					text += "0123456789abcdef"[pendingBits & 0xF];
+				std::reverse(text.begin(), text.end());
+				text += 'p';
+				text += std::to_string(exponent * bitsPerDigit);
+				format = std::chars_format::hex;
+			}
+			double res;
+			auto [end, errorCode] = std::from_chars(text.data(), text.data() + text.size(), res, format);
+			if (errorCode != std::errc() || end != text.data() + text.size())
+				return Scan{endOffset, std::nullopt, "numeric literal is out of the range of double"};
+			return Scan{endOffset, NumberLiteral(res), nullptr};
+		}
+	}
+
+	// Exact for naturals, the nearest double otherwise
+	constexpr Scan evaluate(size_t endOffset, std::string_view integerRun, std::string_view fractionRun, unsigned base, bool isLittleEndian, int64_t exponent) {
+		bool isFractional = !fractionRun.empty() || exponent < 0;
+		for (auto byte : fractionRun)
+			exponent -= byte != '_';
+		auto untrimmedExponent = exponent;
+		UInt256 significand;
+		if (!accumulateDigits(significand, integerRun, base, isLittleEndian) || !accumulateDigits(significand, fractionRun, base, isLittleEndian))
+			return evaluateWide(endOffset, integerRun, fractionRun, base, isLittleEndian, exponent);
+
+		// Trailing zeros are moved to the exponent, so that `1.00` and `100x-2` are found to be naturals, albeit fractional ones
+		while (exponent < 0 && significand != UInt256()) {
+			auto quotient = significand;
+			if (quotient.divide(base) != 0)
+				break;
+			significand = quotient;
+			exponent++;
+		}
+		if (exponent >= 0 || significand == UInt256())
+			return scaleNatural(endOffset, significand, base, exponent, isFractional);
+		if (significand.getBitWidth() <= 64)
+			if (auto res = computeNarrowReal(significand.getLimb(0), base, exponent))
+				return Scan{endOffset, NumberLiteral(*res), nullptr};
+		return evaluateWide(endOffset, integerRun, fractionRun, base, isLittleEndian, untrimmedExponent);
+	}
+
+	static constexpr unsigned maxShortNaturalDigitCount = 19;
+
+	// Decimal naturals of up to 19 digits without separators, which most literals are
+	// Their end and their value are both found eight digits at a time, with at most three loads
+	constexpr std::optional<Scan> scanShortNatural(std::string_view bytes, size_t offset, bool isLittleEndian) {
+		if (bytes.size() - offset <= 24)
+			return std::nullopt;
+		uint64_t value = 0;
+		unsigned digitCount = 0;
+		for (;;) {
+			auto word = loadWord(bytes.data() + offset + digitCount);
+			auto wordDigitCount = countLeadingDigits(word);
+			if (digitCount + wordDigitCount > maxShortNaturalDigitCount)
+				return std::nullopt;
+			auto wordValue = parseLeadingDigits(word, wordDigitCount, isLittleEndian);
+			if (isLittleEndian)
+				value += wordValue * powersOfTen[digitCount];
+			else
+				value = value * powersOfTen[wordDigitCount] + wordValue;
+			digitCount += wordDigitCount;
+			if (wordDigitCount < 8)
+				break;
+		}
+		auto endOffset = offset + digitCount;
+		// Base prefixes, separators, fractions and exponents are left to the general path
+		if (scan::isIdentifierCharacter(bytes[endOffset]) || bytes[endOffset] == '.')
+			return std::nullopt;
+		return Scan{endOffset, NumberLiteral(UInt256(value)), nullptr};
+	}
+
+	// `offset` is at the `*` of a little-endian literal, or at the first digit of an arabic one
+	constexpr Scan scan(std::string_view bytes, size_t offset) {
+		auto malformed = [&](size_t endOffset, const char *error) {
+			while (endOffset < bytes.size() && scan::isIdentifierCharacter(bytes[endOffset]))
+				endOffset++;
+			return Scan{endOffset, std::nullopt, error};
+		};
+
+		bool isLittleEndian = bytes[offset] == '*';
+		if (isLittleEndian)
+			offset++;
+		if (auto res = scanShortNatural(bytes, offset, isLittleEndian))
+			return *res;
+		unsigned base = 10;
+		if (offset + 1 < bytes.size() && bytes[offset] == '0' && getBase(bytes[offset + 1]) != 0) {
+			base = getBase(bytes[offset + 1]);
+			offset += 2;
+		}
+
+		auto firstEnd = skipDigits(bytes, offset, base);
+		if (firstEnd == offset)
+			return malformed(offset, "expected digits in numeric literal");
+		auto firstRun = bytes.substr(offset, firstEnd - offset);
+		offset = firstEnd;
+
+		std::string_view secondRun;
+		if (offset + 1 < bytes.size() && bytes[offset] == '.' && getDigitValue(bytes[offset + 1]) < base) {
+			auto secondEnd = skipDigits(bytes, offset + 1, base);
+			secondRun = bytes.substr(offset + 1, secondEnd - offset - 1);
+			offset = secondEnd;
+		}
+
+		int64_t exponent = 0;
+		if (offset < bytes.size() && bytes[offset] == 'x') {
+			bool isNegative = offset + 1 < bytes.size() && bytes[offset + 1] == '-';
+			auto exponentBegin = offset + 1 + isNegative;
+			auto exponentEnd = skipDigits(bytes, exponentBegin, base);
+			if (exponentEnd != exponentBegin) {
+				exponent = parseExponent(bytes.substr(exponentBegin, exponentEnd - exponentBegin), base, isLittleEndian);
+				if (isNegative)
+					exponent = -exponent;
+				offset = exponentEnd;
+			}
+		}
+		if (offset < bytes.size() && scan::isIdentifierCharacter(bytes[offset]))
+			return malformed(offset, "malformed numeric literal");
+
+		// Little-endian text is arabic text read backwards: the fraction comes first
+		if (isLittleEndian && !secondRun.empty())
+			return evaluate(offset, secondRun, firstRun, base, isLittleEndian, exponent);
+		return evaluate(offset, firstRun, secondRun, base, isLittleEndian, exponent);
+	}
+
+	constexpr bool isNatural(std::string_view literal, uint64_t expected) {
+		auto res = scan(literal, 0);
+		return res.endOffset == literal.size() && res.value.has_value() && res.value->isInteger() && res.value->getInteger() == UInt256(expected);
+	}
+	constexpr bool isReal(std::string_view literal, double expected) {
+		auto res = scan(literal, 0);
+		return res.endOffset == literal.size() && res.value.has_value() && !res.value->isInteger() && res.value->getReal() == expected;
+	}
+	constexpr bool isFractionalNatural(std::string_view literal, uint64_t expected) {
+		return isNatural(literal, expected) && scan(literal, 0).value->isFractional() && scan(literal, 0).value->getReal() == static_cast<double>(expected);
+	}
+	constexpr bool isMalformed(std::string_view literal) {
+		auto res = scan(literal, 0);
+		return res.endOffset == literal.size() && !res.value.has_value();
+	}
+
+	static_assert(isNatural("0", 0) && isNatural("10", 10) && isNatural("*01", 10));
+	static_assert(isNatural("1_000_000", 1000000) && isNatural("*000_000_1", 1000000));
+	static_assert(isNatural("12345678901234567", 12345678901234567) && isNatural("*76543210987654321", 12345678901234567));
+	static_assert(isNatural("0hff", 255) && isNatural("*0hff1", 0x1FF) && isNatural("0o17", 15) && isNatural("0q33", 15) && isNatural("0b101", 5));
+	static_assert(isNatural("3x2", 300) && isNatural("*3x2", 300) && isNatural("1.5x1", 15) && isNatural("100x-2", 1) && isNatural("0h1x2", 256));
+	static_assert(isFractionalNatural("2.0", 2) && isFractionalNatural("*0.2", 2) && isFractionalNatural("100x-2", 1) && isFractionalNatural("1.5x1", 15) && !isFractionalNatural("3x2", 300));
+	static_assert(scan("1.0x30", 0).value->isFractional() && scan("1.0x30", 0).value->getReal() == 1e30 && scan("0h1_0000_0000_0000_0801.0", 0).value->getReal() == 0x1.0000000000001p64);
+	static_assert(isReal("1.5", 1.5) && isReal("*5.1", 1.5) && isReal("*52.1", 1.25) && isReal("25x-1", 2.5) && isReal("1x-1", 0.1));
+	static_assert(isReal("0b1x-1", 0.5) && isReal("0h8x-1", 0.5) && isReal("*0h8.0", 0.5));
+	static_assert(isMalformed("1abc") && isMalformed("0o8") && isMalformed("0b12") && isMalformed("*x"));
+	static_assert(isMalformed("115792089237316195423570985008687907853269984665640564039457584007913129639936"));
+	static_assert(isNatural("18446744073709551615", 18446744073709551615u));
+	// Followed by enough bytes for the short natural path
+	static_assert(scan("1234567890123456789 + 1                      ", 0).value == NumberLiteral(UInt256(1234567890123456789)));
+	static_assert(scan("*9876543210987654321 + 1                     ", 0).value == NumberLiteral(UInt256(1234567890123456789)));
+	static_assert(scan("*0000001 + 1                                 ", 0).value == NumberLiteral(UInt256(1000000)));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string_view>
+
+// Bytes written to a file through a fixed buffer, flushed with a single `fwrite` when full and when done
+class OutputBuffer {
+	std::FILE *m_file;
+	std::array<char, 1 << 14> m_buffer;
+	size_t m_size;
+
+public:
+	OutputBuffer(std::FILE *file = stdout) :
+		m_file(file),
+		m_size(0) {
+	}
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+	~OutputBuffer(void) {
+		flush();
+	}
+
+	void flush(void) {
+		std::fwrite(m_buffer.data(), 1, m_size, m_file);
+		m_size = 0;
+	}
+
+	void write(std::string_view bytes) {
+		if (m_size + bytes.size() > m_buffer.size()) {
+			flush();
+			if (bytes.size() > m_buffer.size()) {
+				std::fwrite(bytes.data(), 1, bytes.size(), m_file);
+				return;
+			}
+		}
+		std::copy(bytes.begin(), bytes.end(), m_buffer.data() + m_size);
+		m_size += bytes.size();
+	}
+
+	void write(char byte) {
+		if (m_size == m_buffer.size())
+			flush();
+		m_buffer[m_size++] = byte;
+	}
+
+	template <typename T>
+	void writeNumber(T value) {
+		char buffer[32];
+		auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+		write(std::string_view(buffer, end - buffer));
+	}
+};
@@ -0,0 +1,621 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include "token.hpp"
+#include "ast.hpp"
+
+// Syntax error, reported with a diagnostic pointing at `getToken()` by `Parser::parse`
+class ParseError : public std::runtime_error {
+	Token m_token;
+
+public:
+	ParseError(const Token &token, const std::string &message) :
+		std::runtime_error(message),
+		m_token(token) {
+	}
+
+	const Token& getToken(void) const {
+		return m_token;
+	}
+};
+
+// Recursive descent for statements, precedence climbing for expressions
+// Precedence and associativity are those of 0.1 in the specification
+// Tokens are pulled from a `TokenCursor`, nodes are appended to an `Ast` as their children complete
+class Parser {
+	// Binding strength, loosest first
+	enum class Precedence : uint8_t {
+		Lowest,
+		Assignment,
+		Conditional,
+		LowerUnary,
+		Boolean,
+		Comparison,
+		LowerBinary,
+		UpperBinary,
+		LowerArithmetic,
+		UpperArithmetic,
+		UpperUnary
+	};
+
+	static constexpr Precedence getTighter(Precedence precedence) {
+		return static_cast<Precedence>(static_cast<uint8_t>(precedence) + 1);
+	}
+
+	// Role of an operator token found after an operand
+	struct Infix {
+		// `Binary` or `Comparison`, anything else is not an infix operator
+		NodeKind kind;
+		Operator op;
+		Precedence precedence;
+	};
+
+	static constexpr auto dotIndex = Tokens::getOperatorIndex(Tokens::dot);
+	static constexpr auto leftParenthesisIndex = Tokens::getOperatorIndex(Tokens::leftParenthesis);
+	static constexpr auto rightParenthesisIndex = Tokens::getOperatorIndex(Tokens::rightParenthesis);
+	static constexpr auto leftArraySubscriptIndex = Tokens::getOperatorIndex(Tokens::leftArraySubscript);
+	static constexpr auto rightArraySubscriptIndex = Tokens::getOperatorIndex(Tokens::rightArraySubscript);
+	static constexpr auto leftBracketIndex = Tokens::getOperatorIndex(Tokens::leftBracket);
+	static constexpr auto rightBracketIndex = Tokens::getOperatorIndex(Tokens::rightBracket);
+	static constexpr auto commaIndex = Tokens::getOperatorIndex(Tokens::comma);
+	static constexpr auto colonIndex = Tokens::getOperatorIndex(Tokens::colon);
+	static constexpr auto semicolonIndex = Tokens::getOperatorIndex(Tokens::semicolon);
+	static constexpr auto assignIndex = Tokens::getOperatorIndex(Tokens::assign);
+	static constexpr auto backInsertIndex = Tokens::getOperatorIndex(Tokens::backInsert);
+	static constexpr auto incrementIndex = Tokens::getOperatorIndex(Tokens::increment);
+	static constexpr auto decrementIndex = Tokens::getOperatorIndex(Tokens::decrement);
+
+	// By operator index, `Operator::None` for tokens which cannot begin an operation on the operand to their right
+	static constexpr auto prefixOperators = [](){
+		std::array<Operator, Tokens::allOperators.size()> res {};
+		res[Tokens::getOperatorIndex(Tokens::booleanNot)] = Operator::BooleanNot;
+		res[Tokens::getOperatorIndex(Tokens::binaryNot)] = Operator::BinaryNot;
+		res[Tokens::getOperatorIndex(Tokens::plus)] = Operator::Plus;
+		res[Tokens::getOperatorIndex(Tokens::minus)] = Operator::Minus;
+		res[Tokens::getOperatorIndex(Tokens::increment)] = Operator::Increment;
+		res[Tokens::getOperatorIndex(Tokens::decrement)] = Operator::Decrement;
+		return res;
+	}();
+
+	// By operator index, only binary and comparison operators are set
+	// Postfix and assignment operators are recognized on their own
+	static constexpr auto infixOperators = [](){
+		std::array<Infix, Tokens::allOperators.size()> res {};
+		for (auto &infix : res)
+			infix = Infix{NodeKind::Identifier, Operator::None, Precedence::Lowest};
+		auto set = [&](const TokenStub &token, NodeKind kind, Operator op, Precedence precedence){
+			res[Tokens::getOperatorIndex(token)] = Infix{kind, op, precedence};
+		};
+		set(Tokens::multiplication, NodeKind::Binary, Operator::Multiplication, Precedence::UpperArithmetic);
+		set(Tokens::division, NodeKind::Binary, Operator::Division, Precedence::UpperArithmetic);
+		set(Tokens::modulo, NodeKind::Binary, Operator::Modulo, Precedence::UpperArithmetic);
+		set(Tokens::plus, NodeKind::Binary, Operator::Addition, Precedence::LowerArithmetic);
+		set(Tokens::minus, NodeKind::Binary, Operator::Subtraction, Precedence::LowerArithmetic);
+		set(Tokens::shiftedToLeftBy, NodeKind::Binary, Operator::ShiftedToLeftBy, Precedence::UpperBinary);
+		set(Tokens::shiftedToRightBy, NodeKind::Binary, Operator::ShiftedToRightBy, Precedence::UpperBinary);
+		set(Tokens::binaryOr, NodeKind::Binary, Operator::BinaryOr, Precedence::LowerBinary);
+		set(Tokens::binaryXor, NodeKind::Binary, Operator::BinaryXor, Precedence::LowerBinary);
+		set(Tokens::binaryAnd, NodeKind::Binary, Operator::BinaryAnd, Precedence::LowerBinary);
+		set(Tokens::equalTo, NodeKind::Comparison, Operator::EqualTo, Precedence::Comparison);
+		set(Tokens::differentFrom, NodeKind::Comparison, Operator::DifferentFrom, Precedence::Comparison);
+		set(Tokens::greaterThan, NodeKind::Comparison, Operator::GreaterThan, Precedence::Comparison);
+		set(Tokens::lesserThan, NodeKind::Comparison, Operator::LesserThan, Precedence::Comparison);
+		set(Tokens::greaterThanOrEqualTo, NodeKind::Comparison, Operator::GreaterThanOrEqualTo, Precedence::Comparison);
+		set(Tokens::lesserThanOrEqualTo, NodeKind::Comparison, Operator::LesserThanOrEqualTo, Precedence::Comparison);
+		return res;
+	}();
+
+	// Deeper expressions or statements are rejected rather than overflowing the stack
+	static constexpr size_t maxNestingDepth = 1024;
+
+	TokenCursor *m_cursor;
+	Ast *m_ast;
+	// Children of the lists being parsed, as a stack: nested lists are pushed and popped above the enclosing ones,
+	// and each list is copied at once to the tree when complete, so that its children are contiguous there
+	std::vector<NodeIndex> m_pendingChildren;
+	// Number of `()` and `[]` enclosing the current expression, within which linefeeds do not end it
+	size_t m_groupingDepth;
+	size_t m_nestingDepth;
+	// Last consumed token, for errors at the end of the file
+	std::optional<Token> m_lastToken;
+
+	Parser(TokenCursor &cursor, Ast &ast) :
+		m_cursor(&cursor),
+		m_ast(&ast),
+		m_groupingDepth(0),
+		m_nestingDepth(0) {
+	}
+
+	std::optional<Token> peek(size_t distance = 0) {
+		return m_cursor->peek(distance);
+	}
+
+	// Must have a token left
+	Token next(void) {
+		m_lastToken = m_cursor->next();
+		return *m_lastToken;
+	}
+
+	static bool isOperator(const std::optional<Token> &token, uint32_t operatorIndex) {
+		return token.has_value() && token->getClass() == TokenClass::Operator && token->getOperatorIndex() == operatorIndex;
+	}
+
+	static bool isKeyword(const std::optional<Token> &token, Symbol keyword) {
+		return token.has_value() && token->getClass() == TokenClass::Identifier && token->getSymbol() == keyword;
+	}
+
+	// Keywords which cannot stand for a value
+	static bool isReservedKeyword(Symbol symbol) {
+		switch (symbol) {
+		case Symbols::forKeyword:
+		case Symbols::inKeyword:
+		case Symbols::thenKeyword:
+		case Symbols::elseKeyword:
+		case Symbols::whileKeyword:
+		case Symbols::returnKeyword:
+		case Symbols::andKeyword:
+		case Symbols::orKeyword:
+		case Symbols::xorKeyword:
+		case Symbols::importKeyword:
+		case Symbols::exportKeyword:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	[[noreturn]] void fail(const std::optional<Token> &token, const std::string &message) {
+		if (token.has_value())
+			throw ParseError(*token, message);
+		if (m_lastToken.has_value())
+			throw ParseError(*m_lastToken, message + " before the end of the file");
+		throw ParseError(Token(m_cursor->getFile(), TokenClass::Operator, 0, 0), message + ", the file is empty");
+	}
+
+	Token expectOperator(uint32_t operatorIndex) {
+		auto token = peek();
+		if (!isOperator(token, operatorIndex))
+			fail(token, "expected '" + std::string(Tokens::allOperators[operatorIndex].getString()) + "'");
+		return next();
+	}
+
+	void expectKeyword(Symbol keyword) {
+		auto token = peek();
+		if (!isKeyword(token, keyword))
+			fail(token, "expected '" + std::string(Symbols::keywords[keyword]) + "'");
+		next();
+	}
+
+	Symbol expectName(void) {
+		auto token = peek();
+		if (!token.has_value() || token->getClass() != TokenClass::Identifier || isReservedKeyword(token->getSymbol()))
+			fail(token, "expected a name");
+		return next().getSymbol();
+	}
+
+	void skipLinefeeds(void) {
+		while (true) {
+			auto token = peek();
+			if (!token.has_value() || token->getClass() != TokenClass::Layout)
+				return;
+			next();
+		}
+	}
+
+	void enterNesting(const std::optional<Token> &token) {
+		if (++m_nestingDepth > maxNestingDepth)
+			fail(token, "nested too deeply");
+	}
+
+	// Moves the children pushed from `firstPending` to the tree, returns the index of the first one there
+	uint32_t popPendingList(size_t firstPending) {
+		auto children = std::span<const NodeIndex>(m_pendingChildren.data() + firstPending, m_pendingChildren.size() - firstPending);
+		auto res = m_ast->addList(children);
+		m_pendingChildren.resize(firstPending);
+		return res;
+	}
+
+	// Within `()` or `[]`, the closing operator must follow the expression
+	NodeIndex parseGroupedExpression(uint32_t closingOperatorIndex) {
+		m_groupingDepth++;
+		auto res = parseExpression(Precedence::Lowest);
+		skipLinefeeds();
+		expectOperator(closingOperatorIndex);
+		m_groupingDepth--;
+		return res;
+	}
+
+	NodeIndex parseExpression(Precedence minPrecedence) {
+		enterNesting(peek());
+		auto res = parseInfix(parsePrefix(), minPrecedence);
+		m_nestingDepth--;
+		return res;
+	}
+
+	// Operand along with its prefix operators, postfix operators are left to `parseInfix`
+	NodeIndex parsePrefix(void) {
+		if (m_groupingDepth > 0)
+			skipLinefeeds();
+		auto token = peek();
+		if (!token.has_value())
+			fail(token, "expected an expression");
+
+		switch (token->getClass()) {
+		case TokenClass::Identifier:
+			next();
+			switch (token->getSymbol()) {
+			case Symbols::ifKeyword:
+				return parseConditional(*token, parseExpression(Precedence::LowerUnary));
+			case Symbols::notKeyword:
+				return m_ast->add(NodeKind::Prefix, Operator::Not, *token, parseExpression(Precedence::Boolean));
+			case Symbols::functionKeyword:
+				return parseFunction(*token);
+			default:
+				if (isReservedKeyword(token->getSymbol()))
+					fail(token, "expected an expression");
+				return m_ast->add(NodeKind::Identifier, Operator::None, *token, token->getSymbol());
+			}
+		case TokenClass::NumberLiteral:
+			next();
+			return m_ast->add(NodeKind::NumberLiteral, Operator::None, *token, token->getNumberReference());
+		case TokenClass::StringLiteral:
+			next();
+			return m_ast->add(NodeKind::StringLiteral, Operator::None, *token);
+		case TokenClass::Operator: {
+			if (token->getOperatorIndex() == leftParenthesisIndex) {
+				next();
+				return parseGroupedExpression(rightParenthesisIndex);
+			}
+			if (token->getOperatorIndex() == leftArraySubscriptIndex) {
+				next();
+				return parseArrayType(*token);
+			}
+			auto op = prefixOperators[token->getOperatorIndex()];
+			if (op == Operator::None)
+				break;
+			next();
+			// Right-to-left: the operand takes the tighter operators to its right first
+			return m_ast->add(NodeKind::Prefix, op, *token, parseExpression(Precedence::UpperUnary));
+		}
+		case TokenClass::Layout:
+			break;
+		}
+		fail(token, "expected an expression");
+	}
+
+	// Extends `lhs` with operators binding at least as tight as `minPrecedence`
+	NodeIndex parseInfix(NodeIndex lhs, Precedence minPrecedence) {
+		while (true) {
+			if (m_groupingDepth > 0)
+				skipLinefeeds();
+			auto token = peek();
+			if (!token.has_value())
+				return lhs;
+
+			if (token->getClass() == TokenClass::Identifier) {
+				Operator op;
+				switch (token->getSymbol()) {
+				case Symbols::andKeyword:
+					op = Operator::And;
+					break;
+				case Symbols::orKeyword:
+					op = Operator::Or;
+					break;
+				case Symbols::xorKeyword:
+					op = Operator::Xor;
+					break;
+				default:
+					return lhs;
+				}
+				if (minPrecedence > Precedence::Boolean)
+					return lhs;
+				next();
+				lhs = m_ast->add(NodeKind::Binary, op, *token, lhs, parseExpression(getTighter(Precedence::Boolean)));
+				continue;
+			}
+			if (token->getClass() != TokenClass::Operator)
+				return lhs;
+
+			// Postfix operators bind tighter than anything else
+			auto operatorIndex = token->getOperatorIndex();
+			if (operatorIndex == dotIndex) {
+				next();
+				lhs = m_ast->add(NodeKind::Member, Operator::None, *token, lhs, expectName());
+				continue;
+			}
+			if (operatorIndex == leftParenthesisIndex) {
+				next();
+				lhs = parseCall(*token, lhs);
+				continue;
+			}
+			if (operatorIndex == leftArraySubscriptIndex) {
+				next();
+				lhs = m_ast->add(NodeKind::Subscript, Operator::None, *token, lhs, parseGroupedExpression(rightArraySubscriptIndex));
+				continue;
+			}
+			if (operatorIndex == incrementIndex || operatorIndex == decrementIndex) {
+				next();
+				lhs = m_ast->add(NodeKind::Postfix, operatorIndex == incrementIndex ? Operator::Increment : Operator::Decrement, *token, lhs);
+				continue;
+			}
+
+			// Right-to-left, except for back insertions which chain from the target: `out <<- a <<- b` inserts `a` then `b`
+			if (operatorIndex == assignIndex || operatorIndex == backInsertIndex) {
+				if (minPrecedence > Precedence::Assignment)
+					return lhs;
+				next();
+				if (operatorIndex == assignIndex)
+					lhs = m_ast->add(NodeKind::Assignment, Operator::Assign, *token, lhs, parseExpression(Precedence::Assignment));
+				else
+					lhs = m_ast->add(NodeKind::Assignment, Operator::BackInsert, *token, lhs, parseExpression(Precedence::Conditional));
+				continue;
+			}
+
+			auto &infix = infixOperators[operatorIndex];
+			if (infix.op == Operator::None)
+				return lhs;
+			// Compound assignment is written as two tokens: `acc + <- x`
+			if (infix.kind == NodeKind::Binary && isOperator(peek(1), assignIndex)) {
+				if (minPrecedence > Precedence::Assignment)
+					return lhs;
+				next();
+				next();
+				lhs = m_ast->add(NodeKind::Assignment, infix.op, *token, lhs, parseExpression(Precedence::Assignment));
+				continue;
+			}
+			if (infix.precedence < minPrecedence)
+				return lhs;
+			if (infix.kind == NodeKind::Comparison) {
+				lhs = parseComparisons(lhs);
+				continue;
+			}
+			next();
+			lhs = m_ast->add(NodeKind::Binary, infix.op, *token, lhs, parseExpression(getTighter(infix.precedence)));
+		}
+	}
+
+	// `a _< x < b` holds as `a _< x and x < b`, with `x` evaluated once
+	NodeIndex parseComparisons(NodeIndex lhs) {
+		auto firstPending = m_pendingChildren.size();
+		auto firstToken = *peek();
+		auto left = lhs;
+		while (true) {
+			auto token = peek();
+			if (!token.has_value() || token->getClass() != TokenClass::Operator)
+				break;
+			auto &infix = infixOperators[token->getOperatorIndex()];
+			if (infix.kind != NodeKind::Comparison)
+				break;
+			next();
+			auto right = parseExpression(getTighter(Precedence::Comparison));
+			m_pendingChildren.push_back(m_ast->add(NodeKind::Comparison, infix.op, *token, left, right));
+			left = right;
+			if (m_groupingDepth > 0)
+				skipLinefeeds();
+		}
+		auto linkCount = static_cast<uint32_t>(m_pendingChildren.size() - firstPending);
+		if (linkCount == 1) {
+			auto res = m_pendingChildren.back();
+			m_pendingChildren.pop_back();
+			return res;
+		}
+		return m_ast->add(NodeKind::ComparisonChain, Operator::None, firstToken, popPendingList(firstPending), linkCount);
+	}
+
+	// After `(`
+	NodeIndex parseCall(const Token &leftParenthesis, NodeIndex callee) {
+		auto firstPending = m_pendingChildren.size();
+		m_groupingDepth++;
+		skipLinefeeds();
+		if (!isOperator(peek(), rightParenthesisIndex)) {
+			while (true) {
+				m_pendingChildren.push_back(parseExpression(Precedence::Lowest));
+				skipLinefeeds();
+				if (!isOperator(peek(), commaIndex))
+					break;
+				next();
+			}
+		}
+		expectOperator(rightParenthesisIndex);
+		m_groupingDepth--;
+		auto argumentCount = static_cast<uint32_t>(m_pendingChildren.size() - firstPending);
+		return m_ast->add(NodeKind::Call, Operator::None, leftParenthesis, callee, popPendingList(firstPending), argumentCount);
+	}
+
+	// After `[`: `[]type` or `[size]type`, the call constructing the array is left to `parseInfix`
+	NodeIndex parseArrayType(const Token &leftArraySubscript) {
+		auto size = Nodes::none;
+		if (isOperator(peek(), rightArraySubscriptIndex))
+			next();
+		else
+			size = parseGroupedExpression(rightArraySubscriptIndex);
+		enterNesting(peek());
+		auto elementType = parsePrefix();
+		m_nestingDepth--;
+		return m_ast->add(NodeKind::ArrayType, Operator::None, leftArraySubscript, size, elementType);
+	}
+
+	// After the predicate
+	NodeIndex parseConditional(const Token &ifToken, NodeIndex predicate) {
+		if (m_groupingDepth > 0)
+			skipLinefeeds();
+		expectKeyword(Symbols::thenKeyword);
+		auto valueIfTrue = parseExpression(Precedence::LowerUnary);
+		if (m_groupingDepth > 0)
+			skipLinefeeds();
+		expectKeyword(Symbols::elseKeyword);
+		// `else if` chains to the right
+		auto valueIfFalse = parseExpression(Precedence::Conditional);
+		return m_ast->add(NodeKind::Conditional, Operator::None, ifToken, predicate, valueIfTrue, valueIfFalse);
+	}
+
+	// After `function`: `function(name, name: type, ...) { ... }`
+	NodeIndex parseFunction(const Token &functionToken) {
+		expectOperator(leftParenthesisIndex);
+		auto firstPending = m_pendingChildren.size();
+		m_groupingDepth++;
+		skipLinefeeds();
+		if (!isOperator(peek(), rightParenthesisIndex)) {
+			while (true) {
+				// Present once `expectName` succeeds
+				auto nameToken = peek();
+				auto name = expectName();
+				auto type = Nodes::none;
+				if (isOperator(peek(), colonIndex)) {
+					next();
+					type = parseExpression(Precedence::Lowest);
+				}
+				m_pendingChildren.push_back(m_ast->add(NodeKind::Parameter, Operator::None, *nameToken, name, type));
+				skipLinefeeds();
+				if (!isOperator(peek(), commaIndex))
+					break;
+				next();
+				skipLinefeeds();
+			}
+		}
+		expectOperator(rightParenthesisIndex);
+		m_groupingDepth--;
+		auto parameterCount = static_cast<uint32_t>(m_pendingChildren.size() - firstPending);
+		auto parameters = popPendingList(firstPending);
+		skipLinefeeds();
+		auto leftBracket = expectOperator(leftBracketIndex);
+		auto body = parseBlock(leftBracket, false);
+		return m_ast->add(NodeKind::Function, Operator::None, functionToken, parameters, parameterCount, body);
+	}
+
+	// Statements up to the closing `}`, or up to the end of the file for the top-level block
+	NodeIndex parseBlock(const Token &beginToken, bool isTopLevel) {
+		// Statements within a function passed as an argument still end on linefeeds
+		auto enclosingGroupingDepth = m_groupingDepth;
+		m_groupingDepth = 0;
+		auto firstPending = m_pendingChildren.size();
+		while (true) {
+			auto token = peek();
+			if (token.has_value() && (token->getClass() == TokenClass::Layout || isOperator(token, semicolonIndex))) {
+				next();
+				continue;
+			}
+			if (!token.has_value()) {
+				if (!isTopLevel)
+					fail(token, "expected '}'");
+				break;
+			}
+			if (isOperator(token, rightBracketIndex)) {
+				if (isTopLevel)
+					fail(token, "unmatched '}'");
+				next();
+				break;
+			}
+			m_pendingChildren.push_back(parseStatement());
+		}
+		m_groupingDepth = enclosingGroupingDepth;
+		auto statementCount = static_cast<uint32_t>(m_pendingChildren.size() - firstPending);
+		return m_ast->add(NodeKind::Block, Operator::None, beginToken, popPendingList(firstPending), statementCount);
+	}
+
+	// Simple statements must be followed by a linefeed, `;`, `}`, the end of the file, or the `else` of an enclosing `if` scope
+	// written on one line, none of which is consumed
+	void expectStatementEnd(void) {
+		auto token = peek();
+		if (!token.has_value() || token->getClass() == TokenClass::Layout || isOperator(token, semicolonIndex) ||
+			isOperator(token, rightBracketIndex) || isKeyword(token, Symbols::elseKeyword))
+			return;
+		fail(token, "expected the end of the statement");
+	}
+
+	// Body of a control statement, on the same line or the next ones
+	NodeIndex parseBody(void) {
+		skipLinefeeds();
+		return parseStatement();
+	}
+
+	NodeIndex parseStatement(void) {
+		auto token = peek();
+		if (!token.has_value())
+			fail(token, "expected a statement");
+		enterNesting(token);
+		NodeIndex res;
+		if (isOperator(token, leftBracketIndex)) {
+			next();
+			res = parseBlock(*token, false);
+		} else if (isKeyword(token, Symbols::forKeyword))
+			res = parseFor();
+		else if (isKeyword(token, Symbols::whileKeyword)) {
+			next();
+			expectOperator(leftParenthesisIndex);
+			auto condition = parseGroupedExpression(rightParenthesisIndex);
+			res = m_ast->add(NodeKind::While, Operator::None, *token, condition, parseBody());
+		} else if (isKeyword(token, Symbols::ifKeyword) && isOperator(peek(1), leftParenthesisIndex))
+			res = parseIf();
+		else if (isKeyword(token, Symbols::returnKeyword)) {
+			next();
+			auto value = Nodes::none;
+			auto valueToken = peek();
+			if (valueToken.has_value() && valueToken->getClass() != TokenClass::Layout && !isOperator(valueToken, semicolonIndex) &&
+				!isOperator(valueToken, rightBracketIndex))
+				value = parseExpression(Precedence::Lowest);
+			expectStatementEnd();
+			res = m_ast->add(NodeKind::Return, Operator::None, *token, value);
+		} else {
+			res = parseExpression(Precedence::Lowest);
+			expectStatementEnd();
+		}
+		m_nestingDepth--;
+		return res;
+	}
+
+	// `for (name in value) body`
+	NodeIndex parseFor(void) {
+		auto forToken = next();
+		expectOperator(leftParenthesisIndex);
+		m_groupingDepth++;
+		skipLinefeeds();
+		auto variable = expectName();
+		skipLinefeeds();
+		expectKeyword(Symbols::inKeyword);
+		m_groupingDepth--;
+		auto iterated = parseGroupedExpression(rightParenthesisIndex);
+		return m_ast->add(NodeKind::For, Operator::None, forToken, variable, iterated, parseBody());
+	}
+
+	// `if (predicate) body else body` scope, or `if (predicate) then value else value` expression statement:
+	// the latter is told apart by the `then` right after the parentheses
+	NodeIndex parseIf(void) {
+		auto ifToken = next();
+		expectOperator(leftParenthesisIndex);
+		auto predicate = parseGroupedExpression(rightParenthesisIndex);
+		if (isKeyword(peek(), Symbols::thenKeyword)) {
+			auto res = parseInfix(parseConditional(ifToken, predicate), Precedence::Lowest);
+			expectStatementEnd();
+			return res;
+		}
+		auto bodyIfTrue = parseBody();
+		auto bodyIfFalse = Nodes::none;
+		// Consumed linefeeds only separated statements
+		skipLinefeeds();
+		if (isKeyword(peek(), Symbols::elseKeyword)) {
+			next();
+			bodyIfFalse = parseBody();
+		}
+		return m_ast->add(NodeKind::If, Operator::None, ifToken, predicate, bodyIfTrue, bodyIfFalse);
+	}
+
+public:
+	// Parses the whole file behind `cursor` into `ast`, its root is set to the top-level `Block`
+	static void parse(TokenCursor &cursor, Ast &ast) {
+		auto parser = Parser(cursor, ast);
+		try {
+			ast.setRoot(parser.parseBlock(Token(cursor.getFile(), TokenClass::Operator, 0, 0), true));
+		} catch (const ParseError &error) {
+			token::printMessage({error.getToken()}, error.what());
+			throw std::runtime_error("Parsing failed");
+		}
+	}
+};
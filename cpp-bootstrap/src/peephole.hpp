@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bitset>
+#include <vector>
+#include "program.hpp"
+
+// Fuses sequences of instructions into superinstructions, over the code of a function once it is complete
+// The sequences are the most executed pairs reported by `bench/interpret`:
+// - `multiply_integer t, b, c; add_integer a, a, t` to `multiply_add_integer a, b, c`
+// - `lesser_integer t, a, b; jump_if_true t` to `jump_if_lesser_integer a, b`
+// - `add_integer_immediate a, a, 1` followed by the above to `increment_jump_if_lesser_integer a, b`
+// The temporary `t` must not be read afterwards, and only the first instruction of a sequence can be jumped to
+class Peephole {
+	using RegisterSet = std::bitset<Instruction::maxRegisterCount>;
+
+	const Program *m_program;
+	std::vector<Instruction> *m_code;
+	std::vector<bool> m_isJumpTarget;
+	// By instruction, the registers that may be read before being written again once it is executed
+	std::vector<RegisterSet> m_liveAfter;
+
+	Peephole(const Program &program, std::vector<Instruction> &code) :
+		m_program(&program),
+		m_code(&code) {
+	}
+
+	static size_t getJumpTarget(size_t index, Instruction instruction) {
+		return static_cast<size_t>(static_cast<int64_t>(index) + 1 + instruction.getJumpOffset());
+	}
+
+	static bool hasFallthrough(Instruction instruction) {
+		auto opcode = instruction.getOpcode();
+		return opcode != Opcode::Jump && opcode != Opcode::Return && opcode != Opcode::ReturnNothing;
+	}
+
+	void findJumpTargets(void) {
+		auto &code = *m_code;
+		m_isJumpTarget.assign(code.size() + 1, false);
+		for (size_t i = 0; i < code.size(); i++)
+			if (code[i].isJump())
+				m_isJumpTarget[getJumpTarget(i, code[i])] = true;
+	}
+
+	// Backward data flow, iterated until loops bring nothing new
+	void findLiveRegisters(void) {
+		auto &code = *m_code;
+		std::vector<RegisterSet> liveBefore(code.size() + 1);
+		m_liveAfter.assign(code.size(), RegisterSet());
+		bool isChanged = true;
+		while (isChanged) {
+			isChanged = false;
+			for (size_t i = code.size(); i-- > 0;) {
+				auto instruction = code[i];
+				RegisterSet after;
+				if (hasFallthrough(instruction))
+					after |= liveBefore[i + 1];
+				if (instruction.isJump())
+					after |= liveBefore[getJumpTarget(i, instruction)];
+				auto before = after;
+				if (instruction.isWritingA())
+					before.reset(instruction.getA());
+				m_program->forEachReadRegister(instruction, [&](uint8_t reg){
+					before.set(reg);
+				});
+				m_liveAfter[i] = after;
+				if (before != liveBefore[i]) {
+					liveBefore[i] = before;
+					isChanged = true;
+				}
+			}
+		}
+	}
+
+	// `lesser_integer t, a, b; jump_if_true t` at `index`
+	bool isLesserJump(size_t index) const {
+		auto &code = *m_code;
+		if (index + 1 >= code.size() || m_isJumpTarget[index + 1])
+			return false;
+		auto compare = code[index];
+		auto jump = code[index + 1];
+		return compare.getOpcode() == Opcode::LesserInteger && jump.getOpcode() == Opcode::JumpIfTrue
+			&& jump.getA() == compare.getA() && !m_liveAfter[index + 1].test(compare.getA())
+			&& jump.getJumpOffset() >= -Instruction::maxSignedC - 1 && jump.getJumpOffset() <= Instruction::maxSignedC;
+	}
+
+	// Replaces the sequence starting at `index` by a superinstruction, returns the length of the sequence
+	// Jump offsets are left as is, relative to the end of the sequence
+	size_t fuse(size_t index, Instruction &fused) const {
+		auto &code = *m_code;
+		auto instruction = code[index];
+		switch (instruction.getOpcode()) {
+		case Opcode::MultiplyInteger: {
+			if (index + 1 >= code.size() || m_isJumpTarget[index + 1])
+				break;
+			auto add = code[index + 1];
+			auto product = instruction.getA();
+			if (add.getOpcode() != Opcode::AddInteger || m_liveAfter[index + 1].test(product) || add.getA() == product)
+				break;
+			if ((add.getB() == add.getA() && add.getC() == product) || (add.getC() == add.getA() && add.getB() == product)) {
+				fused = Instruction::make(Opcode::MultiplyAddInteger, add.getA(), instruction.getB(), instruction.getC());
+				return 2;
+			}
+			break;
+		}
+		case Opcode::AddIntegerImmediate: {
+			if (instruction.getA() != instruction.getB() || instruction.getSignedC() != 1
+				|| m_isJumpTarget[index + 1] || !isLesserJump(index + 1))
+				break;
+			auto compare = code[index + 1];
+			if (compare.getB() != instruction.getA() || compare.getC() == instruction.getA())
+				break;
+			fused = Instruction::make(Opcode::IncrementJumpIfLesserInteger, instruction.getA(), compare.getC());
+			fused.setJumpOffset(code[index + 2].getJumpOffset());
+			return 3;
+		}
+		case Opcode::LesserInteger:
+			if (!isLesserJump(index))
+				break;
+			fused = Instruction::make(Opcode::JumpIfLesserInteger, instruction.getB(), instruction.getC());
+			fused.setJumpOffset(code[index + 1].getJumpOffset());
+			return 2;
+		default:
+			break;
+		}
+		fused = instruction;
+		return 1;
+	}
+
+	void fuseAll(std::vector<SourceLocation> &sourceLocations, std::vector<Annotation> &annotations) {
+		auto &code = *m_code;
+		std::vector<Instruction> fusedCode;
+		std::vector<Annotation> fusedAnnotations;
+		// By instruction, the index of what it became, or the one following its superinstruction if it was fused into it
+		std::vector<uint32_t> newIndices(code.size() + 1);
+		// By new instruction, the old index of its jump target
+		std::vector<size_t> oldTargets;
+		for (size_t i = 0; i < code.size();) {
+			Instruction fused;
+			auto length = fuse(i, fused);
+			auto newIndex = static_cast<uint32_t>(fusedCode.size());
+			newIndices[i] = newIndex;
+			for (size_t j = 1; j < length; j++)
+				newIndices[i + j] = newIndex + 1;
+			oldTargets.emplace_back(fused.isJump() ? getJumpTarget(i + length - 1, fused) : 0);
+			fusedCode.emplace_back(fused);
+			// A superinstruction runs as often as its first instruction, its written value is another one
+			auto annotation = annotations[i];
+			if (length > 1) {
+				annotation.hasRange = false;
+				if (!fused.isWritingA())
+					annotation.typeSet = 0;
+			}
+			fusedAnnotations.emplace_back(annotation);
+			i += length;
+		}
+		newIndices[code.size()] = static_cast<uint32_t>(fusedCode.size());
+		if (fusedCode.size() == code.size())
+			return;
+
+		// Jumps get shorter, never longer, so they still fit
+		for (size_t i = 0; i < fusedCode.size(); i++)
+			if (fusedCode[i].isJump())
+				fusedCode[i].setJumpOffset(static_cast<int32_t>(newIndices[oldTargets[i]]) - static_cast<int32_t>(i + 1));
+		code = std::move(fusedCode);
+		annotations = std::move(fusedAnnotations);
+
+		// A run starting within a fused sequence starts after it, unless the next run starts there too
+		std::vector<SourceLocation> fusedLocations;
+		for (auto location : sourceLocations) {
+			location.instructionIndex = newIndices[location.instructionIndex];
+			if (!fusedLocations.empty() && fusedLocations.back().instructionIndex == location.instructionIndex)
+				fusedLocations.back() = location;
+			else
+				fusedLocations.emplace_back(location);
+		}
+		sourceLocations = std::move(fusedLocations);
+	}
+
+public:
+	// `code` is the code of a function about to be set in `program`, along with its `sourceLocations` and `annotations`
+	static void optimize(const Program &program, std::vector<Instruction> &code, std::vector<SourceLocation> &sourceLocations,
+		std::vector<Annotation> &annotations) {
+		auto peephole = Peephole(program, code);
+		peephole.findJumpTargets();
+		peephole.findLiveRegisters();
+		peephole.fuseAll(sourceLocations, annotations);
+	}
+};
@@ -1,10 +1,538 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Static type of a register, instructions are typed so registers themselves are not
+enum class ValueType : uint8_t {
+	Integer,
+	Real,
+	Bool,
+	String,
+	// Runtime-sized, filled by back-insertion
+	Array
+};
+
+static constexpr size_t valueTypeCount = static_cast<size_t>(ValueType::Array) + 1;
+
+inline std::string_view getValueTypeName(ValueType type) {
+	static constexpr std::array<std::string_view, valueTypeCount> names = {"integer", "real", "bool", "string", "array"};
+	return names[static_cast<size_t>(type)];
+}
+
+// Register contents: integers as two's complement, reals by their bits, bools as zero or one,
+// strings as their index within the strings of the program and arrays as the address of their storage
+using Value = uint64_t;
+
+// Operands of each opcode, as laid out in the instruction
+enum class OperandFormat : uint8_t {
+	// Nothing
+	None,
+	// Register `a`
+	A,
+	// Registers `a` and `b`
+	AB,
+	// Registers `a`, `b` and `c`
+	ABC,
+	// Registers `a` and `b`, signed 8-bit immediate or jump offset `c`
+	ABsC,
+	// Register `a`, unsigned 16-bit index `bx`
+	ABx,
+	// Register `a`, signed 16-bit immediate or jump offset `bx`
+	AsBx,
+	// Signed 24-bit jump offset `ax`
+	sAx
+};
+
+// `a` is the destination unless stated otherwise
+// Jump offsets are relative to the instruction following the jump
+enum class Opcode : uint8_t {
+	Move,
+	// `a <- bx`
+	LoadInteger,
+	// `a <- constants[bx]`
+	LoadConstant,
+	// `a <- bx`, the index of a string
+	LoadString,
+	IntegerToReal,
+
+	AddInteger,
+	SubtractInteger,
+	MultiplyInteger,
+	DivideInteger,
+	ModuloInteger,
+	// `a <- b + c`
+	AddIntegerImmediate,
+	NegateInteger,
+	ShiftLeft,
+	ShiftRight,
+	// Also the `or`, `xor` and `and` of bools
+	BinaryOr,
+	BinaryXor,
+	BinaryAnd,
+	BinaryNot,
+
+	AddReal,
+	SubtractReal,
+	MultiplyReal,
+	DivideReal,
+	ModuloReal,
+	NegateReal,
+
+	BooleanNot,
+
+	// `a <- b = c`, also the equality of bools
+	EqualInteger,
+	DifferentInteger,
+	// Greater-than comparisons are lesser-than ones with their operands swapped
+	LesserInteger,
+	LesserOrEqualInteger,
+	EqualReal,
+	DifferentReal,
+	LesserReal,
+	LesserOrEqualReal,
+
+	Jump,
+	// Jumps if the bool `a` is set
+	JumpIfTrue,
+	JumpIfFalse,
+	// Arguments are in `a` onwards, which is the base of the frame of the function at index `bx`
+	// Its returned value, if any, is written to `a`
+	Call,
+	// Returns the value of `a`
+	Return,
+	ReturnNothing,
+
+	// Prints the value of `a` to the standard output
+	PrintInteger,
+	PrintReal,
+	PrintBool,
+	PrintString,
+	PrintLinefeed,
+
+	// `a <- ` an empty array with room for `b` elements, its size being counted by the compiler
+	NewArray,
+	// Pops the array `a` along with every array created after it, as the scope declaring `a` ends
+	PopArrays,
+	// Appends the value of `b` to the array `a`, which has room for it
+	BackInsert,
+	// Non-negative counts, for the sizes of arrays: they saturate instead of wrapping around
+	// `a <- b * c`, `c` being taken as zero if negative
+	MultiplyCount,
+	AddCount,
+	// `a <- b[c]`, failing unless `0 _< c < ` the size of `b`
+	LoadElement,
+	// `a[b] <- c`, failing unless `0 _< b < ` the size of `a`
+	StoreElement,
+	// Same without the bounds check, where `RangeAnalysis` proves the index within the size of the array
+	LoadElementUnchecked,
+	StoreElementUnchecked,
+
+	// Superinstructions, fused from the most executed sequences by `Peephole`
+	// `a <- a + b * c`
+	MultiplyAddInteger,
+	// Jumps if `a < b`
+	JumpIfLesserInteger,
+	// `a <- a + 1`, then jumps if `a < b`, the step of `count` loops
+	IncrementJumpIfLesserInteger
+};
+
+struct OpcodeInfo {
+	std::string_view name;
+	OperandFormat format;
+};
+
+static constexpr std::array<OpcodeInfo, 56> opcodeInfos = {{
+	{"move", OperandFormat::AB},
+	{"load_integer", OperandFormat::AsBx},
+	{"load_constant", OperandFormat::ABx},
+	{"load_string", OperandFormat::ABx},
+	{"integer_to_real", OperandFormat::AB},
+
+	{"add_integer", OperandFormat::ABC},
+	{"subtract_integer", OperandFormat::ABC},
+	{"multiply_integer", OperandFormat::ABC},
+	{"divide_integer", OperandFormat::ABC},
+	{"modulo_integer", OperandFormat::ABC},
+	{"add_integer_immediate", OperandFormat::ABsC},
+	{"negate_integer", OperandFormat::AB},
+	{"shift_left", OperandFormat::ABC},
+	{"shift_right", OperandFormat::ABC},
+	{"binary_or", OperandFormat::ABC},
+	{"binary_xor", OperandFormat::ABC},
+	{"binary_and", OperandFormat::ABC},
+	{"binary_not", OperandFormat::AB},
+
+	{"add_real", OperandFormat::ABC},
+	{"subtract_real", OperandFormat::ABC},
+	{"multiply_real", OperandFormat::ABC},
+	{"divide_real", OperandFormat::ABC},
+	{"modulo_real", OperandFormat::ABC},
+	{"negate_real", OperandFormat::AB},
+
+	{"boolean_not", OperandFormat::AB},
+
+	{"equal_integer", OperandFormat::ABC},
+	{"different_integer", OperandFormat::ABC},
+	{"lesser_integer", OperandFormat::ABC},
+	{"lesser_or_equal_integer", OperandFormat::ABC},
+	{"equal_real", OperandFormat::ABC},
+	{"different_real", OperandFormat::ABC},
+	{"lesser_real", OperandFormat::ABC},
+	{"lesser_or_equal_real", OperandFormat::ABC},
+
+	{"jump", OperandFormat::sAx},
+	{"jump_if_true", OperandFormat::AsBx},
+	{"jump_if_false", OperandFormat::AsBx},
+	{"call", OperandFormat::ABx},
+	{"return", OperandFormat::A},
+	{"return_nothing", OperandFormat::None},
+
+	{"print_integer", OperandFormat::A},
+	{"print_real", OperandFormat::A},
+	{"print_bool", OperandFormat::A},
+	{"print_string", OperandFormat::A},
+	{"print_linefeed", OperandFormat::None},
+
+	{"new_array", OperandFormat::AB},
+	{"pop_arrays", OperandFormat::A},
+	{"back_insert", OperandFormat::AB},
+	{"multiply_count", OperandFormat::ABC},
+	{"add_count", OperandFormat::ABC},
+	{"load_element", OperandFormat::ABC},
+	{"store_element", OperandFormat::ABC},
+	{"load_element_unchecked", OperandFormat::ABC},
+	{"store_element_unchecked", OperandFormat::ABC},
+
+	{"multiply_add_integer", OperandFormat::ABC},
+	{"jump_if_lesser_integer", OperandFormat::ABsC},
+	{"increment_jump_if_lesser_integer", OperandFormat::ABsC}
+}};
+
+static_assert(opcodeInfos.size() == static_cast<size_t>(Opcode::IncrementJumpIfLesserInteger) + 1);
+
+constexpr const OpcodeInfo& getOpcodeInfo(Opcode opcode) {
+	return opcodeInfos[static_cast<size_t>(opcode)];
+}
+
+// Fixed-width instruction: the opcode in the low byte, then register `a`, then either registers `b` and `c`
+// or the 16-bit `bx` spanning both, or the 24-bit `ax` spanning all three operand bytes
+class Instruction {
+	uint32_t m_bits;
+
+	constexpr Instruction(uint32_t bits) :
+		m_bits(bits) {
+	}
+
+public:
+	// Registers of a frame are addressed by `a`, `b` and `c`
+	static constexpr size_t maxRegisterCount = 256;
+	static constexpr int32_t maxSignedC = 0x7F;
+	static constexpr int32_t maxSignedBx = 0x7FFF;
+	static constexpr int32_t maxSignedAx = 0x7FFFFF;
+
+	constexpr Instruction(void) :
+		m_bits(0) {
+	}
+
+	static constexpr Instruction make(Opcode opcode, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0) {
+		return Instruction(static_cast<uint32_t>(opcode) | (uint32_t(a) << 8) | (uint32_t(b) << 16) | (uint32_t(c) << 24));
+	}
+	static constexpr Instruction makeWide(Opcode opcode, uint8_t a, uint16_t bx) {
+		return Instruction(static_cast<uint32_t>(opcode) | (uint32_t(a) << 8) | (uint32_t(bx) << 16));
+	}
+	// Must have `-maxSignedBx - 1 _< bx _< maxSignedBx`
+	static constexpr Instruction makeSignedWide(Opcode opcode, uint8_t a, int32_t bx) {
+		return makeWide(opcode, a, static_cast<uint16_t>(bx));
+	}
+	// Must have `-maxSignedAx - 1 _< ax _< maxSignedAx`
+	static constexpr Instruction makeJump(Opcode opcode, int32_t ax) {
+		return Instruction(static_cast<uint32_t>(opcode) | (static_cast<uint32_t>(ax) << 8));
+	}
+
+	constexpr Opcode getOpcode(void) const {
+		return static_cast<Opcode>(m_bits & 0xFF);
+	}
+	constexpr uint8_t getA(void) const {
+		return static_cast<uint8_t>(m_bits >> 8);
+	}
+	constexpr uint8_t getB(void) const {
+		return static_cast<uint8_t>(m_bits >> 16);
+	}
+	constexpr uint8_t getC(void) const {
+		return static_cast<uint8_t>(m_bits >> 24);
+	}
+	constexpr int8_t getSignedC(void) const {
+		return static_cast<int8_t>(m_bits >> 24);
+	}
+	constexpr uint16_t getBx(void) const {
+		return static_cast<uint16_t>(m_bits >> 16);
+	}
+	constexpr int16_t getSignedBx(void) const {
+		return static_cast<int16_t>(m_bits >> 16);
+	}
+	// Arithmetic shift, the sign of the 24 bits is extended
+	constexpr int32_t getSignedAx(void) const {
+		return static_cast<int32_t>(m_bits) >> 8;
+	}
+
+	constexpr bool isJump(void) const {
+		switch (getOpcode()) {
+		case Opcode::Jump:
+		case Opcode::JumpIfTrue:
+		case Opcode::JumpIfFalse:
+		case Opcode::JumpIfLesserInteger:
+		case Opcode::IncrementJumpIfLesserInteger:
+			return true;
+		default:
+			return false;
+		}
+	}
+	// Whether register `a` is written, which is the only one that can be
+	constexpr bool isWritingA(void) const {
+		switch (getOpcodeInfo(getOpcode()).format) {
+		case OperandFormat::AB:
+			return getOpcode() != Opcode::BackInsert;
+		case OperandFormat::ABC:
+			return getOpcode() != Opcode::StoreElement && getOpcode() != Opcode::StoreElementUnchecked;
+		case OperandFormat::ABx:
+			return true;
+		case OperandFormat::ABsC:
+			return getOpcode() != Opcode::JumpIfLesserInteger;
+		case OperandFormat::AsBx:
+			return getOpcode() == Opcode::LoadInteger;
+		default:
+			return false;
+		}
+	}
+
+	// Must be a jump, its offset is in the operand spanning the most bits left by the others
+	constexpr int32_t getJumpOffset(void) const {
+		switch (getOpcodeInfo(getOpcode()).format) {
+		case OperandFormat::ABsC:
+			return getSignedC();
+		case OperandFormat::AsBx:
+			return getSignedBx();
+		default:
+			return getSignedAx();
+		}
+	}
+	// Must be a jump, and `offset` must fit in its operand
+	constexpr void setJumpOffset(int32_t offset) {
+		switch (getOpcodeInfo(getOpcode()).format) {
+		case OperandFormat::ABsC:
+			m_bits = (m_bits & 0xFFFFFF) | (static_cast<uint32_t>(offset) << 24);
+			break;
+		case OperandFormat::AsBx:
+			setSignedBx(offset);
+			break;
+		default:
+			setSignedAx(offset);
+			break;
+		}
+	}
+
+	// Keeps the opcode and `a`, for jumps patched once their target is known
+	constexpr void setSignedBx(int32_t bx) {
+		m_bits = (m_bits & 0xFFFF) | (uint32_t(static_cast<uint16_t>(bx)) << 16);
+	}
+	constexpr void setSignedAx(int32_t ax) {
+		m_bits = (m_bits & 0xFF) | (static_cast<uint32_t>(ax) << 8);
+	}
+};
+
+static_assert(sizeof(Instruction) == 4);
+static_assert(Instruction::make(Opcode::AddInteger, 1, 2, 3).getC() == 3);
+static_assert(Instruction::makeSignedWide(Opcode::LoadInteger, 4, -2).getSignedBx() == -2);
+static_assert(Instruction::makeJump(Opcode::Jump, -Instruction::maxSignedAx - 1).getSignedAx() == -Instruction::maxSignedAx - 1);
+static_assert([]{
+	auto instruction = Instruction::make(Opcode::JumpIfLesserInteger, 1, 2);
+	instruction.setJumpOffset(-Instruction::maxSignedC - 1);
+	return instruction.getJumpOffset() == -Instruction::maxSignedC - 1 && instruction.getB() == 2;
+}());
+
+// First instruction of a run of instructions built from the same source location
+struct SourceLocation {
+	uint32_t instructionIndex;
+	uint32_t line;
+	uint32_t column;
+};
+
+// Integer bound relative to the value a register holds at the same point
+struct AffineBound {
+	uint8_t reg;
+	int64_t offset;
+
+	bool operator==(const AffineBound&) const = default;
+};
+
+// What the compiler knows about an instruction, for inspection
+struct Annotation {
+	static constexpr uint64_t unknownCount = UINT64_MAX;
+
+	// Bit per `ValueType` the written register may hold, zero if nothing is written
+	uint8_t typeSet;
+	// Bounds of the written integer, meaningless unless `hasRange`
+	bool hasRange;
+	int64_t minimum;
+	int64_t maximum;
+	// Upper bound on how many times the instruction runs over a whole execution, `unknownCount` if none is known
+	uint64_t executionCount;
+	// Bounds of the written integer relative to other registers
+	std::optional<AffineBound> lowerBound = std::nullopt;
+	std::optional<AffineBound> upperBound = std::nullopt;
+};
+
+struct Function {
+	// Along with its argument types, functions being specialized for each of them
+	std::string name;
+	uint32_t codeBegin;
+	uint32_t codeSize;
+	uint8_t parameterCount;
+	// Parameters included
+	uint16_t registerCount;
+};
+
+// Compiled program, self-contained: nothing points back to the sources nor to the compiler
+// Code of every function is contiguous within a single instruction array, the entry point is the first function
+// Constants, strings and source locations are side tables, so that the instructions stay dense
 class Program {
+	std::vector<Instruction> m_code;
+	std::vector<Value> m_constants;
+	// For inspection only, the loading instructions need not know
+	std::vector<ValueType> m_constantTypes;
+	std::vector<std::string> m_strings;
+	std::vector<Function> m_functions;
+	// Ordered by instruction index
+	std::vector<SourceLocation> m_sourceLocations;
+	// By instruction
+	std::vector<Annotation> m_annotations;
+	std::string m_sourcePath;
+
 public:
 	Program(void) {
 	}
 
-	void inspect(void) {
+	std::span<const Instruction> getCode(void) const {
+		return m_code;
+	}
+
+	uint32_t addConstant(ValueType type, Value value) {
+		m_constants.emplace_back(value);
+		m_constantTypes.emplace_back(type);
+		return static_cast<uint32_t>(m_constants.size() - 1);
+	}
+	const std::vector<Value>& getConstants(void) const {
+		return m_constants;
+	}
+	ValueType getConstantType(uint32_t index) const {
+		return m_constantTypes[index];
+	}
+
+	uint32_t addString(std::string_view string) {
+		m_strings.emplace_back(string);
+		return static_cast<uint32_t>(m_strings.size() - 1);
+	}
+	const std::string& getString(uint32_t index) const {
+		return m_strings[index];
+	}
+	size_t getStringCount(void) const {
+		return m_strings.size();
+	}
+
+	// The code is set once the function is compiled, so that it can be called from its own body meanwhile
+	uint32_t addFunction(std::string_view name, uint8_t parameterCount) {
+		m_functions.emplace_back(Function{std::string(name), 0, 0, parameterCount, parameterCount});
+		return static_cast<uint32_t>(m_functions.size() - 1);
+	}
+	// Appends the code of the function, `sourceLocations` being relative to its first instruction
+	// `annotations` has one entry by instruction
+	void setFunctionCode(uint32_t index, uint16_t registerCount, std::span<const Instruction> code, std::span<const SourceLocation> sourceLocations,
+		std::span<const Annotation> annotations) {
+		auto &function = m_functions[index];
+		function.codeBegin = static_cast<uint32_t>(m_code.size());
+		function.codeSize = static_cast<uint32_t>(code.size());
+		function.registerCount = registerCount;
+		for (auto location : sourceLocations) {
+			location.instructionIndex += function.codeBegin;
+			m_sourceLocations.emplace_back(location);
+		}
+		m_code.insert(m_code.end(), code.begin(), code.end());
+		m_annotations.insert(m_annotations.end(), annotations.begin(), annotations.end());
+	}
+	const Function& getFunction(uint32_t index) const {
+		return m_functions[index];
+	}
+	size_t getFunctionCount(void) const {
+		return m_functions.size();
+	}
+
+	void setSourcePath(std::string_view sourcePath) {
+		m_sourcePath = sourcePath;
+	}
+	const std::string& getSourcePath(void) const {
+		return m_sourcePath;
+	}
+
+	// Calls `function` with each register the instruction reads, `Call` reading the arguments of its callee
+	template <typename Function>
+	void forEachReadRegister(Instruction instruction, Function &&function) const {
+		auto opcode = instruction.getOpcode();
+		switch (getOpcodeInfo(opcode).format) {
+		case OperandFormat::None:
+		case OperandFormat::sAx:
+			break;
+		case OperandFormat::A:
+			function(instruction.getA());
+			break;
+		case OperandFormat::AB:
+			function(instruction.getB());
+			if (opcode == Opcode::BackInsert)
+				function(instruction.getA());
+			break;
+		case OperandFormat::ABC:
+			function(instruction.getB());
+			function(instruction.getC());
+			if (opcode == Opcode::MultiplyAddInteger || opcode == Opcode::StoreElement || opcode == Opcode::StoreElementUnchecked)
+				function(instruction.getA());
+			break;
+		case OperandFormat::ABsC:
+			function(instruction.getB());
+			if (instruction.isJump())
+				function(instruction.getA());
+			break;
+		case OperandFormat::ABx:
+			if (opcode == Opcode::Call)
+				for (size_t i = 0; i < m_functions[instruction.getBx()].parameterCount; i++)
+					function(static_cast<uint8_t>(instruction.getA() + i));
+			break;
+		case OperandFormat::AsBx:
+			if (opcode != Opcode::LoadInteger)
+				function(instruction.getA());
+			break;
+		}
+	}
+
+	const Annotation& getAnnotation(size_t instructionIndex) const {
+		return m_annotations[instructionIndex];
+	}
+
+	// Location the instruction was built from, line zero if unknown
+	SourceLocation getSourceLocation(size_t instructionIndex) const {
+		auto found = std::upper_bound(m_sourceLocations.begin(), m_sourceLocations.end(), instructionIndex,
+			[](size_t index, const SourceLocation &location){
+				return index < location.instructionIndex;
+			});
+		if (found == m_sourceLocations.begin())
+			return SourceLocation{static_cast<uint32_t>(instructionIndex), 0, 0};
+		return *(found - 1);
 	}
-};
\ No newline at end of file
+};
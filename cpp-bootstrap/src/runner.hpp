@@ -1,14 +1,551 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <stdexcept>
+#include <vector>
 #include "program.hpp"
+#include "output.hpp"
+#include "stack.hpp"
+
+// Dispatch is threaded through a table of label addresses with GCC-compatible compilers, one indirect jump
+// at the end of each handler, unless `SPP_SWITCH_DISPATCH` is defined or the extension is missing
+// The fallback is a loop around a `switch`, one shared indirect jump
+#if defined(__GNUC__) && !defined(SPP_SWITCH_DISPATCH)
+#define SPP_THREADED_DISPATCH
+#endif
+
+// Executed instructions by opcode, filled by `Runner::profile`
+struct Profile {
+	std::array<uint64_t, opcodeInfos.size()> opcodeCounts {};
+	// By opcode, then by the opcode executed right after it, what superinstructions are picked from
+	std::array<std::array<uint64_t, opcodeInfos.size()>, opcodeInfos.size()> pairCounts {};
+
+	uint64_t getInstructionCount(void) const {
+		uint64_t res = 0;
+		for (auto count : opcodeCounts)
+			res += count;
+		return res;
+	}
+};
 
 class Runner {
+	struct Frame {
+		const Instruction *returnAddress;
+		// Within the register file
+		size_t base;
+#ifdef SPP_GROWN_ARRAYS
+		// Arrays created before the call, those created since are released on return
+		size_t arrayCount;
+#else
+		// Top of the array stack before the call, the arrays allocated since are popped on return
+		char *arrayTop;
+#endif
+	};
+
+	// Storage of an array: its size, then room for as many elements as the compiler counted, bumped on a `Stack`
+	// With `SPP_GROWN_ARRAYS`, arrays ignore that count and grow like any `std::vector`, the baseline of `bench/back_insert`
+#ifdef SPP_GROWN_ARRAYS
+	using ArrayStorage = std::unique_ptr<std::vector<Value>>;
+#endif
+
+	// Deeper calls are reported instead of exhausting memory
+	static constexpr size_t maxCallDepth = 1 << 16;
+	// Larger arrays are reported instead of attempted
+	static constexpr uint64_t maxArraySize = uint64_t(1) << 32;
+	// Address space reserved for the arrays of a run, only committed as they fill it
+	static constexpr size_t arrayStackAddressBitCount = 40;
+
+	[[noreturn, gnu::cold]] static void fail(const Program &program, const Instruction *ip, const std::string &message) {
+		auto index = static_cast<size_t>(ip - program.getCode().data());
+		auto location = program.getSourceLocation(index);
+		throw std::runtime_error(program.getSourcePath() + ":" + std::to_string(location.line) + ":" + std::to_string(location.column) + ": " + message);
+	}
+
+	// Of the array whose storage `array` addresses
+	static Value getArraySize(Value array) {
+#ifdef SPP_GROWN_ARRAYS
+		return reinterpret_cast<std::vector<Value>*>(array)->size();
+#else
+		return reinterpret_cast<Value*>(array)[0];
+#endif
+	}
+	static Value& getElement(Value array, Value index) {
+#ifdef SPP_GROWN_ARRAYS
+		return (*reinterpret_cast<std::vector<Value>*>(array))[index];
+#else
+		return reinterpret_cast<Value*>(array)[index + 1];
+#endif
+	}
+
+	[[gnu::cold]] static std::string describeOutOfBounds(Value index, Value array) {
+		return "index " + std::to_string(asInteger(index)) + " is out of the bounds of an array of " + std::to_string(getArraySize(array)) + " elements";
+	}
+
+	static int64_t asInteger(Value value) {
+		return static_cast<int64_t>(value);
+	}
+	static double asReal(Value value) {
+		return std::bit_cast<double>(value);
+	}
+	static Value fromReal(double value) {
+		return std::bit_cast<Value>(value);
+	}
+
+	static void count(Profile &profile, size_t &previousOpcode, Instruction instruction) {
+		auto opcode = static_cast<size_t>(instruction.getOpcode());
+		profile.opcodeCounts[opcode]++;
+		if (previousOpcode < opcodeInfos.size())
+			profile.pairCounts[previousOpcode][opcode]++;
+		previousOpcode = opcode;
+	}
+
+	enum class Mode {
+		Run,
+		// Counts executed instructions in the profile
+		Profile,
+		// At compile time: bounded by the limits, and stopped short of any output
+		Evaluate
+	};
+
+	// What is left to an evaluation
+	struct Limits {
+		uint64_t stepCount;
+		// Registers of all frames
+		size_t registerCount;
+	};
+
+	static std::vector<Value> createRegisterFile(const Program &program) {
+		return std::vector<Value>(std::max<size_t>(program.getFunction(0).registerCount, Instruction::maxRegisterCount) * 4);
+	}
+
+	// The instruction pointer and the base of the frame stay in locals, the compiler keeps them in machine registers
+	// Integer arithmetic wraps around, it is done on the unsigned registers
+	// Cross-jumping would merge the dispatch jumps ending every handler back into a single one
+	// Returns whether the code returned from its frame, rather than being stopped by `Mode::Evaluate`
+	template <Mode mode>
+#if defined(SPP_THREADED_DISPATCH) && !defined(__clang__)
+	[[gnu::optimize("no-crossjumping", "no-gcse")]]
+#endif
+	static bool execute(const Program &program, const Instruction *entry, std::vector<Value> &registerFile, Profile *profile, Limits *limits) {
+		auto code = program.getCode().data();
+		auto constants = program.getConstants().data();
+		std::vector<Frame> frames;
+		// Arrays cannot outlive the scope which created them, nor its function
+#ifdef SPP_GROWN_ARRAYS
+		std::vector<ArrayStorage> arrays;
+#else
+		// Evaluations create no array, and skip the reservation
+		auto arrays = mode == Mode::Evaluate ? Stack() : Stack(arrayStackAddressBitCount);
+#endif
+		// Bytes printed by the program
+		auto output = OutputBuffer();
+
+		const Instruction *ip = entry;
+		Value *registers = registerFile.data();
+		Instruction instruction;
+		// None yet for the first instruction
+		[[maybe_unused]] size_t previousOpcode = opcodeInfos.size();
+
+#ifdef SPP_THREADED_DISPATCH
+		static const void *const handlers[] = {
+			&&MoveHandler, &&LoadIntegerHandler, &&LoadConstantHandler, &&LoadStringHandler, &&IntegerToRealHandler,
+			&&AddIntegerHandler, &&SubtractIntegerHandler, &&MultiplyIntegerHandler, &&DivideIntegerHandler, &&ModuloIntegerHandler,
+			&&AddIntegerImmediateHandler, &&NegateIntegerHandler, &&ShiftLeftHandler, &&ShiftRightHandler,
+			&&BinaryOrHandler, &&BinaryXorHandler, &&BinaryAndHandler, &&BinaryNotHandler,
+			&&AddRealHandler, &&SubtractRealHandler, &&MultiplyRealHandler, &&DivideRealHandler, &&ModuloRealHandler, &&NegateRealHandler,
+			&&BooleanNotHandler,
+			&&EqualIntegerHandler, &&DifferentIntegerHandler, &&LesserIntegerHandler, &&LesserOrEqualIntegerHandler,
+			&&EqualRealHandler, &&DifferentRealHandler, &&LesserRealHandler, &&LesserOrEqualRealHandler,
+			&&JumpHandler, &&JumpIfTrueHandler, &&JumpIfFalseHandler, &&CallHandler, &&ReturnHandler, &&ReturnNothingHandler,
+			&&PrintIntegerHandler, &&PrintRealHandler, &&PrintBoolHandler, &&PrintStringHandler, &&PrintLinefeedHandler,
+			&&NewArrayHandler, &&PopArraysHandler, &&BackInsertHandler, &&MultiplyCountHandler, &&AddCountHandler,
+			&&LoadElementHandler, &&StoreElementHandler, &&LoadElementUncheckedHandler, &&StoreElementUncheckedHandler,
+			&&MultiplyAddIntegerHandler, &&JumpIfLesserIntegerHandler, &&IncrementJumpIfLesserIntegerHandler
+		};
+		static_assert(std::size(handlers) == opcodeInfos.size());
+#define SPP_DISPATCH() \
+		instruction = *ip++; \
+		if constexpr (mode == Mode::Profile) \
+			count(*profile, previousOpcode, instruction); \
+		if constexpr (mode == Mode::Evaluate) \
+			if (limits->stepCount-- == 0) \
+				return false; \
+		goto *handlers[static_cast<size_t>(instruction.getOpcode())]
+#define SPP_HANDLER(opcode) opcode##Handler:
+#define SPP_NEXT() SPP_DISPATCH()
+
+		SPP_DISPATCH();
+#else
+#define SPP_HANDLER(opcode) case Opcode::opcode:
+#define SPP_NEXT() continue
+
+		for (;;) {
+			instruction = *ip++;
+			if constexpr (mode == Mode::Profile)
+				count(*profile, previousOpcode, instruction);
+			if constexpr (mode == Mode::Evaluate)
+				if (limits->stepCount-- == 0)
+					return false;
+			switch (instruction.getOpcode()) {
+#endif
+
+		// `a`, `b` and `c` registers of the current instruction
+#define SPP_A registers[instruction.getA()]
+#define SPP_B registers[instruction.getB()]
+#define SPP_C registers[instruction.getC()]
+// Failing at compile time leaves the code to fail at runtime instead
+#define SPP_FAIL(message) \
+		do { \
+			if constexpr (mode == Mode::Evaluate) \
+				return false; \
+			else \
+				fail(program, ip - 1, message); \
+		} while (false)
+
+		SPP_HANDLER(Move)
+			SPP_A = SPP_B;
+			SPP_NEXT();
+		SPP_HANDLER(LoadInteger)
+			SPP_A = static_cast<Value>(static_cast<int64_t>(instruction.getSignedBx()));
+			SPP_NEXT();
+		SPP_HANDLER(LoadConstant)
+			SPP_A = constants[instruction.getBx()];
+			SPP_NEXT();
+		SPP_HANDLER(LoadString)
+			SPP_A = instruction.getBx();
+			SPP_NEXT();
+		SPP_HANDLER(IntegerToReal)
+			SPP_A = fromReal(static_cast<double>(asInteger(SPP_B)));
+			SPP_NEXT();
+
+		SPP_HANDLER(AddInteger)
+			SPP_A = SPP_B + SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(SubtractInteger)
+			SPP_A = SPP_B - SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(MultiplyInteger)
+			SPP_A = SPP_B * SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(DivideInteger) {
+			auto divisor = asInteger(SPP_C);
+			if (divisor == 0)
+				SPP_FAIL("division by zero");
+			// Also avoids the overflow of the most negative integer divided by -1
+			SPP_A = divisor == -1 ? Value(0) - SPP_B : static_cast<Value>(asInteger(SPP_B) / divisor);
+			SPP_NEXT();
+		}
+		SPP_HANDLER(ModuloInteger) {
+			auto divisor = asInteger(SPP_C);
+			if (divisor == 0)
+				SPP_FAIL("division by zero");
+			SPP_A = divisor == -1 ? Value(0) : static_cast<Value>(asInteger(SPP_B) % divisor);
+			SPP_NEXT();
+		}
+		SPP_HANDLER(AddIntegerImmediate)
+			SPP_A = SPP_B + static_cast<Value>(static_cast<int64_t>(instruction.getSignedC()));
+			SPP_NEXT();
+		SPP_HANDLER(NegateInteger)
+			SPP_A = Value(0) - SPP_B;
+			SPP_NEXT();
+		// Shifting by 64 bits or more shifts everything out, negative counts are huge unsigned ones
+		SPP_HANDLER(ShiftLeft)
+			SPP_A = SPP_C < 64 ? SPP_B << SPP_C : Value(0);
+			SPP_NEXT();
+		SPP_HANDLER(ShiftRight)
+			SPP_A = static_cast<Value>(asInteger(SPP_B) >> std::min<Value>(SPP_C, 63));
+			SPP_NEXT();
+		SPP_HANDLER(BinaryOr)
+			SPP_A = SPP_B | SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(BinaryXor)
+			SPP_A = SPP_B ^ SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(BinaryAnd)
+			SPP_A = SPP_B & SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(BinaryNot)
+			SPP_A = ~SPP_B;
+			SPP_NEXT();
+
+		SPP_HANDLER(AddReal)
+			SPP_A = fromReal(asReal(SPP_B) + asReal(SPP_C));
+			SPP_NEXT();
+		SPP_HANDLER(SubtractReal)
+			SPP_A = fromReal(asReal(SPP_B) - asReal(SPP_C));
+			SPP_NEXT();
+		SPP_HANDLER(MultiplyReal)
+			SPP_A = fromReal(asReal(SPP_B) * asReal(SPP_C));
+			SPP_NEXT();
+		SPP_HANDLER(DivideReal)
+			SPP_A = fromReal(asReal(SPP_B) / asReal(SPP_C));
+			SPP_NEXT();
+		SPP_HANDLER(ModuloReal)
+			SPP_A = fromReal(std::fmod(asReal(SPP_B), asReal(SPP_C)));
+			SPP_NEXT();
+		SPP_HANDLER(NegateReal)
+			SPP_A = fromReal(-asReal(SPP_B));
+			SPP_NEXT();
+
+		SPP_HANDLER(BooleanNot)
+			SPP_A = SPP_B ^ 1;
+			SPP_NEXT();
+
+		SPP_HANDLER(EqualInteger)
+			SPP_A = SPP_B == SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(DifferentInteger)
+			SPP_A = SPP_B != SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(LesserInteger)
+			SPP_A = asInteger(SPP_B) < asInteger(SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(LesserOrEqualInteger)
+			SPP_A = asInteger(SPP_B) <= asInteger(SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(EqualReal)
+			SPP_A = asReal(SPP_B) == asReal(SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(DifferentReal)
+			SPP_A = asReal(SPP_B) != asReal(SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(LesserReal)
+			SPP_A = asReal(SPP_B) < asReal(SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(LesserOrEqualReal)
+			SPP_A = asReal(SPP_B) <= asReal(SPP_C);
+			SPP_NEXT();
+
+		SPP_HANDLER(Jump)
+			ip += instruction.getSignedAx();
+			SPP_NEXT();
+		SPP_HANDLER(JumpIfTrue)
+			if (SPP_A != 0)
+				ip += instruction.getSignedBx();
+			SPP_NEXT();
+		SPP_HANDLER(JumpIfFalse)
+			if (SPP_A == 0)
+				ip += instruction.getSignedBx();
+			SPP_NEXT();
+		SPP_HANDLER(Call) {
+			auto &callee = program.getFunction(instruction.getBx());
+			// Functions get their code once compiled, it is empty meanwhile
+			if constexpr (mode == Mode::Evaluate)
+				if (callee.codeSize == 0 || static_cast<size_t>(registers - registerFile.data()) + instruction.getA() + callee.registerCount > limits->registerCount)
+					return false;
+			if (frames.size() >= maxCallDepth)
+				SPP_FAIL("more than " + std::to_string(maxCallDepth) + " nested calls");
+			auto base = static_cast<size_t>(registers - registerFile.data());
+			auto calleeBase = base + instruction.getA();
+#ifdef SPP_GROWN_ARRAYS
+			frames.emplace_back(Frame{ip, base, arrays.size()});
+#else
+			frames.emplace_back(Frame{ip, base, arrays.getTop()});
+#endif
+			// Growing moves the register file, the frame base is found again from its index
+			if (calleeBase + callee.registerCount > registerFile.size())
+				registerFile.resize(std::max(registerFile.size() * 2, calleeBase + callee.registerCount));
+			registers = registerFile.data() + calleeBase;
+			ip = code + callee.codeBegin;
+			SPP_NEXT();
+		}
+		// The base of the callee frame is the register the caller expects the value in
+		SPP_HANDLER(Return)
+			registers[0] = SPP_A;
+			if (frames.empty())
+				return true;
+			ip = frames.back().returnAddress;
+			registers = registerFile.data() + frames.back().base;
+#ifdef SPP_GROWN_ARRAYS
+			if (arrays.size() > frames.back().arrayCount) [[unlikely]]
+				arrays.resize(frames.back().arrayCount);
+#else
+			arrays.setTop(frames.back().arrayTop);
+#endif
+			frames.pop_back();
+			SPP_NEXT();
+		SPP_HANDLER(ReturnNothing)
+			if (frames.empty())
+				return true;
+			ip = frames.back().returnAddress;
+			registers = registerFile.data() + frames.back().base;
+#ifdef SPP_GROWN_ARRAYS
+			if (arrays.size() > frames.back().arrayCount) [[unlikely]]
+				arrays.resize(frames.back().arrayCount);
+#else
+			arrays.setTop(frames.back().arrayTop);
+#endif
+			frames.pop_back();
+			SPP_NEXT();
+
+		SPP_HANDLER(PrintInteger)
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			output.writeNumber(asInteger(SPP_A));
+			SPP_NEXT();
+		SPP_HANDLER(PrintReal)
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			output.writeNumber(asReal(SPP_A));
+			SPP_NEXT();
+		SPP_HANDLER(PrintBool)
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			output.write(SPP_A != 0 ? "true" : "false");
+			SPP_NEXT();
+		SPP_HANDLER(PrintString)
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			output.write(program.getString(static_cast<uint32_t>(SPP_A)));
+			SPP_NEXT();
+		SPP_HANDLER(PrintLinefeed)
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			output.write("\n");
+			SPP_NEXT();
+
+		SPP_HANDLER(NewArray) {
+			if constexpr (mode == Mode::Evaluate)
+				return false;
+			auto capacity = SPP_B;
+			if (capacity > maxArraySize)
+				SPP_FAIL("array of up to " + std::to_string(capacity) + " elements, more than " + std::to_string(maxArraySize));
+#ifdef SPP_GROWN_ARRAYS
+			arrays.emplace_back(std::make_unique<std::vector<Value>>());
+			SPP_A = reinterpret_cast<Value>(arrays.back().get());
+#else
+			auto storage = static_cast<Value*>(arrays.allocate((capacity + 1) * sizeof(Value), alignof(Value)));
+			if (storage == nullptr)
+				SPP_FAIL("arrays of more than " + std::to_string(arrays.getReservedByteCount()) + " bytes in total");
+			storage[0] = 0;
+			SPP_A = reinterpret_cast<Value>(storage);
+#endif
+			SPP_NEXT();
+		}
+		// Arrays are created in the order their scopes are entered, those after `a` belong to scopes within its own
+		SPP_HANDLER(PopArrays) {
+#ifdef SPP_GROWN_ARRAYS
+			auto array = reinterpret_cast<std::vector<Value>*>(SPP_A);
+			while (arrays.back().get() != array)
+				arrays.pop_back();
+			arrays.pop_back();
+#else
+			arrays.setTop(reinterpret_cast<char*>(SPP_A));
+#endif
+			SPP_NEXT();
+		}
+		// Neither a reallocation nor a capacity check
+		SPP_HANDLER(BackInsert) {
+#ifdef SPP_GROWN_ARRAYS
+			reinterpret_cast<std::vector<Value>*>(SPP_A)->push_back(SPP_B);
+#else
+			auto array = reinterpret_cast<Value*>(SPP_A);
+			array[++array[0]] = SPP_B;
+#endif
+			SPP_NEXT();
+		}
+		SPP_HANDLER(MultiplyCount) {
+			int64_t product;
+			if (__builtin_mul_overflow(asInteger(SPP_B), std::max<int64_t>(asInteger(SPP_C), 0), &product))
+				product = INT64_MAX;
+			SPP_A = static_cast<Value>(product);
+			SPP_NEXT();
+		}
+		SPP_HANDLER(AddCount) {
+			int64_t sum;
+			if (__builtin_add_overflow(asInteger(SPP_B), asInteger(SPP_C), &sum))
+				sum = INT64_MAX;
+			SPP_A = static_cast<Value>(sum);
+			SPP_NEXT();
+		}
+
+		// Negative indices are huge unsigned ones, beyond any size
+		SPP_HANDLER(LoadElement)
+			if (SPP_C >= getArraySize(SPP_B)) [[unlikely]]
+				SPP_FAIL(describeOutOfBounds(SPP_C, SPP_B));
+			SPP_A = getElement(SPP_B, SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(StoreElement)
+			if (SPP_B >= getArraySize(SPP_A)) [[unlikely]]
+				SPP_FAIL(describeOutOfBounds(SPP_B, SPP_A));
+			getElement(SPP_A, SPP_B) = SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(LoadElementUnchecked)
+			SPP_A = getElement(SPP_B, SPP_C);
+			SPP_NEXT();
+		SPP_HANDLER(StoreElementUnchecked)
+			getElement(SPP_A, SPP_B) = SPP_C;
+			SPP_NEXT();
+
+		SPP_HANDLER(MultiplyAddInteger)
+			SPP_A += SPP_B * SPP_C;
+			SPP_NEXT();
+		SPP_HANDLER(JumpIfLesserInteger)
+			if (asInteger(SPP_A) < asInteger(SPP_B))
+				ip += instruction.getSignedC();
+			SPP_NEXT();
+		SPP_HANDLER(IncrementJumpIfLesserInteger)
+			SPP_A++;
+			if (asInteger(SPP_A) < asInteger(SPP_B))
+				ip += instruction.getSignedC();
+			SPP_NEXT();
+
+#ifndef SPP_THREADED_DISPATCH
+			}
+		}
+#endif
+
+#undef SPP_A
+#undef SPP_B
+#undef SPP_C
+#undef SPP_FAIL
+#undef SPP_NEXT
+#undef SPP_HANDLER
+#undef SPP_DISPATCH
+	}
+
 public:
 	Runner(void) {
 	}
 
-	void run(const Program &program, const std::vector<std::string> &arguments) {
+	// Arguments are not accessible from programs yet
+	void run(const Program &program, [[maybe_unused]] const std::vector<std::string> &arguments) {
+		auto registerFile = createRegisterFile(program);
+		execute<Mode::Run>(program, program.getCode().data() + program.getFunction(0).codeBegin, registerFile, nullptr, nullptr);
+	}
+
+	// Like `run`, counting every executed instruction along the way
+	void profile(const Program &program, Profile &profile) {
+		auto registerFile = createRegisterFile(program);
+		execute<Mode::Profile>(program, program.getCode().data() + program.getFunction(0).codeBegin, registerFile, &profile, nullptr);
+	}
+
+	// Runs `code`, ending with a `Return`, from a frame whose first registers are `registers`, while the program is being compiled
+	// Nothing is returned if it would print, call a function not compiled yet, fail, run more than `stepCount` instructions
+	// or need more than `registerCount` registers
+	static std::optional<Value> evaluate(const Program &program, std::span<const Instruction> code, std::span<const Value> registers,
+		uint64_t stepCount, size_t registerCount) {
+		std::vector<Value> registerFile(std::max(registers.size(), Instruction::maxRegisterCount));
+		std::copy(registers.begin(), registers.end(), registerFile.begin());
+		auto limits = Limits{stepCount, registerCount};
+		if (!execute<Mode::Evaluate>(program, code.data(), registerFile, nullptr, &limits))
+			return std::nullopt;
+		return registerFile[0];
+	}
+
+	static constexpr const char* getDispatchName(void) {
+#ifdef SPP_THREADED_DISPATCH
+		return "threaded";
+#else
+		return "switch";
+#endif
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <vector>
+
+// Bulk byte scanning for the lexer
+// Every kernel takes the whole buffer along with a starting offset, and returns an offset within `[offset, size]`
+namespace scan {
+	// What a byte may begin, as far as the lexer is concerned
+	enum class CharacterClass : uint8_t {
+		// Control characters, space and anything past ASCII, except linefeeds
+		Whitespace,
+		Linefeed,
+		// String literal delimiters
+		Quote,
+		// Little-endian numeric literal or operator
+		Star,
+		// Operator, or illegal character when no operator begins with it
+		Punctuation,
+		// Identifier characters, in this order
+		Digit,
+		Letter,
+		// Identifier character or operator: `_<`
+		Underscore
+	};
+
+	// Per-byte classes, so that a byte is classified by a single load instead of a chain of comparisons
+	inline constexpr auto characterClasses = [](){
+		std::array<CharacterClass, 256> res;
+		for (size_t byte = 0; byte < res.size(); byte++) {
+			if (byte == '\n')
+				res[byte] = CharacterClass::Linefeed;
+			else if (byte <= ' ' || byte >= 0x7F)
+				res[byte] = CharacterClass::Whitespace;
+			else if (byte == '"' || byte == '\'')
+				res[byte] = CharacterClass::Quote;
+			else if (byte == '*')
+				res[byte] = CharacterClass::Star;
+			else if (byte >= '0' && byte <= '9')
+				res[byte] = CharacterClass::Digit;
+			else if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z'))
+				res[byte] = CharacterClass::Letter;
+			else if (byte == '_')
+				res[byte] = CharacterClass::Underscore;
+			else
+				res[byte] = CharacterClass::Punctuation;
+		}
+		return res;
+	}();
+
+	constexpr CharacterClass getCharacterClass(uint8_t byte) {
+		return characterClasses[byte];
+	}
+
+	constexpr bool isWhitespace(uint8_t byte) {
+		return getCharacterClass(byte) == CharacterClass::Whitespace;
+	}
+
+	constexpr bool isDigit(uint8_t byte) {
+		return getCharacterClass(byte) == CharacterClass::Digit;
+	}
+
+	constexpr bool isIdentifierCharacter(uint8_t byte) {
+		return static_cast<uint8_t>(getCharacterClass(byte)) >= static_cast<uint8_t>(CharacterClass::Digit);
+	}
+
+	// The vector kernels test byte ranges instead, both must agree
+	static_assert([](){
+		for (unsigned byte = 0; byte < 256; byte++) {
+			bool isRangeWhitespace = byte != '\n' && (byte <= ' ' || byte >= 0x7F);
+			bool isRangeIdentifier = static_cast<uint8_t>((byte | 0x20) - 'a') <= 'z' - 'a' || static_cast<uint8_t>(byte - '0') <= 9 || byte == '_';
+			if (isWhitespace(byte) != isRangeWhitespace || isIdentifierCharacter(byte) != isRangeIdentifier)
+				return false;
+		}
+		return true;
+	}());
+
+	struct Kernels {
+		const char *name;
+		// First byte which is not whitespace
+		size_t (*skipWhitespace)(const char *data, size_t size, size_t offset);
+		// First byte which cannot be part of an identifier
+		size_t (*skipIdentifier)(const char *data, size_t size, size_t offset);
+		// First occurence of `byte`
+		size_t (*findByte)(const char *data, size_t size, size_t offset, char byte);
+		// First `*/`, pointing at the `*`
+		size_t (*findCommentEnd)(const char *data, size_t size, size_t offset);
+		// Occurences of `byte` before `end`
+		size_t (*countByte)(const char *data, size_t offset, size_t end, char byte);
+		// Appends the offset of every occurence of `byte`
+		void (*appendByteOffsets)(const char *data, size_t size, size_t offset, char byte, std::vector<size_t> &offsets);
+	};
+
+	namespace scalar {
+		inline size_t skipWhitespace(const char *data, size_t size, size_t offset) {
+			while (offset < size && isWhitespace(data[offset]))
+				offset++;
+			return offset;
+		}
+
+		inline size_t skipIdentifier(const char *data, size_t size, size_t offset) {
+			while (offset < size && isIdentifierCharacter(data[offset]))
+				offset++;
+			return offset;
+		}
+
+		inline size_t findByte(const char *data, size_t size, size_t offset, char byte) {
+			while (offset < size && data[offset] != byte)
+				offset++;
+			return offset;
+		}
+
+		inline size_t findCommentEnd(const char *data, size_t size, size_t offset) {
+			while (offset + 1 < size && !(data[offset] == '*' && data[offset + 1] == '/'))
+				offset++;
+			return offset + 1 < size ? offset : size;
+		}
+
+		inline size_t countByte(const char *data, size_t offset, size_t end, char byte) {
+			size_t res = 0;
+			for (; offset < end; offset++)
+				res += data[offset] == byte;
+			return res;
+		}
+
+		inline void appendByteOffsets(const char *data, size_t size, size_t offset, char byte, std::vector<size_t> &offsets) {
+			for (; offset < size; offset++)
+				if (data[offset] == byte)
+					offsets.push_back(offset);
+		}
+
+		inline constexpr Kernels kernels {
+			.name = "scalar",
+			.skipWhitespace = skipWhitespace,
+			.skipIdentifier = skipIdentifier,
+			.findByte = findByte,
+			.findCommentEnd = findCommentEnd,
+			.countByte = countByte,
+			.appendByteOffsets = appendByteOffsets
+		};
+	}
+}
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+// SSE2 is part of x86-64
+namespace scan::sse2 {
+	struct Vector {
+		static constexpr size_t size = 16;
+		static constexpr uint32_t fullMask = 0xFFFF;
+
+		__m128i value;
+
+		static Vector load(const char *data) {
+			return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(data))};
+		}
+		static Vector broadcast(char byte) {
+			return {_mm_set1_epi8(byte)};
+		}
+
+		Vector operator==(Vector other) const {
+			return {_mm_cmpeq_epi8(value, other.value)};
+		}
+		Vector operator|(Vector other) const {
+			return {_mm_or_si128(value, other.value)};
+		}
+		Vector operator&(Vector other) const {
+			return {_mm_and_si128(value, other.value)};
+		}
+		Vector operator-(Vector other) const {
+			return {_mm_sub_epi8(value, other.value)};
+		}
+		// Unsigned comparisons
+		Vector operator<=(Vector other) const {
+			return {_mm_cmpeq_epi8(_mm_min_epu8(value, other.value), value)};
+		}
+		Vector operator>=(Vector other) const {
+			return {_mm_cmpeq_epi8(_mm_max_epu8(value, other.value), value)};
+		}
+
+		// One bit per byte, set for bytes with their MSB set
+		uint32_t mask(void) const {
+			return _mm_movemask_epi8(value);
+		}
+	};
+
+	#include "scan_kernels.hpp"
+}
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace scan::avx2 {
+	struct Vector {
+		static constexpr size_t size = 32;
+		static constexpr uint32_t fullMask = 0xFFFFFFFF;
+
+		__m256i value;
+
+		static Vector load(const char *data) {
+			return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))};
+		}
+		static Vector broadcast(char byte) {
+			return {_mm256_set1_epi8(byte)};
+		}
+
+		Vector operator==(Vector other) const {
+			return {_mm256_cmpeq_epi8(value, other.value)};
+		}
+		Vector operator|(Vector other) const {
+			return {_mm256_or_si256(value, other.value)};
+		}
+		Vector operator&(Vector other) const {
+			return {_mm256_and_si256(value, other.value)};
+		}
+		Vector operator-(Vector other) const {
+			return {_mm256_sub_epi8(value, other.value)};
+		}
+		// Unsigned comparisons
+		Vector operator<=(Vector other) const {
+			return {_mm256_cmpeq_epi8(_mm256_min_epu8(value, other.value), value)};
+		}
+		Vector operator>=(Vector other) const {
+			return {_mm256_cmpeq_epi8(_mm256_max_epu8(value, other.value), value)};
+		}
+
+		// One bit per byte, set for bytes with their MSB set
+		uint32_t mask(void) const {
+			return _mm256_movemask_epi8(value);
+		}
+	};
+
+	#include "scan_kernels.hpp"
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
+
+namespace scan {
+	inline const Kernels* selectBestKernels(void) {
+#if defined(__x86_64__)
+		if (__builtin_cpu_supports("avx2"))
+			return &avx2::kernels;
+		return &sse2::kernels;
+#else
+		return &scalar::kernels;
+#endif
+	}
+
+	// Kernels used by the lexer, the widest available by default
+	inline const Kernels *activeKernels = selectBestKernels();
+
+	// Most whitespace runs, identifiers and string literals are short: the first bytes are tested inline,
+	// the kernels only take over for longer runs
+	inline constexpr size_t inlineRunLength = 8;
+
+	inline size_t skipWhitespace(std::string_view bytes, size_t offset) {
+		auto inlineEnd = std::min(offset + inlineRunLength, bytes.size());
+		for (; offset < inlineEnd; offset++)
+			if (!isWhitespace(bytes[offset]))
+				return offset;
+		return activeKernels->skipWhitespace(bytes.data(), bytes.size(), offset);
+	}
+
+	inline size_t skipIdentifier(std::string_view bytes, size_t offset) {
+		auto inlineEnd = std::min(offset + inlineRunLength, bytes.size());
+		for (; offset < inlineEnd; offset++)
+			if (!isIdentifierCharacter(bytes[offset]))
+				return offset;
+		return activeKernels->skipIdentifier(bytes.data(), bytes.size(), offset);
+	}
+
+	inline size_t findByte(std::string_view bytes, size_t offset, char byte) {
+		auto inlineEnd = std::min(offset + inlineRunLength, bytes.size());
+		for (; offset < inlineEnd; offset++)
+			if (bytes[offset] == byte)
+				return offset;
+		return activeKernels->findByte(bytes.data(), bytes.size(), offset, byte);
+	}
+}
@@ -0,0 +1,84 @@
+// Vectorized `scan` kernels, included by `scan.hpp` once per instruction set
+// The enclosing namespace provides `Vector`, tails shorter than a vector fall back to `scan::scalar`
+
+inline uint32_t whitespaceMask(Vector block) {
+	auto isControlOrSpace = block <= Vector::broadcast(' ');
+	auto isPastAscii = block >= Vector::broadcast(0x7F);
+	auto isLinefeed = block == Vector::broadcast('\n');
+	return (isControlOrSpace | isPastAscii).mask() & ~isLinefeed.mask();
+}
+
+inline uint32_t identifierMask(Vector block) {
+	auto isLetter = ((block | Vector::broadcast(0x20)) - Vector::broadcast('a')) <= Vector::broadcast('z' - 'a');
+	auto isDigit = (block - Vector::broadcast('0')) <= Vector::broadcast(9);
+	auto isUnderscore = block == Vector::broadcast('_');
+	return (isLetter | isDigit | isUnderscore).mask();
+}
+
+inline size_t skipWhitespace(const char *data, size_t size, size_t offset) {
+	for (; offset + Vector::size <= size; offset += Vector::size) {
+		auto stopMask = ~whitespaceMask(Vector::load(data + offset)) & Vector::fullMask;
+		if (stopMask != 0)
+			return offset + std::countr_zero(stopMask);
+	}
+	return scalar::skipWhitespace(data, size, offset);
+}
+
+inline size_t skipIdentifier(const char *data, size_t size, size_t offset) {
+	for (; offset + Vector::size <= size; offset += Vector::size) {
+		auto stopMask = ~identifierMask(Vector::load(data + offset)) & Vector::fullMask;
+		if (stopMask != 0)
+			return offset + std::countr_zero(stopMask);
+	}
+	return scalar::skipIdentifier(data, size, offset);
+}
+
+inline size_t findByte(const char *data, size_t size, size_t offset, char byte) {
+	auto toFind = Vector::broadcast(byte);
+	for (; offset + Vector::size <= size; offset += Vector::size) {
+		auto foundMask = (Vector::load(data + offset) == toFind).mask();
+		if (foundMask != 0)
+			return offset + std::countr_zero(foundMask);
+	}
+	return scalar::findByte(data, size, offset, byte);
+}
+
+inline size_t findCommentEnd(const char *data, size_t size, size_t offset) {
+	auto star = Vector::broadcast('*');
+	auto slash = Vector::broadcast('/');
+	// The second load is one byte ahead, so that a pair straddling two blocks is still found
+	for (; offset + Vector::size + 1 <= size; offset += Vector::size) {
+		auto foundMask = ((Vector::load(data + offset) == star) & (Vector::load(data + offset + 1) == slash)).mask();
+		if (foundMask != 0)
+			return offset + std::countr_zero(foundMask);
+	}
+	return scalar::findCommentEnd(data, size, offset);
+}
+
+inline size_t countByte(const char *data, size_t offset, size_t end, char byte) {
+	auto toCount = Vector::broadcast(byte);
+	size_t res = 0;
+	for (; offset + Vector::size <= end; offset += Vector::size)
+		res += std::popcount((Vector::load(data + offset) == toCount).mask());
+	return res + scalar::countByte(data, offset, end, byte);
+}
+
+inline void appendByteOffsets(const char *data, size_t size, size_t offset, char byte, std::vector<size_t> &offsets) {
+	auto toFind = Vector::broadcast(byte);
+	for (; offset + Vector::size <= size; offset += Vector::size) {
+		auto foundMask = (Vector::load(data + offset) == toFind).mask();
+		for (; foundMask != 0; foundMask &= foundMask - 1)
+			offsets.push_back(offset + std::countr_zero(foundMask));
+	}
+	scalar::appendByteOffsets(data, size, offset, byte, offsets);
+}
+
+inline const Kernels kernels {
+	.name = Vector::size == 32 ? "avx2" : "sse2",
+	.skipWhitespace = skipWhitespace,
+	.skipIdentifier = skipIdentifier,
+	.findByte = findByte,
+	.findCommentEnd = findCommentEnd,
+	.countByte = countByte,
+	.appendByteOffsets = appendByteOffsets
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "stack.hpp"
+
+// Runtime `segment` of the specification: `2^AddressBitCount` bytes aligned on their size, carved from a `Stack`
+// Objects are bumped within the segment, and link to each other by short references, byte offsets within it
+// A short reference finds its segment by masking its own address, hence it only resolves once stored within the segment
+// Not thread-safe
+template <size_t AddressBitCount>
+class Segment {
+	static_assert(AddressBitCount >= 4 && AddressBitCount < sizeof(uintptr_t) * 8);
+
+public:
+	static constexpr size_t size = size_t(1) << AddressBitCount;
+
+	// `unsigned(AddressBitCount)`, rounded up to a machine type
+	using Index = std::conditional_t<AddressBitCount <= 8, uint8_t,
+		std::conditional_t<AddressBitCount <= 16, uint16_t,
+		std::conditional_t<AddressBitCount <= 32, uint32_t, uint64_t>>>;
+
+	// Short reference to a `Type` within the segment, null at index 0, where the header of the segment lies
+	template <typename Type>
+	class Ref {
+		Index m_index;
+
+	public:
+		Ref(void) :
+			m_index(0) {
+		}
+		explicit Ref(Index index) :
+			m_index(index) {
+		}
+
+		Index getIndex(void) const {
+			return m_index;
+		}
+		explicit operator bool(void) const {
+			return m_index != 0;
+		}
+
+		// Only where `this` lies within the segment of the referenced value
+		Type* get(void) const {
+			auto segment = reinterpret_cast<uintptr_t>(this) & ~static_cast<uintptr_t>(size - 1);
+			return reinterpret_cast<Type*>(segment + m_index);
+		}
+		Type& operator*(void) const {
+			return *get();
+		}
+		Type* operator->(void) const {
+			return get();
+		}
+	};
+
+private:
+	// Bytes used within the segment, this header included
+	size_t m_top;
+
+	Segment(void) :
+		m_top(sizeof(Segment)) {
+	}
+
+	static size_t alignUp(size_t offset, size_t alignment) {
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+public:
+	Segment(const Segment&) = delete;
+	Segment& operator=(const Segment&) = delete;
+
+	// Null once `stack` is exhausted
+	// The base of `stack` should be aligned on `2^AddressBitCount` bytes, or padding is inserted before the segment
+	static Segment* allocate(Stack &stack) {
+		static_assert(size > sizeof(Segment));
+		auto storage = stack.allocate(size, size);
+		if (storage == nullptr)
+			return nullptr;
+		return new (storage) Segment();
+	}
+
+	// The check `create` makes, for callers which cannot tell statically that `Type` fits
+	template <typename Type>
+	bool canAllocate(void) const {
+		return alignUp(m_top, alignof(Type)) + sizeof(Type) <= size;
+	}
+
+	// `<<-`: null when the segment has no room left for `Type`
+	// Destructors are never run, the segment is released as a whole along with its stack
+	template <typename Type, typename ...Args>
+	Ref<Type> create(Args &&...args) {
+		static_assert(std::is_trivially_destructible_v<Type>, "Segment never runs destructors");
+		static_assert(alignof(Type) <= size);
+		auto offset = alignUp(m_top, alignof(Type));
+		if (offset + sizeof(Type) > size) [[unlikely]]
+			return Ref<Type>();
+		m_top = offset + sizeof(Type);
+		new (reinterpret_cast<char*>(this) + offset) Type(std::forward<Args>(args)...);
+		return Ref<Type>(static_cast<Index>(offset));
+	}
+
+	// For references held outside of the segment
+	template <typename Type>
+	Type* get(Ref<Type> ref) {
+		return reinterpret_cast<Type*>(reinterpret_cast<char*>(this) + ref.getIndex());
+	}
+
+	size_t getUsedByteCount(void) const {
+		return m_top;
+	}
+};
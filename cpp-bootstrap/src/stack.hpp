@@ -0,0 +1,315 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <array>
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Runtime `stack` of the specification: `2^addressBitCount` bytes of address space reserved at once, and never moved
+// Pages are committed as the top reaches them, doubling the committed size each time, and a guard page follows the range
+// Allocation bumps the top, and is released by dropping the `Split` it was allocated in
+// Every stack is registered under an id while it lives, which long references resolve through
+// Not thread-safe: stacks are created and destroyed by the main thread only, as in the specification
+class Stack {
+public:
+	// Bits of a long reference holding the offset within the stack, the high ones hold the id of the stack
+	static constexpr size_t offsetBitCount = 48;
+	// Stacks alive at once, id 0 included although no stack ever gets it
+	static constexpr size_t maxStackCount = size_t(1) << (64 - offsetBitCount);
+
+private:
+	// By id, the base of each live stack minus its id shifted in place, so that adding a whole long reference gives the address
+	static inline std::array<uintptr_t, maxStackCount> registry {};
+	// Ids of destroyed stacks, reused before new ones
+	static inline std::vector<uint32_t> freeIds;
+	static inline uint32_t nextId = 1;
+
+	// Reserved but not committed: any access faults
+	char *m_base;
+	char *m_top;
+	char *m_committedEnd;
+	// The guard page is past it
+	char *m_reservedEnd;
+	// Of the whole mapping, aligned base and guard page included
+	void *m_mapping;
+	size_t m_mappingSize;
+
+	size_t m_commitCount;
+	// 0 without a reservation
+	uint32_t m_id;
+
+	static uintptr_t alignUp(uintptr_t address, size_t alignment) {
+		return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+	[[noreturn, gnu::cold]] static void throwSystemError(const char *operation) {
+		throw std::runtime_error(std::string("Stack: ") + operation + " failed: " + std::strerror(errno));
+	}
+
+	void release(void) {
+		if (m_mapping != nullptr)
+			::munmap(m_mapping, m_mappingSize);
+		if (m_id != 0) {
+			registry[m_id] = 0;
+			freeIds.push_back(m_id);
+		}
+	}
+
+	// Commits enough pages past the top for the allocation, null once the reserved range is exhausted
+	[[gnu::noinline]] void* allocateCommitting(size_t size, size_t alignment) {
+		auto res = alignUp(reinterpret_cast<uintptr_t>(m_top), alignment);
+		auto reservedEnd = reinterpret_cast<uintptr_t>(m_reservedEnd);
+		if (res > reservedEnd || size > reservedEnd - res)
+			return nullptr;
+		auto committedEnd = reinterpret_cast<uintptr_t>(m_committedEnd);
+		auto committedSize = committedEnd - reinterpret_cast<uintptr_t>(m_base);
+		auto requiredEnd = alignUp(res + size, getPageSize());
+		auto end = std::min(std::max(requiredEnd, committedEnd + std::max(committedSize, getPageSize())), reservedEnd);
+		if (::mprotect(m_committedEnd, end - committedEnd, PROT_READ | PROT_WRITE) != 0)
+			return nullptr;
+		m_commitCount++;
+		m_committedEnd = reinterpret_cast<char*>(end);
+		m_top = reinterpret_cast<char*>(res + size);
+		return reinterpret_cast<void*>(res);
+	}
+
+public:
+	// Long reference to a `Type` on any stack, the size of a `device_unsigned`, null at id 0
+	// Resolves with a load from the registry and an add, without checking that the stack is still alive:
+	// the compiler guarantees that the stack outlives its references
+	template <typename Type>
+	class Ref {
+		uint64_t m_bits;
+
+	public:
+		Ref(void) :
+			m_bits(0) {
+		}
+		explicit Ref(uint64_t bits) :
+			m_bits(bits) {
+		}
+
+		uint64_t getBits(void) const {
+			return m_bits;
+		}
+		uint32_t getStackId(void) const {
+			return static_cast<uint32_t>(m_bits >> offsetBitCount);
+		}
+		explicit operator bool(void) const {
+			return m_bits != 0;
+		}
+
+		Type* get(void) const {
+			return reinterpret_cast<Type*>(registry[m_bits >> offsetBitCount] + m_bits);
+		}
+		Type& operator*(void) const {
+			return *get();
+		}
+		Type* operator->(void) const {
+			return get();
+		}
+	};
+
+	// Sub-stack owning the top of its stack until destroyed, which pops everything allocated since its creation
+	// Splits are destroyed in the reverse order of their creation, as scopes end
+	class Split {
+		Stack *m_stack;
+		char *m_base;
+
+	public:
+		Split(Stack &stack) :
+			m_stack(&stack),
+			m_base(stack.m_top) {
+		}
+		Split(const Split&) = delete;
+		Split& operator=(const Split&) = delete;
+
+		~Split(void) {
+			m_stack->m_top = m_base;
+		}
+
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+			return m_stack->allocate(size, alignment);
+		}
+		template <typename Type, typename ...Args>
+		Type* create(Args &&...args) {
+			return m_stack->create<Type>(std::forward<Args>(args)...);
+		}
+
+		size_t getUsedByteCount(void) const {
+			return m_stack->m_top - m_base;
+		}
+	};
+
+	static size_t getPageSize(void) {
+		static const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+		return pageSize;
+	}
+
+	// Reserves nothing, every allocation fails
+	Stack(void) :
+		m_base(nullptr),
+		m_top(nullptr),
+		m_committedEnd(nullptr),
+		m_reservedEnd(nullptr),
+		m_mapping(nullptr),
+		m_mappingSize(0),
+		m_commitCount(0),
+		m_id(0) {
+	}
+
+	// The base is aligned on `2^alignmentBitCount` bytes, at least a page
+	Stack(size_t addressBitCount, size_t alignmentBitCount = 0) :
+		Stack() {
+		// Long references address the whole range
+		if (addressBitCount > offsetBitCount || alignmentBitCount > offsetBitCount)
+			throw std::runtime_error("Stack: 2^" + std::to_string(std::max(addressBitCount, alignmentBitCount)) + " bytes cannot be addressed");
+		if (freeIds.empty() && nextId == maxStackCount)
+			throw std::runtime_error("Stack: more than " + std::to_string(maxStackCount - 1) + " stacks at once");
+		auto pageSize = getPageSize();
+		auto reservedSize = alignUp(uintptr_t(1) << addressBitCount, pageSize);
+		auto alignment = std::max<size_t>(size_t(1) << alignmentBitCount, pageSize);
+		// The excess is only needed to find an aligned base within the mapping, it is unmapped right away
+		auto excessSize = alignment - pageSize;
+		m_mappingSize = reservedSize + pageSize + excessSize;
+		// No swap is accounted for the range, pages are only backed once written
+		auto mapping = ::mmap(nullptr, m_mappingSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mapping == MAP_FAILED)
+			throwSystemError("mmap");
+		auto begin = reinterpret_cast<uintptr_t>(mapping);
+		auto base = alignUp(begin, alignment);
+		if (base > begin)
+			::munmap(mapping, base - begin);
+		auto end = begin + m_mappingSize;
+		auto guardEnd = base + reservedSize + pageSize;
+		if (end > guardEnd)
+			::munmap(reinterpret_cast<void*>(guardEnd), end - guardEnd);
+		m_mapping = reinterpret_cast<void*>(base);
+		m_mappingSize = guardEnd - base;
+		m_base = reinterpret_cast<char*>(base);
+		m_top = m_base;
+		m_committedEnd = m_base;
+		m_reservedEnd = m_base + reservedSize;
+		if (freeIds.empty())
+			m_id = nextId++;
+		else {
+			m_id = freeIds.back();
+			freeIds.pop_back();
+		}
+		registry[m_id] = base - (uintptr_t(m_id) << offsetBitCount);
+	}
+
+	Stack(Stack &&other) noexcept :
+		m_base(std::exchange(other.m_base, nullptr)),
+		m_top(std::exchange(other.m_top, nullptr)),
+		m_committedEnd(std::exchange(other.m_committedEnd, nullptr)),
+		m_reservedEnd(std::exchange(other.m_reservedEnd, nullptr)),
+		m_mapping(std::exchange(other.m_mapping, nullptr)),
+		m_mappingSize(std::exchange(other.m_mappingSize, 0)),
+		m_commitCount(std::exchange(other.m_commitCount, 0)),
+		m_id(std::exchange(other.m_id, 0)) {
+	}
+	Stack& operator=(Stack &&other) noexcept {
+		if (this != &other) {
+			release();
+			m_base = std::exchange(other.m_base, nullptr);
+			m_top = std::exchange(other.m_top, nullptr);
+			m_committedEnd = std::exchange(other.m_committedEnd, nullptr);
+			m_reservedEnd = std::exchange(other.m_reservedEnd, nullptr);
+			m_mapping = std::exchange(other.m_mapping, nullptr);
+			m_mappingSize = std::exchange(other.m_mappingSize, 0);
+			m_commitCount = std::exchange(other.m_commitCount, 0);
+			m_id = std::exchange(other.m_id, 0);
+		}
+		return *this;
+	}
+
+	~Stack(void) {
+		release();
+	}
+
+	// Null once the reserved range is exhausted, `alignment` must be a power of two
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		auto res = alignUp(reinterpret_cast<uintptr_t>(m_top), alignment);
+		auto committedEnd = reinterpret_cast<uintptr_t>(m_committedEnd);
+		if (res <= committedEnd && size <= committedEnd - res) [[likely]] {
+			m_top = reinterpret_cast<char*>(res + size);
+			return reinterpret_cast<void*>(res);
+		}
+		return allocateCommitting(size, alignment);
+	}
+
+	// Destructors are never run, popping only moves the top back
+	template <typename Type, typename ...Args>
+	Type* create(Args &&...args) {
+		static_assert(std::is_trivially_destructible_v<Type>, "Stack never runs destructors");
+		auto storage = allocate(sizeof(Type), alignof(Type));
+		if (storage == nullptr)
+			throw std::bad_alloc();
+		return new (storage) Type(std::forward<Args>(args)...);
+	}
+
+	Split split(void) {
+		return Split(*this);
+	}
+
+	// `value` must lie on this stack
+	template <typename Type>
+	Ref<Type> ref(const Type *value) const {
+		auto offset = static_cast<uint64_t>(reinterpret_cast<const char*>(value) - m_base);
+		return Ref<Type>((uint64_t(m_id) << offsetBitCount) | offset);
+	}
+
+	// Returns the physical memory of the committed pages past the top, which are committed again once reached
+	void trim(void) {
+		auto end = alignUp(reinterpret_cast<uintptr_t>(m_top), getPageSize());
+		auto committedEnd = reinterpret_cast<uintptr_t>(m_committedEnd);
+		if (end >= committedEnd)
+			return;
+		auto trimmed = reinterpret_cast<void*>(end);
+		if (::madvise(trimmed, committedEnd - end, MADV_DONTNEED) != 0)
+			throwSystemError("madvise");
+		if (::mprotect(trimmed, committedEnd - end, PROT_NONE) != 0)
+			throwSystemError("mprotect");
+		m_committedEnd = reinterpret_cast<char*>(end);
+	}
+
+	// Splits are the way to pop, these are for callers keeping their own marks, such as the frames of the `Runner`
+	char* getTop(void) const {
+		return m_top;
+	}
+	void setTop(char *top) {
+		m_top = top;
+	}
+
+	const char* getBase(void) const {
+		return m_base;
+	}
+	size_t getUsedByteCount(void) const {
+		return m_top - m_base;
+	}
+	size_t getCommittedByteCount(void) const {
+		return m_committedEnd - m_base;
+	}
+	size_t getReservedByteCount(void) const {
+		return m_reservedEnd - m_base;
+	}
+	// `mprotect` calls made to commit pages
+	size_t getCommitCount(void) const {
+		return m_commitCount;
+	}
+	uint32_t getId(void) const {
+		return m_id;
+	}
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include "arena.hpp"
+
+// Dense ID of an interned identifier spelling, two identifiers are the same name if and only if their symbols are equal
+using Symbol = uint32_t;
+
+namespace Symbols {
+	static constexpr Symbol forKeyword = 0;
+	static constexpr Symbol inKeyword = 1;
+	static constexpr Symbol ifKeyword = 2;
+	static constexpr Symbol thenKeyword = 3;
+	static constexpr Symbol elseKeyword = 4;
+	static constexpr Symbol whileKeyword = 5;
+	static constexpr Symbol returnKeyword = 6;
+	static constexpr Symbol andKeyword = 7;
+	static constexpr Symbol orKeyword = 8;
+	static constexpr Symbol functionKeyword = 9;
+	static constexpr Symbol sequenceKeyword = 10;
+	static constexpr Symbol structKeyword = 11;
+	static constexpr Symbol classKeyword = 12;
+	static constexpr Symbol thisKeyword = 13;
+	static constexpr Symbol importKeyword = 14;
+	static constexpr Symbol exportKeyword = 15;
+	static constexpr Symbol entryPointKeyword = 16;
+	static constexpr Symbol notKeyword = 17;
+	static constexpr Symbol xorKeyword = 18;
+
+	// Interned first by every `SymbolTable`, the symbol of each keyword is its index
+	static constexpr std::array<std::string_view, 19> keywords = {
+		"for", "in", "if", "then", "else", "while", "return", "and", "or",
+		"function", "sequence", "struct", "class", "this", "import", "export", "entry_point", "not", "xor"
+	};
+	static_assert(keywords[forKeyword] == "for" && keywords[entryPointKeyword] == "entry_point" && keywords[xorKeyword] == "xor");
+}
+
+// Interns identifier spellings into symbols
+// Open addressing with linear probing, the table is kept at most half full
+// Everything lives in an arena: spellings are copied there once and handed out as `std::string_view`
+class SymbolTable {
+	static constexpr Symbol emptySlot = 0xFFFFFFFF;
+	static constexpr size_t initialSlotCount = 1024;
+
+	struct Slot {
+		// Kept along the symbol, to skip most spelling compares and to rehash without touching spellings
+		uint32_t hash;
+		Symbol symbol;
+	};
+
+	Arena *m_arena;
+	std::pmr::vector<Slot> m_slots;
+	std::pmr::vector<std::string_view> m_spellings;
+
+	static uint64_t load32(const char *data) {
+		uint32_t res;
+		std::memcpy(&res, data, sizeof(res));
+		return res;
+	}
+	static uint64_t load64(const char *data) {
+		uint64_t res;
+		std::memcpy(&res, data, sizeof(res));
+		return res;
+	}
+
+	static uint64_t mix(uint64_t a, uint64_t b) {
+		auto product = static_cast<unsigned __int128>(a) * b;
+		return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+	}
+
+	// Identifiers are short: up to 16 bytes are read with a few overlapping fixed-size loads, without looping
+	static uint32_t hash(std::string_view spelling) {
+		static constexpr uint64_t keys[] = {0xA0761D6478BD642F, 0xE7037ED1A0B428DB, 0x8EBC6AF09C88C6E3};
+		auto data = spelling.data();
+		auto size = spelling.size();
+		uint64_t seed = keys[0];
+		uint64_t a;
+		uint64_t b;
+		if (size <= 16) {
+			if (size >= 4) {
+				auto shift = (size >> 3) << 2;
+				a = load32(data) << 32 | load32(data + shift);
+				b = load32(data + size - 4) << 32 | load32(data + size - 4 - shift);
+			} else if (size > 0) {
+				a = static_cast<uint64_t>(static_cast<uint8_t>(data[0])) << 16 |
+					static_cast<uint64_t>(static_cast<uint8_t>(data[size >> 1])) << 8 |
+					static_cast<uint8_t>(data[size - 1]);
+				b = 0;
+			} else {
+				a = 0;
+				b = 0;
+			}
+		} else {
+			size_t offset = 0;
+			for (; size - offset > 16; offset += 16)
+				seed = mix(load64(data + offset) ^ keys[1], load64(data + offset + 8) ^ seed);
+			a = load64(data + size - 16);
+			b = load64(data + size - 8);
+		}
+		return static_cast<uint32_t>(mix(keys[1] ^ size, mix(a ^ keys[1], b ^ seed) ^ keys[2]));
+	}
+
+	// Index of the slot holding `spelling`, or of the empty slot where it would be inserted
+	size_t findSlot(std::string_view spelling, uint32_t spellingHash) const {
+		auto mask = m_slots.size() - 1;
+		for (size_t index = spellingHash & mask;; index = (index + 1) & mask) {
+			auto &slot = m_slots[index];
+			if (slot.symbol == emptySlot)
+				return index;
+			if (slot.hash == spellingHash && m_spellings[slot.symbol] == spelling)
+				return index;
+		}
+	}
+
+	void grow(void) {
+		// Old slots stay in the arena until it is reset, at most as large as the table itself
+		auto oldSlots = std::move(m_slots);
+		m_slots = std::pmr::vector<Slot>(oldSlots.size() * 2, Slot{0, emptySlot}, m_arena->getResource());
+		auto mask = m_slots.size() - 1;
+		for (auto &oldSlot : oldSlots) {
+			if (oldSlot.symbol == emptySlot)
+				continue;
+			auto index = oldSlot.hash & mask;
+			while (m_slots[index].symbol != emptySlot)
+				index = (index + 1) & mask;
+			m_slots[index] = oldSlot;
+		}
+	}
+
+public:
+	// The table must not outlive `arena` nor its next reset
+	SymbolTable(Arena &arena) :
+		m_arena(&arena),
+		m_slots(initialSlotCount, Slot{0, emptySlot}, arena.getResource()),
+		m_spellings(arena.getResource()) {
+		for (auto keyword : Symbols::keywords)
+			intern(keyword);
+	}
+
+	SymbolTable(const SymbolTable&) = delete;
+	SymbolTable& operator=(const SymbolTable&) = delete;
+
+	Symbol intern(std::string_view spelling) {
+		auto spellingHash = hash(spelling);
+		auto slotIndex = findSlot(spelling, spellingHash);
+		if (m_slots[slotIndex].symbol != emptySlot)
+			return m_slots[slotIndex].symbol;
+
+		if ((m_spellings.size() + 1) * 2 > m_slots.size()) {
+			grow();
+			slotIndex = findSlot(spelling, spellingHash);
+		}
+		auto res = static_cast<Symbol>(m_spellings.size());
+		m_spellings.emplace_back(m_arena->copyString(spelling));
+		m_slots[slotIndex] = Slot{spellingHash, res};
+		return res;
+	}
+
+	// Does not intern, `std::nullopt` if the spelling was never seen
+	std::optional<Symbol> find(std::string_view spelling) const {
+		auto symbol = m_slots[findSlot(spelling, hash(spelling))].symbol;
+		if (symbol == emptySlot)
+			return std::nullopt;
+		return symbol;
+	}
+
+	std::string_view getSpelling(Symbol symbol) const {
+		return m_spellings[symbol];
+	}
+
+	size_t size(void) const {
+		return m_spellings.size();
+	}
+};
@@ -1,35 +1,142 @@
 #pragma once
 
 #include <filesystem>
-#include <fstream>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <type_traits>
 #include <tuple>
 #include <optional>
 #include <stdexcept>
+#include <exception>
 #include <algorithm>
+#include <cstring>
+#include <cerrno>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "scan.hpp"
+#include "symbol.hpp"
+#include "number.hpp"
+
+// Source file contents, loaded once and then only borrowed by the lexer
+// Regular files are mapped read-only, anything else (pipes, stdin, ...) is read into a single buffer
 class File {
 	std::filesystem::path m_filePath;
-	std::string m_bytes;
+	// Set when the file is mapped
+	void *m_mapping;
+	size_t m_mappingSize;
+	// Backing storage when the file could not be mapped
+	std::string m_buffer;
+	std::string_view m_bytes;
+	// Offset of every linefeed, built on first use
+	mutable std::optional<std::vector<size_t>> m_linefeedOffsets;
+
+	const std::vector<size_t>& getLinefeedOffsets(void) const {
+		if (!m_linefeedOffsets.has_value()) {
+			auto &kernels = *scan::activeKernels;
+			m_linefeedOffsets.emplace();
+			m_linefeedOffsets->reserve(kernels.countByte(m_bytes.data(), 0, m_bytes.size(), '\n'));
+			kernels.appendByteOffsets(m_bytes.data(), m_bytes.size(), 0, '\n', *m_linefeedOffsets);
+		}
+		return *m_linefeedOffsets;
+	}
 
-	static std::string readFileBytes(const std::filesystem::path &filePath) {
-		std::ifstream inputFile(filePath, std::ios::in | std::ios::binary);
-		std::stringstream res;
-		res << inputFile.rdbuf();
-		return res.str();
+	[[noreturn]] void throwSystemError(const char *operation) const {
+		std::stringstream ss;
+		ss << "File: " << operation << " failed on " << m_filePath << ": " << std::strerror(errno);
+		throw std::runtime_error(ss.str());
+	}
+
+	// `sizeHint` is the expected byte count, zero if unknown
+	void readAll(int fd, size_t sizeHint) {
+		static constexpr size_t minReadSize = 1 << 16;
+
+		m_buffer.resize(std::max(sizeHint, minReadSize));
+		size_t readSize = 0;
+		while (true) {
+			if (readSize == m_buffer.size())
+				m_buffer.resize(m_buffer.size() * 2);
+			auto result = ::read(fd, m_buffer.data() + readSize, m_buffer.size() - readSize);
+			if (result < 0) {
+				if (errno == EINTR)
+					continue;
+				throwSystemError("read");
+			}
+			if (result == 0)
+				break;
+			readSize += result;
+		}
+		m_buffer.resize(readSize);
+		m_bytes = m_buffer;
+	}
+
+	void load(int fd) {
+		struct stat fileStat;
+		if (::fstat(fd, &fileStat) != 0)
+			throwSystemError("fstat");
+
+		size_t fileSize = fileStat.st_size;
+		if (S_ISREG(fileStat.st_mode) && fileSize > 0) {
+			auto mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping != MAP_FAILED) {
+				// Lexing walks through the file front to back
+				::madvise(mapping, fileSize, MADV_SEQUENTIAL);
+				m_mapping = mapping;
+				m_mappingSize = fileSize;
+				m_bytes = std::string_view(static_cast<const char*>(mapping), fileSize);
+				return;
+			}
+			readAll(fd, fileSize);
+		} else
+			readAll(fd, 0);
 	}
 
 public:
 	File(const std::filesystem::path &filePath) :
 		m_filePath(filePath),
-		m_bytes(readFileBytes(filePath)) {
+		m_mapping(nullptr),
+		m_mappingSize(0) {
+		auto fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			throwSystemError("open");
+		try {
+			load(fd);
+		} catch (...) {
+			::close(fd);
+			throw;
+		}
+		// The mapping stays valid once the descriptor is closed
+		::close(fd);
+	}
+	// Tokens and locations refer to the file by address
+	File(const File&) = delete;
+	File& operator=(const File&) = delete;
+
+	~File(void) {
+		if (m_mapping != nullptr)
+			::munmap(m_mapping, m_mappingSize);
 	}
 
 	const std::filesystem::path& getPath(void) const {
 		return m_filePath;
 	}
 
+	// Whole contents, valid for the lifetime of `this`
+	std::string_view getBytes(void) const {
+		return m_bytes;
+	}
+
 	bool isBeforeEnd(size_t offset) const {
 		return offset < m_bytes.size();
 	}
@@ -42,88 +149,99 @@ public:
 	size_t getByteCount(void) const {
 		return m_bytes.size();
 	}
+
+	// Starts with one
+	size_t getLineAt(size_t offset) const {
+		auto &linefeedOffsets = getLinefeedOffsets();
+		return std::lower_bound(linefeedOffsets.begin(), linefeedOffsets.end(), offset) - linefeedOffsets.begin() + 1;
+	}
+
+	// Starts with one, a tab is 8 columns
+	size_t getColumnAt(size_t offset) const {
+		auto line = getLineAt(offset);
+		auto lineBeginOffset = line == 1 ? 0 : getLinefeedOffsets()[line - 2] + 1;
+		auto tabCount = scan::activeKernels->countByte(m_bytes.data(), lineBeginOffset, offset, '\t');
+		return 1 + offset - lineBeginOffset + 7 * tabCount;
+	}
 };
 
 // Walk through the file, giving human readable current location at any time
+// Only the offset is tracked, line and column are looked up from the file when asked for
 class FileLocation {
-	const File &m_pointedFile;
+	const File *m_pointedFile;
 
 	// Byte offset, with zero the first byte of the file
 	size_t m_offset;
 
-	// Starts with one
-	size_t m_line;
-	// Starts with one, a tab is 8 columns
-	size_t m_column;
-
 public:
-	FileLocation(const File &argPointedFile) :
-		m_pointedFile(argPointedFile),
-		m_offset(0),
-		m_line(1),
-		m_column(1) {
+	FileLocation(const File &argPointedFile, size_t offset = 0) :
+		m_pointedFile(&argPointedFile),
+		m_offset(offset) {
 	}
 
 	const File &getPointedFile(void) const {
-		return m_pointedFile;
+		return *m_pointedFile;
 	}
 	// Location getters
 	size_t getOffset(void) const {
 		return m_offset;
 	}
+	// Starts with one
 	size_t getLine(void) const {
-		return m_line;
+		return m_pointedFile->getLineAt(m_offset);
 	}
+	// Starts with one, a tab is 8 columns
 	size_t getColumn(void) const {
-		return m_column;
+		return m_pointedFile->getColumnAt(m_offset);
 	}
 
 	// Modifiers
 	// Must not be called if `!isBeforeEnd()`
 	void moveForward(void) {
-		auto nextCharacter = m_pointedFile.read(m_offset);
 		m_offset++;
-
-		if (nextCharacter == '\n') {
-			m_line++;
-			m_column = 1;
-		} else if (nextCharacter == '\t') {
-			m_column += 8;
-		} else {
-			m_column++;
-		}
 	}
 
 	bool isBeforeEnd(void) const {
-		return m_pointedFile.isBeforeEnd(m_offset);
+		return m_pointedFile->isBeforeEnd(m_offset);
 	}
 
 	// Must have `isBeforeEnd()` return `true`
 	char getCurrentCharacter(void) const {
-		return m_pointedFile.read(m_offset);
+		return m_pointedFile->read(m_offset);
 	}
 
 	// Includes a unit for current character if before end
 	size_t readableCharacterCount(void) const {
-		return m_pointedFile.getByteCount() - m_offset;
+		return m_pointedFile->getByteCount() - m_offset;
+	}
+
+	// From current character to end of file
+	// Not `substr`: the offset never passes the end, and its range check would be an out-of-line call per operator
+	std::string_view getReadableBytes(void) const {
+		auto bytes = m_pointedFile->getBytes();
+		return std::string_view(bytes.data() + m_offset, bytes.size() - m_offset);
 	}
 
 	// Must have `offset < readableCharacterCount()`
 	char getNextCharacter(size_t offset) const {
-		return m_pointedFile.read(m_offset + offset);
+		return m_pointedFile->read(m_offset + offset);
+	}
+
+	// Must have `offset` between current offset and end of file
+	void moveForwardTo(size_t offset) {
+		m_offset = offset;
 	}
 
 	// Must have `characterCount <= readableCharacterCount()`
 	void moveForwardMultiple(size_t characterCount) {
-		for (size_t i = 0; i < characterCount; i++)
-			moveForward();
+		m_offset += characterCount;
 	}
 };
 
-enum class TokenClass {
+enum class TokenClass : uint8_t {
 	Layout,
 	Operator,
-	Digits,
+	NumberLiteral,
 	Identifier,
 	StringLiteral
 };
@@ -131,55 +249,67 @@ enum class TokenClass {
 // Token without a location in a file
 class TokenStub {
 	TokenClass m_class;
-	std::string m_underlyingStr;
+	std::string_view m_underlyingStr;
 
 public:
-	TokenStub(TokenClass tokenClass, const std::string &str) :
+	constexpr TokenStub(TokenClass tokenClass, std::string_view str) :
 		m_class(tokenClass),
 		m_underlyingStr(str) {
 	}
 
-	TokenClass getClass(void) const {
+	constexpr TokenClass getClass(void) const {
 		return m_class;
 	}
 
-	const std::string& getString(void) const {
+	constexpr std::string_view getString(void) const {
 		return m_underlyingStr;
 	}
 };
 
+// Span of bytes within a file, the text is borrowed from the file which must outlive the token
+// Offsets are 32-bit, `TokenParser` rejects larger files
 class Token {
-	FileLocation m_fileLocation;
+	const File *m_file;
+	uint32_t m_offset;
+	uint32_t m_sizeInFile;
 	TokenClass m_class;
-	std::string m_underlyingStr;
-	size_t m_sizeInFile;
+	// Symbol of identifiers, `NumberTable` reference of numeric literals, index within `Tokens::allOperators` of operators,
+	// zero for other classes
+	uint32_t m_payload;
 
-	static inline std::string linefeedString = "\n";
-	static inline std::string escapedLinefeedString = "[LINEFEED]";
-
-	size_t computeSizeInFile(void) const {
-		auto res = m_underlyingStr.size();
-		if (m_class == TokenClass::StringLiteral) {
-			// Adding delimiters
-			res += 2;
-		}
-		res = std::min(res, m_fileLocation.readableCharacterCount());
-		return res;
-	}
+	static constexpr std::string_view escapedLinefeedString = "[LINEFEED]";
 
 public:
-	Token(const FileLocation &fileLocation, TokenClass tokenClass, const std::string &str) :
-		m_fileLocation(fileLocation),
+	// `sizeInFile` includes string literal delimiters
+	Token(const FileLocation &fileLocation, TokenClass tokenClass, size_t sizeInFile) :
+		m_file(&fileLocation.getPointedFile()),
+		m_offset(fileLocation.getOffset()),
+		m_sizeInFile(std::min(sizeInFile, fileLocation.readableCharacterCount())),
+		m_class(tokenClass),
+		m_payload(0) {
+	}
+	Token(const File &file, TokenClass tokenClass, uint32_t offset, uint32_t sizeInFile, uint32_t payload = 0) :
+		m_file(&file),
+		m_offset(offset),
+		m_sizeInFile(sizeInFile),
 		m_class(tokenClass),
-		m_underlyingStr(str),
-		m_sizeInFile(computeSizeInFile()) {
+		m_payload(payload) {
 	}
 	Token(const FileLocation &fileLocation, const TokenStub &stub) :
-		Token(fileLocation, stub.getClass(), stub.getString()) {
+		Token(fileLocation, stub.getClass(), stub.getString().size()) {
+	}
+
+	const File& getFile(void) const {
+		return *m_file;
+	}
+
+	size_t getOffset(void) const {
+		return m_offset;
 	}
 
-	const FileLocation& getFileLocation(void) const {
-		return m_fileLocation;
+	// Line and column are computed on demand, keep it for diagnostics
+	FileLocation getFileLocation(void) const {
+		return FileLocation(*m_file, m_offset);
 	}
 
 	TokenClass getClass(void) const {
@@ -190,61 +320,185 @@ public:
 		return m_sizeInFile;
 	}
 
-	const std::string& getString(void) const {
-		if (m_underlyingStr == linefeedString)
+	uint32_t getPayload(void) const {
+		return m_payload;
+	}
+	void setPayload(uint32_t payload) {
+		m_payload = payload;
+	}
+
+	// Only meaningful for identifiers
+	Symbol getSymbol(void) const {
+		return m_payload;
+	}
+	// Only meaningful for numeric literals
+	uint32_t getNumberReference(void) const {
+		return m_payload;
+	}
+	// Only meaningful for operators, index within `Tokens::allOperators`
+	uint32_t getOperatorIndex(void) const {
+		return m_payload;
+	}
+
+	// String literals are returned without their delimiters
+	std::string_view getString(void) const {
+		if (m_class == TokenClass::Layout)
 			return escapedLinefeedString;
-		else
-			return m_underlyingStr;
+		auto res = m_file->getBytes().substr(m_offset, m_sizeInFile);
+		if (m_class == TokenClass::StringLiteral) {
+			res.remove_prefix(std::min<size_t>(res.size(), 1));
+			res.remove_suffix(std::min<size_t>(res.size(), 1));
+		}
+		return res;
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<Token>);
+
+// Tokens of a single file, stored as parallel arrays
+// Passes dispatching on token classes only touch one byte per token
+class TokenStream {
+	const File *m_file;
+	std::vector<TokenClass> m_classes;
+	std::vector<uint32_t> m_offsets;
+	std::vector<uint32_t> m_sizesInFile;
+	std::vector<uint32_t> m_payloads;
+
+public:
+	class Iterator {
+		const TokenStream *m_stream;
+		size_t m_index;
+
+	public:
+		Iterator(const TokenStream &stream, size_t index) :
+			m_stream(&stream),
+			m_index(index) {
+		}
+
+		Token operator*(void) const {
+			return (*m_stream)[m_index];
+		}
+		Iterator& operator++(void) {
+			m_index++;
+			return *this;
+		}
+		bool operator==(const Iterator &other) const {
+			return m_index == other.m_index;
+		}
+	};
+
+	TokenStream(const File &file) :
+		m_file(&file) {
+	}
+
+	const File& getFile(void) const {
+		return *m_file;
+	}
+
+	void push(const Token &token) {
+		m_classes.push_back(token.getClass());
+		m_offsets.push_back(token.getOffset());
+		m_sizesInFile.push_back(token.getSizeInFile());
+		m_payloads.push_back(token.getPayload());
+	}
+
+	size_t size(void) const {
+		return m_classes.size();
+	}
+
+	TokenClass getClass(size_t index) const {
+		return m_classes[index];
+	}
+	uint32_t getOffset(size_t index) const {
+		return m_offsets[index];
+	}
+	uint32_t getSizeInFile(size_t index) const {
+		return m_sizesInFile[index];
+	}
+	uint32_t getPayload(size_t index) const {
+		return m_payloads[index];
+	}
+	void setPayload(size_t index, uint32_t payload) {
+		m_payloads[index] = payload;
+	}
+	const std::vector<TokenClass>& getClasses(void) const {
+		return m_classes;
+	}
+
+	void reserve(size_t tokenCount) {
+		m_classes.reserve(tokenCount);
+		m_offsets.reserve(tokenCount);
+		m_sizesInFile.reserve(tokenCount);
+		m_payloads.reserve(tokenCount);
+	}
+
+	// Appends tokens of `other` from `firstIndex`, both streams must be of the same file
+	void append(const TokenStream &other, size_t firstIndex) {
+		m_classes.insert(m_classes.end(), other.m_classes.begin() + firstIndex, other.m_classes.end());
+		m_offsets.insert(m_offsets.end(), other.m_offsets.begin() + firstIndex, other.m_offsets.end());
+		m_sizesInFile.insert(m_sizesInFile.end(), other.m_sizesInFile.begin() + firstIndex, other.m_sizesInFile.end());
+		m_payloads.insert(m_payloads.end(), other.m_payloads.begin() + firstIndex, other.m_payloads.end());
+	}
+
+	Token operator[](size_t index) const {
+		return Token(*m_file, m_classes[index], m_offsets[index], m_sizesInFile[index], m_payloads[index]);
+	}
+
+	Iterator begin(void) const {
+		return Iterator(*this, 0);
+	}
+	Iterator end(void) const {
+		return Iterator(*this, size());
 	}
 };
 
 namespace Tokens {
 	// Layout
-	static inline auto linefeed = TokenStub(TokenClass::Layout, "\n");
+	static constexpr auto linefeed = TokenStub(TokenClass::Layout, "\n");
 
 	// Scope operators
-	static inline auto dot = TokenStub(TokenClass::Operator, ".");
-	static inline auto leftParenthesis = TokenStub(TokenClass::Operator, "(");
-	static inline auto rightParenthesis = TokenStub(TokenClass::Operator, ")");
-	static inline auto leftArraySubscript = TokenStub(TokenClass::Operator, "[");
-	static inline auto rightArraySubscript = TokenStub(TokenClass::Operator, "]");
-	static inline auto leftBracket = TokenStub(TokenClass::Operator, "{");
-	static inline auto rightBracket = TokenStub(TokenClass::Operator, "}");
-	static inline auto comma = TokenStub(TokenClass::Operator, ",");
-	static inline auto colon = TokenStub(TokenClass::Operator, ":");
-	static inline auto semicolon = TokenStub(TokenClass::Operator, ";");
-	static inline auto variableArgumentCountType = TokenStub(TokenClass::Operator, "...");
-	static inline auto assign = TokenStub(TokenClass::Operator, "<-");
-	static inline auto backInsert = TokenStub(TokenClass::Operator, "<<-");
+	static constexpr auto dot = TokenStub(TokenClass::Operator, ".");
+	static constexpr auto leftParenthesis = TokenStub(TokenClass::Operator, "(");
+	static constexpr auto rightParenthesis = TokenStub(TokenClass::Operator, ")");
+	static constexpr auto leftArraySubscript = TokenStub(TokenClass::Operator, "[");
+	static constexpr auto rightArraySubscript = TokenStub(TokenClass::Operator, "]");
+	static constexpr auto leftBracket = TokenStub(TokenClass::Operator, "{");
+	static constexpr auto rightBracket = TokenStub(TokenClass::Operator, "}");
+	static constexpr auto comma = TokenStub(TokenClass::Operator, ",");
+	static constexpr auto colon = TokenStub(TokenClass::Operator, ":");
+	static constexpr auto semicolon = TokenStub(TokenClass::Operator, ";");
+	static constexpr auto variableArgumentCountType = TokenStub(TokenClass::Operator, "...");
+	static constexpr auto assign = TokenStub(TokenClass::Operator, "<-");
+	static constexpr auto backInsert = TokenStub(TokenClass::Operator, "<<-");
 
 	// Arithmetic
-	static inline auto booleanNot = TokenStub(TokenClass::Operator, "!");
-	static inline auto binaryNot = TokenStub(TokenClass::Operator, "~");
-	static inline auto plus = TokenStub(TokenClass::Operator, "+");
-	static inline auto minus = TokenStub(TokenClass::Operator, "-");
-	static inline auto increment = TokenStub(TokenClass::Operator, "++");
-	static inline auto decrement = TokenStub(TokenClass::Operator, "--");
+	static constexpr auto booleanNot = TokenStub(TokenClass::Operator, "!");
+	static constexpr auto binaryNot = TokenStub(TokenClass::Operator, "~");
+	static constexpr auto plus = TokenStub(TokenClass::Operator, "+");
+	static constexpr auto minus = TokenStub(TokenClass::Operator, "-");
+	static constexpr auto increment = TokenStub(TokenClass::Operator, "++");
+	static constexpr auto decrement = TokenStub(TokenClass::Operator, "--");
 
-	static inline auto multiplication = TokenStub(TokenClass::Operator, "*");
-	static inline auto division = TokenStub(TokenClass::Operator, "/");
-	static inline auto modulo = TokenStub(TokenClass::Operator, "%");
+	static constexpr auto multiplication = TokenStub(TokenClass::Operator, "*");
+	static constexpr auto division = TokenStub(TokenClass::Operator, "/");
+	static constexpr auto modulo = TokenStub(TokenClass::Operator, "%");
 
 	// Binary
-	static inline auto shiftedToLeftBy = TokenStub(TokenClass::Operator, "<<");
-	static inline auto shiftedToRightBy = TokenStub(TokenClass::Operator, ">>");
-	static inline auto binaryOr = TokenStub(TokenClass::Operator, "|");
-	static inline auto binaryAnd = TokenStub(TokenClass::Operator, "&");
-	static inline auto binaryXor = TokenStub(TokenClass::Operator, "^");
+	static constexpr auto shiftedToLeftBy = TokenStub(TokenClass::Operator, "<<");
+	static constexpr auto shiftedToRightBy = TokenStub(TokenClass::Operator, ">>");
+	static constexpr auto binaryOr = TokenStub(TokenClass::Operator, "|");
+	static constexpr auto binaryAnd = TokenStub(TokenClass::Operator, "&");
+	static constexpr auto binaryXor = TokenStub(TokenClass::Operator, "^");
 
 	// Comparison
-	static inline auto equalTo = TokenStub(TokenClass::Operator, "=");
-	static inline auto differentFrom = TokenStub(TokenClass::Operator, "=/=");
-	static inline auto greaterThan = TokenStub(TokenClass::Operator, ">");
-	static inline auto lesserThan = TokenStub(TokenClass::Operator, "<");
-	static inline auto greaterThanOrEqualTo = TokenStub(TokenClass::Operator, ">_");
-	static inline auto lesserThanOrEqualTo = TokenStub(TokenClass::Operator, "_<");
-
-	static inline std::vector<TokenStub> allOperators = {
+	static constexpr auto equalTo = TokenStub(TokenClass::Operator, "=");
+	static constexpr auto differentFrom = TokenStub(TokenClass::Operator, "=/=");
+	static constexpr auto greaterThan = TokenStub(TokenClass::Operator, ">");
+	static constexpr auto lesserThan = TokenStub(TokenClass::Operator, "<");
+	static constexpr auto greaterThanOrEqualTo = TokenStub(TokenClass::Operator, ">_");
+	static constexpr auto lesserThanOrEqualTo = TokenStub(TokenClass::Operator, "_<");
+
+	static constexpr std::array allOperators = {
 		dot,
 		leftParenthesis,
 		rightParenthesis,
@@ -285,6 +539,108 @@ namespace Tokens {
 	};
 }
 
+// Longest-match recognizer for `Tokens::allOperators`, as a trie built at compile time
+// Operators are ASCII, any other byte ends the match
+class OperatorTrie {
+	static constexpr uint8_t noOperator = 0xFF;
+
+	struct Node {
+		// Zero when there is no such child, the root is never a child
+		std::array<uint8_t, 128> children;
+		// Index within `Tokens::allOperators` of the operator spelled up to this node
+		uint8_t operatorIndex;
+	};
+
+	static constexpr size_t maxNodeCount = [](){
+		size_t res = 1;
+		for (auto &op : Tokens::allOperators)
+			res += op.getString().size();
+		return res;
+	}();
+	static_assert(maxNodeCount <= 256 && Tokens::allOperators.size() < noOperator);
+
+	std::array<Node, maxNodeCount> m_nodes;
+	size_t m_nodeCount;
+
+public:
+	constexpr OperatorTrie(void) :
+		m_nodes(),
+		m_nodeCount(1) {
+		for (auto &node : m_nodes)
+			node.operatorIndex = noOperator;
+
+		for (size_t i = 0; i < Tokens::allOperators.size(); i++) {
+			size_t node = 0;
+			for (auto c : Tokens::allOperators[i].getString()) {
+				auto &child = m_nodes[node].children[static_cast<uint8_t>(c)];
+				if (child == 0)
+					child = m_nodeCount++;
+				node = child;
+			}
+			m_nodes[node].operatorIndex = i;
+		}
+	}
+
+	// Longest operator at the beginning of `bytes`, `nullptr` if there is none
+	constexpr const TokenStub* match(std::string_view bytes) const {
+		const TokenStub *res = nullptr;
+		size_t node = 0;
+		for (auto c : bytes) {
+			auto byte = static_cast<uint8_t>(c);
+			if (byte >= m_nodes[node].children.size())
+				break;
+			node = m_nodes[node].children[byte];
+			if (node == 0)
+				break;
+			if (m_nodes[node].operatorIndex != noOperator)
+				res = &Tokens::allOperators[m_nodes[node].operatorIndex];
+		}
+		return res;
+	}
+};
+
+namespace Tokens {
+	static constexpr auto operatorTrie = OperatorTrie();
+
+	// Reference longest match, the trie must agree with it on every operator followed by any other one
+	static constexpr bool doesOperatorTrieMatchLinearSearch(void) {
+		auto linearMatch = [](std::string_view bytes) {
+			const TokenStub *res = nullptr;
+			for (auto &op : allOperators)
+				if (bytes.starts_with(op.getString()) && (res == nullptr || op.getString().size() > res->getString().size()))
+					res = &op;
+			return res;
+		};
+		for (auto &first : allOperators)
+			for (auto &second : allOperators) {
+				char buffer[8] {};
+				auto firstString = first.getString();
+				auto secondString = second.getString();
+				std::copy(firstString.begin(), firstString.end(), buffer);
+				std::copy(secondString.begin(), secondString.end(), buffer + firstString.size());
+				auto bytes = std::string_view(buffer, firstString.size() + secondString.size());
+				if (operatorTrie.match(bytes) != linearMatch(bytes))
+					return false;
+			}
+		return true;
+	}
+	static_assert(doesOperatorTrieMatchLinearSearch());
+	static_assert(operatorTrie.match("<<- x")->getString() == backInsert.getString());
+	static_assert(operatorTrie.match("=/=")->getString() == differentFrom.getString());
+	static_assert(operatorTrie.match(">_")->getString() == greaterThanOrEqualTo.getString());
+	static_assert(operatorTrie.match("_<")->getString() == lesserThanOrEqualTo.getString());
+	static_assert(operatorTrie.match("_a") == nullptr);
+	static_assert(operatorTrie.match("..")->getString() == dot.getString());
+
+	// Index of `op` within `allOperators`, what operator tokens hold as payload
+	static constexpr uint32_t getOperatorIndex(const TokenStub &op) {
+		for (size_t i = 0; i < allOperators.size(); i++)
+			if (allOperators[i].getString() == op.getString())
+				return i;
+		throw std::logic_error("getOperatorIndex: not an operator");
+	}
+}
+
 namespace token {
 	void assertAtLeastOneToken(const std::vector<Token> &tokensToQuery) {
 		if (tokensToQuery.size() == 0)
@@ -294,9 +650,9 @@ namespace token {
 	const File& getFileCommonToAllTokens(const std::vector<Token> &tokensToQuery) {
 		assertAtLeastOneToken(tokensToQuery);
 
-		auto &res = tokensToQuery.begin()->getFileLocation().getPointedFile();
+		auto &res = tokensToQuery.begin()->getFile();
 		for (auto &token : tokensToQuery) {
-			auto &currentTokenFile = token.getFileLocation().getPointedFile();
+			auto &currentTokenFile = token.getFile();
 			if (&currentTokenFile != &res) {
 				std::stringstream ss;
 				ss << "getFileCommonToAllTokens: not all tokens in the same file, have the first in " << res.getPath() <<
@@ -337,7 +693,7 @@ namespace token {
 
 		const Token *res = &*tokensToQuery.begin();
 		for (auto &token : tokensToQuery) {
-			if (token.getFileLocation().getOffset() < res->getFileLocation().getOffset())
+			if (token.getOffset() < res->getOffset())
 				res = &token;
 		}
 		return *res;
@@ -348,7 +704,7 @@ namespace token {
 
 		const Token *res = &*tokensToQuery.begin();
 		for (auto &token : tokensToQuery) {
-			if (token.getFileLocation().getOffset() + token.getSizeInFile() > res->getFileLocation().getOffset() + res->getSizeInFile())
+			if (token.getOffset() + token.getSizeInFile() > res->getOffset() + res->getSizeInFile())
 				res = &token;
 		}
 		return *res;
@@ -356,7 +712,7 @@ namespace token {
 
 	bool isAnyTokenWithinOffset(const std::vector<Token> &candidateTokens, size_t offset) {
 		for (auto &token : candidateTokens) {
-			if (offset >= token.getFileLocation().getOffset() && offset < token.getFileLocation().getOffset() + token.getSizeInFile())
+			if (offset >= token.getOffset() && offset < token.getOffset() + token.getSizeInFile())
 				return true;
 		}
 		return false;
@@ -365,11 +721,10 @@ namespace token {
 	void printMessageAt(const FileLocation &referenceFileLocation, size_t beginOffset, size_t endOffset, const std::vector<Token> &tokensToHighlight, const std::string &messageToPrint) {
 		std::stringstream ss;
 		ss << referenceFileLocation.getPointedFile().getPath().string() << ":" << referenceFileLocation.getLine() << ":" << referenceFileLocation.getColumn() << ": " << messageToPrint << std::endl;
-		std::optional<FileLocation> printingLocation = FileLocation(referenceFileLocation.getPointedFile());
-		printingLocation->moveForwardMultiple(beginOffset);
-		while (printingLocation->getOffset() < endOffset) {
+		auto printingLocation = FileLocation(referenceFileLocation.getPointedFile(), beginOffset);
+		while (printingLocation.getOffset() < endOffset) {
 			{
-				auto linePrintingLocation = *printingLocation;
+				auto linePrintingLocation = printingLocation;
 				ss << linePrintingLocation.getLine() << "\t|\t";
 				while (linePrintingLocation.isBeforeEnd()) {
 					if (linePrintingLocation.getCurrentCharacter() == '\n') {
@@ -382,7 +737,7 @@ namespace token {
 				ss << std::endl;
 			}
 			{
-				auto linePrintingLocation = *printingLocation;
+				auto linePrintingLocation = printingLocation;
 				ss << "\t|\t";
 				while (linePrintingLocation.isBeforeEnd()) {
 					if (linePrintingLocation.getCurrentCharacter() == '\n') {
@@ -395,7 +750,7 @@ namespace token {
 					linePrintingLocation.moveForward();
 				}
 				ss << std::endl;
-				printingLocation.emplace(linePrintingLocation);
+				printingLocation = linePrintingLocation;
 			}
 		}
 		std::printf("%s", ss.str().c_str());
@@ -405,9 +760,9 @@ namespace token {
 		auto &file = getFileCommonToAllTokens(tokensToHighlight);
 
 		auto &firstToken = getFirstToken(tokensToHighlight);
-		auto firstTokenOffset = firstToken.getFileLocation().getOffset();
+		auto firstTokenOffset = firstToken.getOffset();
 		auto &lastToken = getLastToken(tokensToHighlight);
-		auto lastTokenOffset = lastToken.getFileLocation().getOffset() + lastToken.getSizeInFile();
+		auto lastTokenOffset = lastToken.getOffset() + lastToken.getSizeInFile();
 
 		auto firstLineBeginOffset = searchNearbyLine(file, firstTokenOffset, -1);
 		auto lastLineEndOffset = searchNearbyLine(file, lastTokenOffset, 1);
@@ -415,36 +770,39 @@ namespace token {
 	}
 }
 
-class TokenParser {
-	// WARNNING: will not skip over linefeeds!
-	static inline bool isWhitespace(char candidate) {
-		if (candidate == '\n')
-			return false;
-		else
-			return candidate <= ' ' || candidate >= 0x7F;
+// Lexing error, reported with a diagnostic pointing at `getToken()` by `TokenParser` entry points
+class TokenError : public std::runtime_error {
+	Token m_token;
+
+public:
+	TokenError(const Token &token, const std::string &message) :
+		std::runtime_error(message),
+		m_token(token) {
+	}
+
+	const Token& getToken(void) const {
+		return m_token;
 	}
+};
+
+class TokenParser {
+	friend class TokenCursor;
 
 	// Will have result index after the last whitespace from `offset` or at EOF
 	// WARNNING: will not skip over linefeeds!
 	static void skipWhitespace(FileLocation &currentLocation) {
-		while (currentLocation.isBeforeEnd() && isWhitespace(currentLocation.getCurrentCharacter())) {
-			currentLocation.moveForward();
-		}
+		auto bytes = currentLocation.getPointedFile().getBytes();
+		currentLocation.moveForwardTo(scan::skipWhitespace(bytes, currentLocation.getOffset()));
 	}
 
 	// Will have result index after the next linefeed or at EOF
 	static void skipLine(FileLocation &currentLocation) {
-		while (currentLocation.isBeforeEnd()) {
-			if (currentLocation.getCurrentCharacter() == '\n') {
-				currentLocation.moveForward();
-				return;
-			}
-
-			currentLocation.moveForward();
-		}
+		auto bytes = currentLocation.getPointedFile().getBytes();
+		auto linefeedOffset = scan::findByte(bytes, currentLocation.getOffset(), '\n');
+		currentLocation.moveForwardTo(std::min(linefeedOffset + 1, bytes.size()));
 	}
 
-	static bool doesFileContainStringAt(FileLocation &currentLocation, const std::string &toFind) {
+	static bool doesFileContainStringAt(FileLocation &currentLocation, std::string_view toFind) {
 		if (currentLocation.readableCharacterCount() < toFind.size())
 			return false;
 
@@ -454,29 +812,28 @@ class TokenParser {
 		return true;
 	}
 
-	static inline std::string singleLineComment = "//";
-	static inline std::string multiLineCommentBegin = "/*";
-	static inline std::string multiLineCommentEnd = "*/";
+	static constexpr std::string_view singleLineComment = "//";
+	static constexpr std::string_view multiLineCommentBegin = "/*";
+	static constexpr std::string_view multiLineCommentEnd = "*/";
 
 	static void skipComment(FileLocation &currentLocation) {
 		if (doesFileContainStringAt(currentLocation, singleLineComment)) {
 			skipLine(currentLocation);
 			return;
 		} else if (doesFileContainStringAt(currentLocation, multiLineCommentBegin)) {
-			while (currentLocation.isBeforeEnd()) {
-				if (doesFileContainStringAt(currentLocation, multiLineCommentEnd)) {
-					currentLocation.moveForwardMultiple(multiLineCommentEnd.size());
-					return;
-				} else {
-					currentLocation.moveForward();
-				}
-			}
+			auto bytes = currentLocation.getPointedFile().getBytes();
+			// The end may overlap the beginning, `/*/` is a whole comment
+			auto endOffset = scan::activeKernels->findCommentEnd(bytes.data(), bytes.size(), currentLocation.getOffset() + 1);
+			currentLocation.moveForwardTo(std::min(endOffset + multiLineCommentEnd.size(), bytes.size()));
 		}
 	}
 
 	static void getNextTokenOffsetFrom(FileLocation &currentLocation) {
 		while (currentLocation.isBeforeEnd()) {
 			skipWhitespace(currentLocation);
+			// Every comment begins with a slash
+			if (!currentLocation.isBeforeEnd() || currentLocation.getCurrentCharacter() != '/')
+				break;
 			auto preCommentOffset = currentLocation.getOffset();
 			skipComment(currentLocation);
 			// If no comment has been detected, we got our next token right there
@@ -489,123 +846,395 @@ class TokenParser {
 		auto delimiter = currentLocation.getCurrentCharacter();
 		// Make a copy of the location of the beginning of the string
 		auto beginLocation = currentLocation;
+		auto bytes = currentLocation.getPointedFile().getBytes();
 		// Skip opening delimiter
-		currentLocation.moveForward();
+		auto endOffset = scan::findByte(bytes, beginLocation.getOffset() + 1, delimiter);
+		auto sizeInFile = endOffset - beginLocation.getOffset() + 1;
+		if (endOffset == bytes.size())
+			throw TokenError(Token(beginLocation, TokenClass::StringLiteral, sizeInFile), "unterminated string");
+		currentLocation.moveForwardTo(endOffset + 1);
+		return Token(beginLocation, TokenClass::StringLiteral, sizeInFile);
+	}
 
-		std::string string;
-		while (true) {
-			if (!currentLocation.isBeforeEnd()) {
-				token::printMessage({Token(beginLocation, TokenClass::StringLiteral, string)}, "unterminated string");
-				throw std::runtime_error("Token parsing failed");
-			}
-			if (currentLocation.getCurrentCharacter() == delimiter) {
-				currentLocation.moveForward();
-				return Token(beginLocation, TokenClass::StringLiteral, string);
-			} else {
-				string.push_back(currentLocation.getCurrentCharacter());
-			}
+	// A `*` directly followed by a digit starts a little-endian literal, unless it directly follows an operand:
+	// `a*2` and `a * 2` multiply while `a *2` and `(*2)` hold the literal `*2`
+	static bool isLittleEndianNumberAt(const FileLocation &currentLocation) {
+		if (currentLocation.readableCharacterCount() < 2 || !scan::isDigit(currentLocation.getNextCharacter(1)))
+			return false;
+		auto offset = currentLocation.getOffset();
+		if (offset == 0)
+			return true;
+		auto previousChar = currentLocation.getPointedFile().getBytes()[offset - 1];
+		return !scan::isIdentifierCharacter(previousChar) && previousChar != ')' && previousChar != ']' &&
+			previousChar != '"' && previousChar != '\'';
+	}
+
+	// The value is parsed right away into `numbers`, the token payload is its reference there
+	// Forcibly inlined like `getTokenAt`, out of line every token would go through a stack copy where the paths join
+	[[gnu::always_inline]] static Token pollNumber(FileLocation &currentLocation, NumberTable &numbers) {
+		auto beginLocation = currentLocation;
+		auto literal = number::scan(currentLocation.getPointedFile().getBytes(), currentLocation.getOffset());
+		currentLocation.moveForwardTo(literal.endOffset);
+		auto res = Token(beginLocation, TokenClass::NumberLiteral, literal.endOffset - beginLocation.getOffset());
+		if (!literal.value.has_value())
+			throw TokenError(res, literal.error);
+		res.setPayload(numbers.add(*literal.value));
+		return res;
+	}
+
+	static Token pollCharSequence(FileLocation &currentLocation) {
+		auto beginLocation = currentLocation;
+		auto bytes = currentLocation.getPointedFile().getBytes();
+		currentLocation.moveForwardMultiple(scan::skipIdentifier(bytes, currentLocation.getOffset()) - currentLocation.getOffset());
+		return Token(beginLocation, TokenClass::Identifier, currentLocation.getOffset() - beginLocation.getOffset());
+	}
+
+	// `std::nullopt` if no operator begins here
+	static std::optional<Token> pollOperator(FileLocation &currentLocation) {
+		auto bestOperator = Tokens::operatorTrie.match(currentLocation.getReadableBytes());
+		if (bestOperator == nullptr)
+			return std::nullopt;
+		auto res = Token(currentLocation, *bestOperator);
+		res.setPayload(bestOperator - Tokens::allOperators.data());
+		currentLocation.moveForwardMultiple(bestOperator->getString().size());
+		return res;
+	}
+
+	// Dispatched on the class of the first byte, a zero-size token means an illegal character
+	// Forcibly inlined into `readNextToken`: as a call, the token is returned through memory, which costs a third of the lexing speed
+	[[gnu::always_inline]] static Token getTokenAt(FileLocation &currentLocation, NumberTable &numbers) {
+		switch (scan::getCharacterClass(currentLocation.getCurrentCharacter())) {
+		case scan::CharacterClass::Linefeed: {
+			auto res = Token(currentLocation, Tokens::linefeed);
 			currentLocation.moveForward();
+			return res;
 		}
+		case scan::CharacterClass::Quote:
+			return pollString(currentLocation);
+		case scan::CharacterClass::Digit:
+			return pollNumber(currentLocation, numbers);
+		case scan::CharacterClass::Letter:
+			// No operator begins with a letter
+			return pollCharSequence(currentLocation);
+		case scan::CharacterClass::Star:
+			if (isLittleEndianNumberAt(currentLocation))
+				return pollNumber(currentLocation, numbers);
+			[[fallthrough]];
+		case scan::CharacterClass::Punctuation:
+		case scan::CharacterClass::Underscore:
+			if (auto res = pollOperator(currentLocation))
+				return *res;
+			return pollCharSequence(currentLocation);
+		case scan::CharacterClass::Whitespace:
+			break;
+		}
+		// Whitespace is skipped before getting here
+		return Token(currentLocation, TokenClass::Identifier, 0);
 	}
 
-	static char toLower(char toProcess) {
-		if (toProcess >= 'A' && toProcess <= 'Z')
-			return toProcess + 32;
-		else
-			return toProcess;
+	// Skips to the next token and reads it, `std::nullopt` at end of file
+	static std::optional<Token> readNextToken(FileLocation &currentLocation, NumberTable &numbers) {
+		getNextTokenOffsetFrom(currentLocation);
+		if (!currentLocation.isBeforeEnd())
+			return std::nullopt;
+
+		auto token = getTokenAt(currentLocation, numbers);
+		if (token.getSizeInFile() == 0)
+			throw TokenError(Token(token.getFile(), token.getClass(), token.getOffset(), 1), "illegal character");
+		return token;
 	}
 
-	static bool isCharDigit(char candidate) {
-		return candidate >= '0' && candidate <= '9';
+	static void internSymbol(Token &token, SymbolTable &symbols) {
+		if (token.getClass() == TokenClass::Identifier)
+			token.setPayload(symbols.intern(token.getString()));
 	}
 
-	static bool isCharAlphanum(char candidate) {
-		candidate = toLower(candidate);
-		return (candidate >= 'a' && candidate <= 'z') || isCharDigit(candidate);
+	static void assertAddressable(const File &sourceFile) {
+		if (sourceFile.getByteCount() > std::numeric_limits<uint32_t>::max()) {
+			std::stringstream ss;
+			ss << "readTokens: " << sourceFile.getPath() << " is larger than 4 GiB";
+			throw std::runtime_error(ss.str());
+		}
 	}
 
-	static Token pollCharSequence(FileLocation &currentLocation) {
-		auto beginLocation = currentLocation;
-		auto firstChar = currentLocation.getCurrentCharacter();
-		auto isDigit = isCharDigit(firstChar);
-		std::string sequence;
+	// Tokens lexed from a linefeed boundary, guessing that no comment nor string literal is open there
+	// Identifiers are interned later while stitching, `SymbolTable` is not shared among threads
+	// Numeric literal payloads index the chunk's own `numbers`, and are moved to the shared table while stitching
+	struct Chunk {
+		size_t beginOffset;
+		size_t endOffset;
+		TokenStream tokens;
+		NumberTable numbers;
+		// Set if lexing stopped on an error, which may only come from a wrong guess
+		bool hasFailed;
+		// Where lexing stopped: past `endOffset` when the last token or comment crosses it,
+		// or right after the last token when `hasFailed`
+		size_t stopOffset;
+		// Any other failure of the worker, such as `std::bad_alloc`, rethrown once the workers are joined
+		std::exception_ptr exception;
+
+		Chunk(const File &sourceFile, size_t argBeginOffset, size_t argEndOffset) :
+			beginOffset(argBeginOffset),
+			endOffset(argEndOffset),
+			tokens(sourceFile),
+			hasFailed(false),
+			stopOffset(argBeginOffset) {
+		}
 
-		while (currentLocation.isBeforeEnd() && (isCharAlphanum(currentLocation.getCurrentCharacter()) || currentLocation.getCurrentCharacter() == '_')) {
-			sequence.push_back(currentLocation.getCurrentCharacter());
-			currentLocation.moveForward();
+		void lex(void) {
+			auto currentLocation = FileLocation(tokens.getFile(), beginOffset);
+			try {
+				while (currentLocation.getOffset() < endOffset) {
+					auto token = readNextToken(currentLocation, numbers);
+					if (token.has_value())
+						tokens.push(*token);
+					stopOffset = currentLocation.getOffset();
+				}
+			} catch (const TokenError&) {
+				hasFailed = true;
+			} catch (...) {
+				exception = std::current_exception();
+			}
 		}
-		return Token(beginLocation, isDigit ? TokenClass::Digits : TokenClass::Identifier, sequence);
-	}
 
-	static Token getTokenAt(FileLocation &currentLocation) {
-		auto firstChar = currentLocation.getCurrentCharacter();
-		// Linefeed
-		{
-			if (firstChar == '\n') {
-				auto res = Token(currentLocation, Tokens::linefeed);
-				currentLocation.moveForward();
-				return res;
+		// Index of the first token to keep if lexing actually resumes at `offset`,
+		// `std::nullopt` if the guess never went through that offset
+		std::optional<size_t> findResumingTokenIndex(size_t offset) const {
+			if (offset == beginOffset)
+				return 0;
+			size_t low = 0;
+			size_t high = tokens.size();
+			while (low < high) {
+				auto middle = (low + high) / 2;
+				if (tokens.getOffset(middle) + tokens.getSizeInFile(middle) < offset)
+					low = middle + 1;
+				else
+					high = middle;
 			}
+			if (low < tokens.size() && tokens.getOffset(low) + tokens.getSizeInFile(low) == offset)
+				return low + 1;
+			return std::nullopt;
 		}
+	};
 
-		// String literal
-		{
-			if (firstChar == '\'' || firstChar == '"')
-				return pollString(currentLocation);
+	static std::vector<Chunk> splitIntoChunks(const File &sourceFile, size_t chunkSize) {
+		auto bytes = sourceFile.getBytes();
+		std::vector<Chunk> res;
+		size_t beginOffset = 0;
+		while (beginOffset < bytes.size()) {
+			auto endOffset = bytes.size();
+			if (bytes.size() - beginOffset > chunkSize)
+				endOffset = std::min(scan::findByte(bytes, beginOffset + chunkSize, '\n') + 1, bytes.size());
+			res.emplace_back(sourceFile, beginOffset, endOffset);
+			beginOffset = endOffset;
 		}
+		return res;
+	}
 
-		// Operators
-		{
-			struct Best {
-				size_t length;
-				TokenStub token;
-			};
-			std::optional<Best> bestOperator;
-
-			for (auto &op : Tokens::allOperators) {
-				if (!doesFileContainStringAt(currentLocation, op.getString()))
-					continue;
+	// Walks speculatively lexed chunks in order, relexing sequentially wherever the guess was wrong
+	// Errors are raised from here, so that the first one in the file is reported
+	static TokenStream stitchChunks(const File &sourceFile, SymbolTable &symbols, NumberTable &numbers, const std::vector<Chunk> &chunks) {
+		auto res = TokenStream(sourceFile);
+		size_t tokenCount = 0;
+		for (auto &chunk : chunks)
+			tokenCount += chunk.tokens.size();
+		res.reserve(tokenCount);
+
+		size_t offset = 0;
+		for (auto &chunk : chunks) {
+			bool isSpliced = false;
+			while (offset < chunk.endOffset) {
+				if (!isSpliced) {
+					auto firstIndex = chunk.findResumingTokenIndex(offset);
+					if (firstIndex.has_value()) {
+						auto appendedIndex = res.size();
+						res.append(chunk.tokens, *firstIndex);
+						for (; appendedIndex < res.size(); appendedIndex++) {
+							if (res.getClass(appendedIndex) == TokenClass::Identifier)
+								res.setPayload(appendedIndex, symbols.intern(sourceFile.getBytes().substr(res.getOffset(appendedIndex), res.getSizeInFile(appendedIndex))));
+							else if (res.getClass(appendedIndex) == TokenClass::NumberLiteral)
+								res.setPayload(appendedIndex, numbers.add(chunk.numbers[res.getPayload(appendedIndex)]));
+						}
+						offset = chunk.stopOffset;
+						isSpliced = true;
+						continue;
+					}
+				}
 
-				auto currentOpLength = op.getString().size();
-				if (!bestOperator.has_value() || currentOpLength > bestOperator->length) {
-					bestOperator = Best{
-						.length = currentOpLength,
-						.token = op
-					};
+				auto currentLocation = FileLocation(sourceFile, offset);
+				auto token = readNextToken(currentLocation, numbers);
+				if (token.has_value()) {
+					internSymbol(*token, symbols);
+					res.push(*token);
 				}
-			}
-			if (bestOperator.has_value()) {
-				auto res = Token(currentLocation, bestOperator->token);
-				currentLocation.moveForwardMultiple(bestOperator->length);
-				return res;
+				offset = currentLocation.getOffset();
 			}
 		}
+		return res;
+	}
+
+	template <typename Lexer>
+	static auto reportTokenErrors(Lexer &&lexer) {
+		try {
+			return lexer();
+		} catch (const TokenError &error) {
+			token::printMessage({error.getToken()}, error.what());
+			throw std::runtime_error("Token parsing failed");
+		}
+	}
+
+public:
+	// Sources at least this large are lexed in parallel by `readTokens`
+	static constexpr size_t parallelByteCountThreshold = 16 << 20;
+
+	// Identifiers are interned into `symbols`, their token payload is their symbol
+	// Numeric literal values are added to `numbers`, their token payload is their reference there
+	static TokenStream readTokens(const File &sourceFile, SymbolTable &symbols, NumberTable &numbers) {
+		auto threadCount = std::thread::hardware_concurrency();
+		if (sourceFile.getByteCount() >= parallelByteCountThreshold && threadCount > 1)
+			return readTokensParallel(sourceFile, symbols, numbers, threadCount, sourceFile.getByteCount() / (threadCount * 4));
+		else
+			return readTokensSequential(sourceFile, symbols, numbers);
+	}
 
-		// Fallback to char sequence
+	static TokenStream readTokensSequential(const File &sourceFile, SymbolTable &symbols, NumberTable &numbers) {
+		assertAddressable(sourceFile);
+		return reportTokenErrors([&](){
+			auto currentLocation = FileLocation(sourceFile);
+			auto res = TokenStream(sourceFile);
+			while (auto token = readNextToken(currentLocation, numbers)) {
+				internSymbol(*token, symbols);
+				res.push(*token);
+			}
+			return res;
+		});
+	}
+
+	// Splits the source on linefeeds about every `chunkSize` bytes and lexes chunks on `threadCount` threads
+	// Chunks starting within a multi-line comment or string literal are relexed while stitching:
+	// the result is the same as sequential lexing, errors included
+	static TokenStream readTokensParallel(const File &sourceFile, SymbolTable &symbols, NumberTable &numbers, size_t threadCount, size_t chunkSize) {
+		assertAddressable(sourceFile);
+		auto chunks = splitIntoChunks(sourceFile, std::max<size_t>(chunkSize, 1));
 		{
-			return pollCharSequence(currentLocation);
+			std::atomic<size_t> nextChunkIndex = 0;
+			std::vector<std::jthread> workers;
+			for (size_t i = 0; i < std::min(threadCount, chunks.size()); i++)
+				workers.emplace_back([&](){
+					for (size_t chunkIndex; (chunkIndex = nextChunkIndex++) < chunks.size();)
+						chunks[chunkIndex].lex();
+				});
 		}
+		for (auto &chunk : chunks)
+			if (chunk.exception)
+				std::rethrow_exception(chunk.exception);
+		return reportTokenErrors([&](){
+			return stitchChunks(sourceFile, symbols, numbers, chunks);
+		});
 	}
+};
 
+// Pulls tokens one at a time from a source file, reading at most `maxLookahead` tokens ahead
+// Consumed tokens are not kept, so memory use does not grow with the size of the source
+class TokenCursor {
 public:
-	static std::vector<Token> readTokens(const File &sourceFile) {
-		auto currentLocation = FileLocation(sourceFile);
-		std::vector<Token> res;
+	static constexpr size_t maxLookahead = 4;
 
-		while (currentLocation.isBeforeEnd()) {
-			getNextTokenOffsetFrom(currentLocation);
-			if (currentLocation.isBeforeEnd()) {
-				auto token = getTokenAt(currentLocation);
-
-				if (token.getSizeInFile() == 0) {
-					std::stringstream ss;
-					ss << token.getFileLocation().getCurrentCharacter();
-					token::printMessage({Token(token.getFileLocation(), token.getClass(), ss.str())}, "illegal character");
-					throw std::runtime_error("Token parsing failed");
-				}
-				res.emplace_back(std::move(token));
+	// Consumes tokens as it goes
+	class Iterator {
+		TokenCursor *m_cursor;
+		std::optional<Token> m_current;
+
+	public:
+		Iterator(TokenCursor &cursor) :
+			m_cursor(&cursor),
+			m_current(cursor.next()) {
+		}
+
+		Token operator*(void) const {
+			return *m_current;
+		}
+		Iterator& operator++(void) {
+			m_current = m_cursor->next();
+			return *this;
+		}
+		bool operator==(std::default_sentinel_t) const {
+			return !m_current.has_value();
+		}
+	};
+
+private:
+	FileLocation m_currentLocation;
+	SymbolTable *m_symbols;
+	NumberTable *m_numbers;
+	// Ring buffer of tokens read but not consumed yet
+	std::array<std::optional<Token>, maxLookahead> m_lookahead;
+	size_t m_lookaheadBegin;
+	size_t m_lookaheadSize;
+	bool m_isFileExhausted;
+
+	// Reads tokens until `tokenCount` are available or the end of the file is reached
+	void fill(size_t tokenCount) {
+		while (m_lookaheadSize < tokenCount && !m_isFileExhausted) {
+			auto token = TokenParser::reportTokenErrors([&](){
+				return TokenParser::readNextToken(m_currentLocation, *m_numbers);
+			});
+			if (!token.has_value()) {
+				m_isFileExhausted = true;
+				break;
 			}
+			TokenParser::internSymbol(*token, *m_symbols);
+			m_lookahead[(m_lookaheadBegin + m_lookaheadSize) % maxLookahead] = token;
+			m_lookaheadSize++;
+		}
+	}
+
+public:
+	TokenCursor(const File &sourceFile, SymbolTable &symbols, NumberTable &numbers) :
+		m_currentLocation(sourceFile),
+		m_symbols(&symbols),
+		m_numbers(&numbers),
+		m_lookaheadBegin(0),
+		m_lookaheadSize(0),
+		m_isFileExhausted(false) {
+		TokenParser::assertAddressable(sourceFile);
+	}
+
+	const File& getFile(void) const {
+		return m_currentLocation.getPointedFile();
+	}
+
+	// Token `distance` positions ahead without consuming it, `std::nullopt` past the end of the file
+	std::optional<Token> peek(size_t distance = 0) {
+		if (distance >= maxLookahead) {
+			std::stringstream ss;
+			ss << "TokenCursor::peek: lookahead of " << distance << " is past the limit of " << maxLookahead - 1;
+			throw std::runtime_error(ss.str());
+		}
+		fill(distance + 1);
+		if (distance >= m_lookaheadSize)
+			return std::nullopt;
+		return m_lookahead[(m_lookaheadBegin + distance) % maxLookahead];
+	}
+
+	// Consumes the next token, `std::nullopt` past the end of the file
+	std::optional<Token> next(void) {
+		auto res = peek();
+		if (res.has_value()) {
+			m_lookaheadBegin = (m_lookaheadBegin + 1) % maxLookahead;
+			m_lookaheadSize--;
 		}
 		return res;
 	}
+
+	bool isAtEnd(void) {
+		return !peek().has_value();
+	}
+
+	Iterator begin(void) {
+		return Iterator(*this);
+	}
+	std::default_sentinel_t end(void) const {
+		return std::default_sentinel;
+	}
 };
\ No newline at end of file